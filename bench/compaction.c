@@ -0,0 +1,158 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <time.h>
+
+#include "runtime/memory_manager.h"
+#include "runtime/types.h"
+
+// Compaction benchmark. Builds many lists a cons at a time, round robin, with
+// short-lived strings in between, so that each list is scattered across the
+// heap. Then every other list is dropped, leaving the heap full of holes.
+// Walks the survivors after a regular full collection and again after a
+// compacting one, and compares the heap size, the walk time, and the pause.
+// Every sixteenth list is marked with mark_used, so it is pinned and shows
+// compaction working around chunks that can't move.
+
+#define LIST_COUNT 4096
+#define LIST_LENGTH 512
+#define PINNED_EVERY 16
+#define WALKS 10
+
+static MemoryManager *manager;
+static LishpForm roots[LIST_COUNT];
+static LishpCons *tails[LIST_COUNT];
+
+static void trace_cons(struct runtime *rt, void *ptr) {
+  (void)rt;
+
+  LishpCons *cons = ptr;
+  if (OBJECT_P(cons->cdr)) {
+    mark_slot(manager, (void **)&cons->cdr.object, trace_cons);
+  }
+  if (OBJECT_P(cons->car)) {
+    mark_slot(manager, (void **)&cons->car.object, trace_cons);
+  }
+}
+
+static void mark_roots(struct runtime *rt) {
+  (void)rt;
+
+  for (uint32_t ind = 0; ind < LIST_COUNT; ++ind) {
+    if (!OBJECT_P(roots[ind])) {
+      continue;
+    }
+
+    if (ind % PINNED_EVERY == 0) {
+      mark_used(manager, roots[ind].object, trace_cons);
+    } else {
+      mark_slot(manager, (void **)&roots[ind].object, trace_cons);
+    }
+  }
+}
+
+static double seconds_since(struct timespec *start) {
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  return (double)(end.tv_sec - start->tv_sec) +
+         (double)(end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// sums every element of every list, so that a list that came out of a
+// compaction mangled shows up as the wrong total
+static uint64_t walk_lists(double *elapsed) {
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  uint64_t sum = 0;
+  for (uint32_t walk = 0; walk < WALKS; ++walk) {
+    for (uint32_t ind = 0; ind < LIST_COUNT; ++ind) {
+      LishpForm cur = roots[ind];
+      while (OBJECT_P(cur)) {
+        LishpCons *cons = AS_OBJECT(LishpCons, cur);
+        sum += AS_FIXNUM(cons->car);
+        cur = cons->cdr;
+      }
+    }
+  }
+
+  *elapsed = seconds_since(&start);
+  return sum;
+}
+
+static void report(const char *label, uint64_t sum, double elapsed,
+                   double pause) {
+  printf("compaction: %-10s heap %4luM, walks %.3fs, collection %.3fms, "
+         "sum %lu\n",
+         label, (unsigned long)(inspect_heap_size(manager) >> 20), elapsed,
+         pause * 1e3, (unsigned long)sum);
+}
+
+int main() {
+  ManagerSettings settings = DEFAULT_MANAGER_SETTINGS;
+  settings.compact = 1;
+
+  if (initialize_manager(&manager, mark_roots, NULL, settings) < 0) {
+    return 1;
+  }
+
+  for (uint32_t ind = 0; ind < LIST_COUNT; ++ind) {
+    roots[ind] = NIL;
+    tails[ind] = NULL;
+  }
+
+  for (uint32_t elem = 0; elem < LIST_LENGTH; ++elem) {
+    for (uint32_t ind = 0; ind < LIST_COUNT; ++ind) {
+      // the garbage goes first, since allocating it could collect a cons
+      // that isn't linked in yet
+      char *garbage = allocate(manager, 1 + (elem + ind) % 48);
+      LishpCons *cons = allocate(manager, sizeof(LishpCons));
+      if (cons == NULL || garbage == NULL) {
+        fprintf(stderr, "Allocation failed\n");
+        return 1;
+      }
+
+      // appending to the tail is a store into an older cons
+      *cons = CONS(FROM_FIXNUM(elem), NIL);
+      if (tails[ind] == NULL) {
+        roots[ind] = FROM_OBJ(cons);
+      } else {
+        tails[ind]->cdr = FROM_OBJ(cons);
+        write_barrier(manager, tails[ind], cons, trace_cons);
+      }
+      tails[ind] = cons;
+    }
+  }
+
+  for (uint32_t ind = 1; ind < LIST_COUNT; ind += 2) {
+    roots[ind] = NIL;
+  }
+  for (uint32_t ind = 0; ind < LIST_COUNT; ++ind) {
+    tails[ind] = NULL;
+  }
+
+  struct timespec start;
+  double elapsed;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  collect_garbage(manager);
+  double pause = seconds_since(&start);
+  uint64_t before = walk_lists(&elapsed);
+  report("collected", before, elapsed, pause);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  compact_garbage(manager);
+  pause = seconds_since(&start);
+  uint64_t after = walk_lists(&elapsed);
+  report("compacted", after, elapsed, pause);
+
+  if (before != after) {
+    fprintf(stderr, "Lists changed by compaction!\n");
+    return 1;
+  }
+
+  cleanup_manager(&manager, NULL);
+
+  return 0;
+}
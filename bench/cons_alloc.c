@@ -0,0 +1,97 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <time.h>
+
+#include "runtime/memory_manager.h"
+#include "runtime/types.h"
+
+// Allocation microbenchmark for the memory manager. Allocates millions of
+// conses, with symbols and strings of varying sizes mixed in, while a sliding
+// window of the most recent allocations stays live across collections. Only
+// the manager API is used, so the same file can be run against older
+// allocators for comparison.
+
+#define CONS_COUNT 5000000
+#define LIVE_WINDOW 4096
+#define MIXED_EVERY 8
+
+static MemoryManager *manager;
+static void *live[LIVE_WINDOW];
+
+static void mark_live(struct runtime *rt) {
+  (void)rt;
+
+  for (uint32_t ind = 0; ind < LIVE_WINDOW; ++ind) {
+    if (live[ind] != NULL) {
+      // nothing in the window is traced, it is all kept alive directly
+      mark_used(manager, live[ind], NULL);
+    }
+  }
+}
+
+static double seconds_since(struct timespec *start) {
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  return (double)(end.tv_sec - start->tv_sec) +
+         (double)(end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int main() {
+  if (initialize_manager(&manager, mark_live, NULL, DEFAULT_MANAGER_SETTINGS) <
+      0) {
+    return 1;
+  }
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  uint32_t window_ind = 0;
+  uint32_t allocations = 0;
+  LishpForm prev = NIL;
+
+  for (uint32_t cons_ind = 0; cons_ind < CONS_COUNT; ++cons_ind) {
+    LishpCons *cons = allocate(manager, sizeof(LishpCons));
+    if (cons == NULL) {
+      fprintf(stderr, "Allocation failed after %u conses\n", cons_ind);
+      return 1;
+    }
+    *cons = CONS(FROM_FIXNUM(cons_ind), prev);
+    prev = FROM_OBJ(cons);
+
+    live[window_ind] = cons;
+    window_ind = (window_ind + 1) % LIVE_WINDOW;
+    ++allocations;
+
+    if (cons_ind % MIXED_EVERY == 0) {
+      // a short-lived string between 1 and 64 bytes and a symbol, so the free
+      // space isn't all the same size
+      uint32_t len = 1 + (cons_ind / MIXED_EVERY) % 64;
+      char *str = allocate(manager, len);
+      LishpSymbol *sym = allocate(manager, sizeof(LishpSymbol));
+      if (str == NULL || sym == NULL) {
+        fprintf(stderr, "Allocation failed after %u conses\n", cons_ind);
+        return 1;
+      }
+
+      live[window_ind] = sym;
+      window_ind = (window_ind + 1) % LIVE_WINDOW;
+      allocations += 2;
+    }
+
+    if (cons_ind % 64 == 0) {
+      // start a new list, so that conses don't keep each other alive
+      prev = NIL;
+    }
+  }
+
+  double elapsed = seconds_since(&start);
+
+  printf("cons_alloc: %u allocations (%u conses) in %.3fs, %.1f ns/alloc\n",
+         allocations, CONS_COUNT, elapsed, 1e9 * elapsed / allocations);
+
+  cleanup_manager(&manager, NULL);
+
+  return 0;
+}
@@ -0,0 +1,227 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "util.h"
+
+// Container benchmark. Fills an OrderedMap, a HashMap and a map made by
+// DEFINE_HASH_MAP with the same pointer-like keys, at a few sizes from what a
+// small environment holds to what a package with every built-in interned
+// holds, and times inserts, hits and misses in each. The ordered map gets its
+// keys in descending order, so every insert has to shift everything after it
+// up. Every value found is checked against what was put in. Then times
+// pushing and popping a List against a list made by DEFINE_LIST, the way the
+// interpreter uses its form stack.
+
+#define MAX_KEYS 8192
+#define LOOKUPS 1000000
+#define STACK_ROUNDS 1000
+#define STACK_DEPTH 1000
+
+#define KEY_EQ(l, r) ((l) == (r))
+
+DEFINE_HASH_MAP(KeyMap, key_map, uint64_t, uint32_t, hash_word, KEY_EQ)
+DEFINE_LIST(WordList, word_list, uint64_t)
+
+static uint64_t keys[MAX_KEYS];
+
+static double seconds_since(struct timespec *start) {
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  return (double)(end.tv_sec - start->tv_sec) +
+         (double)(end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static int key_cmp(void *l, void *r) {
+  uint64_t *l_key = l;
+  uint64_t *r_key = r;
+
+  return *l_key < *r_key ? -1 : *l_key > *r_key ? 1 : 0;
+}
+
+static uint32_t key_hash(void *key) { return hash_word(*(uint64_t *)key); }
+
+// the two maps take the same arguments, so each step goes through whichever
+// this says
+typedef struct {
+  const char *name;
+  void *map;
+  int (*insert)(void *m, uint32_t key_size, uint32_t val_size, void *key,
+                void *value);
+  int (*get)(void *m, uint32_t key_size, uint32_t val_size, void *key,
+             void *value);
+} MapCalls;
+
+static int ordered_insert(void *m, uint32_t key_size, uint32_t val_size,
+                          void *key, void *value) {
+  return map_insert(m, key_size, val_size, key, value);
+}
+
+static int ordered_get(void *m, uint32_t key_size, uint32_t val_size,
+                       void *key, void *value) {
+  return map_get(m, key_size, val_size, key, value);
+}
+
+static int hashed_insert(void *m, uint32_t key_size, uint32_t val_size,
+                         void *key, void *value) {
+  return hash_map_insert(m, key_size, val_size, key, value);
+}
+
+static int hashed_get(void *m, uint32_t key_size, uint32_t val_size,
+                      void *key, void *value) {
+  return hash_map_get(m, key_size, val_size, key, value);
+}
+
+static int typed_insert(void *m, uint32_t key_size, uint32_t val_size,
+                        void *key, void *value) {
+  (void)key_size;
+  (void)val_size;
+  return key_map_insert(m, *(uint64_t *)key, *(uint32_t *)value);
+}
+
+static int typed_get(void *m, uint32_t key_size, uint32_t val_size, void *key,
+                     void *value) {
+  (void)key_size;
+  (void)val_size;
+  return key_map_get(m, *(uint64_t *)key, value);
+}
+
+static int run(MapCalls *calls, uint32_t count) {
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (uint32_t ind = count; ind > 0; --ind) {
+    uint32_t value = ind - 1;
+    calls->insert(calls->map, sizeof(uint64_t), sizeof(uint32_t),
+                  &keys[ind - 1], &value);
+  }
+  double insert_time = seconds_since(&start) / count;
+
+  uint32_t seed = 1;
+  uint64_t checksum = 0;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (uint32_t ind = 0; ind < LOOKUPS; ++ind) {
+    seed = seed * 1103515245 + 12345;
+    uint32_t index = (seed >> 4) % count;
+
+    uint32_t value;
+    if (calls->get(calls->map, sizeof(uint64_t), sizeof(uint32_t),
+                   &keys[index], &value) < 0 ||
+        value != index) {
+      printf("containers: %s lost key %u\n", calls->name, index);
+      return -1;
+    }
+    checksum += value;
+  }
+  double hit_time = seconds_since(&start) / LOOKUPS;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (uint32_t ind = 0; ind < LOOKUPS; ++ind) {
+    // keys are all multiples of 16, like pointers to objects
+    uint64_t missing = keys[ind % count] + 8;
+    uint32_t value;
+    checksum += calls->get(calls->map, sizeof(uint64_t), sizeof(uint32_t),
+                           &missing, &value);
+  }
+  double miss_time = seconds_since(&start) / LOOKUPS;
+
+  printf("containers: %-11s %5u keys, insert %7.1fns, hit %6.1fns, "
+         "miss %6.1fns (checksum %lu)\n",
+         calls->name, count, insert_time * 1e9, hit_time * 1e9,
+         miss_time * 1e9, (unsigned long)checksum);
+  return 0;
+}
+
+// pushes a stack up and pops it back down, summing what comes off
+static void run_stacks() {
+  List list;
+  list_init(&list);
+  WordList typed;
+  word_list_init(&typed);
+
+  uint64_t checksum = 0;
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (uint32_t round = 0; round < STACK_ROUNDS; ++round) {
+    for (uint64_t ind = 0; ind < STACK_DEPTH; ++ind) {
+      list_push(&list, sizeof(uint64_t), &ind);
+    }
+    uint64_t item;
+    while (list_pop(&list, sizeof(uint64_t), &item) == 0) {
+      checksum += item;
+    }
+  }
+  double list_time = seconds_since(&start) / (STACK_ROUNDS * STACK_DEPTH);
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (uint32_t round = 0; round < STACK_ROUNDS; ++round) {
+    for (uint64_t ind = 0; ind < STACK_DEPTH; ++ind) {
+      word_list_push(&typed, ind);
+    }
+    uint64_t item;
+    while (word_list_pop(&typed, &item) == 0) {
+      checksum -= item;
+    }
+  }
+  double typed_time = seconds_since(&start) / (STACK_ROUNDS * STACK_DEPTH);
+
+  printf("containers: push and pop, List %.2fns, DEFINE_LIST %.2fns "
+         "(checksum %lu, should be 0)\n",
+         list_time * 1e9, typed_time * 1e9, (unsigned long)checksum);
+
+  list_clear(&list);
+  word_list_clear(&typed);
+}
+
+int main() {
+  uint32_t seed = 7;
+  for (uint32_t ind = 0; ind < MAX_KEYS; ++ind) {
+    seed = seed * 1103515245 + 12345;
+    // spread out and increasing, so the ordered map is filled backwards
+    keys[ind] = 0x10000000 + ((uint64_t)ind << 12) + ((seed >> 8) & 0xff) * 16;
+  }
+
+  for (uint32_t count = 16; count <= MAX_KEYS; count *= 8) {
+    OrderedMap ordered;
+    map_init(&ordered, key_cmp);
+    MapCalls ordered_calls = {.name = "OrderedMap",
+                              .map = &ordered,
+                              .insert = ordered_insert,
+                              .get = ordered_get};
+
+    HashMap hashed;
+    hash_map_init(&hashed, key_hash, key_cmp);
+    MapCalls hashed_calls = {.name = "HashMap",
+                             .map = &hashed,
+                             .insert = hashed_insert,
+                             .get = hashed_get};
+
+    KeyMap typed;
+    key_map_init(&typed);
+    MapCalls typed_calls = {.name = "KeyMap",
+                            .map = &typed,
+                            .insert = typed_insert,
+                            .get = typed_get};
+
+    int result = run(&ordered_calls, count);
+    if (result == 0) {
+      result = run(&hashed_calls, count);
+    }
+    if (result == 0) {
+      result = run(&typed_calls, count);
+    }
+
+    map_clear(&ordered);
+    hash_map_clear(&hashed);
+    key_map_clear(&typed);
+    if (result < 0) {
+      return 1;
+    }
+  }
+
+  run_stacks();
+
+  return 0;
+}
@@ -0,0 +1,180 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <time.h>
+
+#include "runtime/memory_manager.h"
+#include "runtime/types.h"
+
+// Marking benchmark for shapes that are hard on a tracer. Times a full
+// collection of each shape at a few sizes, which should grow linearly:
+//  - a list nested through the car, like ((((...)))), as deep as it is long
+//  - a list whose elements are all conses, which would fill up the mark
+//    stack if the cdr was traced before the car
+//  - a chain of environments with a frame pointing at every one of them,
+//    like a deep recursion, which marks each environment many times over
+//    unless marking stops at what is already marked
+
+#define MAX_SIZE 2000000
+
+typedef struct environment {
+  struct environment *parent;
+} Environment;
+
+typedef enum {
+  kNestedCars,
+  kListOfConses,
+  kEnvironmentChain,
+} Shape;
+
+static MemoryManager *manager;
+static LishpForm root;
+static Environment **frames;
+static uint32_t frame_count;
+
+static void trace_cons(struct runtime *rt, void *ptr) {
+  (void)rt;
+
+  // the same order as the runtime, so the car is traced first
+  LishpCons *cons = ptr;
+  if (OBJECT_P(cons->cdr)) {
+    mark_used(manager, cons->cdr.object, trace_cons);
+  }
+  if (OBJECT_P(cons->car)) {
+    mark_used(manager, cons->car.object, trace_cons);
+  }
+}
+
+static void trace_environment(struct runtime *rt, void *ptr) {
+  (void)rt;
+
+  Environment *env = ptr;
+  if (env->parent != NULL) {
+    mark_used(manager, env->parent, trace_environment);
+  }
+}
+
+static void mark_roots(struct runtime *rt) {
+  (void)rt;
+
+  if (OBJECT_P(root)) {
+    mark_used(manager, root.object, trace_cons);
+  }
+
+  for (uint32_t ind = 0; ind < frame_count; ++ind) {
+    mark_used(manager, frames[ind], trace_environment);
+  }
+}
+
+static double seconds_since(struct timespec *start) {
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  return (double)(end.tv_sec - start->tv_sec) +
+         (double)(end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static LishpCons *allocate_cons(LishpForm car, LishpForm cdr) {
+  LishpCons *cons = allocate(manager, sizeof(LishpCons));
+  if (cons == NULL) {
+    fprintf(stderr, "Allocation failed\n");
+    return NULL;
+  }
+  *cons = CONS(car, cdr);
+  return cons;
+}
+
+static int build(Shape shape, uint32_t size) {
+  for (uint32_t ind = 0; ind < size; ++ind) {
+    switch (shape) {
+    case kNestedCars: {
+      LishpCons *cons = allocate_cons(root, NIL);
+      if (cons == NULL) {
+        return -1;
+      }
+      root = FROM_OBJ(cons);
+    } break;
+    case kListOfConses: {
+      // the element is only reachable from the stack while the next cons is
+      // allocated, so root it for a moment, holding on to the rest of the
+      // list through its cdr until then
+      LishpCons *elt = allocate_cons(FROM_FIXNUM(ind), root);
+      if (elt == NULL) {
+        return -1;
+      }
+      LishpForm rest = root;
+      root = FROM_OBJ(elt);
+      LishpCons *cons = allocate_cons(FROM_OBJ(elt), rest);
+      if (cons == NULL) {
+        return -1;
+      }
+      elt->cdr = NIL;
+      root = FROM_OBJ(cons);
+    } break;
+    case kEnvironmentChain: {
+      Environment *env = allocate(manager, sizeof(Environment));
+      if (env == NULL) {
+        return -1;
+      }
+      env->parent = frame_count == 0 ? NULL : frames[frame_count - 1];
+      frames[frame_count++] = env;
+    } break;
+    }
+  }
+
+  return 0;
+}
+
+static int run(const char *name, Shape shape, uint32_t size) {
+  ManagerSettings settings = DEFAULT_MANAGER_SETTINGS;
+  settings.nursery_size = 0;
+
+  root = NIL;
+  frame_count = 0;
+  if (initialize_manager(&manager, mark_roots, NULL, settings) < 0) {
+    return -1;
+  }
+
+  if (build(shape, size) < 0) {
+    return -1;
+  }
+
+  uint32_t live_bytes = inspect_allocation(manager);
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  collect_garbage(manager);
+  double elapsed = seconds_since(&start);
+
+  if (inspect_allocation(manager) != live_bytes) {
+    fprintf(stderr, "%s: collecting freed live objects\n", name);
+    return -1;
+  }
+
+  uint32_t objects = shape == kListOfConses ? 2 * size : size;
+  printf("deep_marking: %-18s %8u deep, %8u objects, collected in %.3fs, "
+         "%.1f ns/object\n",
+         name, size, objects, elapsed, 1e9 * elapsed / objects);
+
+  cleanup_manager(&manager, NULL);
+
+  return 0;
+}
+
+int main() {
+  static Environment *frame_storage[MAX_SIZE];
+  frames = frame_storage;
+
+  const char *names[] = {"nested cars", "list of conses", "environment chain"};
+  Shape shapes[] = {kNestedCars, kListOfConses, kEnvironmentChain};
+
+  for (uint32_t shape = 0; shape < 3; ++shape) {
+    for (uint32_t size = MAX_SIZE / 4; size <= MAX_SIZE; size *= 2) {
+      if (run(names[shape], shapes[shape], size) < 0) {
+        return 1;
+      }
+    }
+  }
+
+  return 0;
+}
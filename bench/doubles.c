@@ -0,0 +1,78 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <time.h>
+
+#include "runtime.h"
+#include "runtime/memory_manager.h"
+#include "runtime/numbers.h"
+#include "runtime/types.h"
+
+// Double-float benchmark. Runs the same kernel, a running sum of products of
+// a fixnum and a double-float, once with values small enough to be immediates
+// and once with values so big that every result has to be boxed, and reports
+// the time and bytes allocated for each operation. The first should allocate
+// nothing at all.
+
+#define ROUNDS 5000000
+
+static double seconds_since(struct timespec *start) {
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  return (double)(end.tv_sec - start->tv_sec) +
+         (double)(end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static int run_kernel(Runtime *rt, const char *label, double scale) {
+  uint64_t allocated_before =
+      inspect_gc_stats(rt->memory_manager).allocated_bytes;
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  LishpForm step = make_double(rt, 0.5 * scale);
+  LishpForm sum = make_double(rt, 0);
+  double expected = 0;
+  for (int64_t ind = 0; ind < ROUNDS; ++ind) {
+    LishpForm product = number_multiply(rt, FROM_FIXNUM(ind % 1000), step);
+    sum = number_add(rt, sum, product);
+    expected += (ind % 1000) * (0.5 * scale);
+  }
+
+  double elapsed = seconds_since(&start);
+  uint64_t allocated =
+      inspect_gc_stats(rt->memory_manager).allocated_bytes - allocated_before;
+
+  printf("doubles: %-10s %.3fs, %.2fns and %.1f bytes an operation, sum ",
+         label, elapsed, elapsed * 1e9 / (2.0 * ROUNDS),
+         (double)allocated / (2.0 * ROUNDS));
+  print_double(as_double(sum), stdout);
+  printf("\n");
+
+  if (as_double(sum) != expected) {
+    fprintf(stderr, "Wrong sum!\n");
+    return -1;
+  }
+  return 0;
+}
+
+int main() {
+  Runtime rt;
+  if (initialize_runtime(&rt) < 0) {
+    return 1;
+  }
+
+  // nothing here is reachable, so the boxed sums mustn't be collected
+  pause_gc(rt.memory_manager);
+
+  int result = run_kernel(&rt, "immediate", 1);
+  if (result == 0) {
+    result = run_kernel(&rt, "boxed", 1e290);
+  }
+
+  resume_gc(rt.memory_manager);
+  cleanup_runtime(&rt);
+
+  return result < 0 ? 1 : 0;
+}
@@ -0,0 +1,104 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <time.h>
+
+#include "runtime/memory_manager.h"
+#include "runtime/types.h"
+
+// Pause time benchmark. Keeps a few million conses live while churning
+// through short-lived ones, once with stop-the-world collections and once
+// marking incrementally, and reports the longest and total pauses of each.
+// The nursery is off so that every collection has to mark the live list.
+
+#define LIVE_CONSES 2000000
+#define TEMP_CONSES 20000000
+#define SLICE_US 500
+
+static MemoryManager *manager;
+static LishpForm live_list;
+
+static void trace_cons(struct runtime *rt, void *ptr) {
+  (void)rt;
+
+  LishpForm cdr = ((LishpCons *)ptr)->cdr;
+  if (IS_OBJECT_TYPE(cdr, kCons)) {
+    mark_used(manager, cdr.object, trace_cons);
+  }
+}
+
+static void mark_list(struct runtime *rt) {
+  (void)rt;
+
+  if (IS_OBJECT_TYPE(live_list, kCons)) {
+    mark_used(manager, live_list.object, trace_cons);
+  }
+}
+
+static double seconds_since(struct timespec *start) {
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  return (double)(end.tv_sec - start->tv_sec) +
+         (double)(end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static int run(const char *name, uint64_t mark_slice_us) {
+  ManagerSettings settings = DEFAULT_MANAGER_SETTINGS;
+  settings.nursery_size = 0;
+  settings.mark_slice_us = mark_slice_us;
+
+  live_list = NIL;
+  if (initialize_manager(&manager, mark_list, NULL, settings) < 0) {
+    return -1;
+  }
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  for (uint32_t cons_ind = 0; cons_ind < LIVE_CONSES + TEMP_CONSES;
+       ++cons_ind) {
+    LishpCons *cons = allocate(manager, sizeof(LishpCons));
+    if (cons == NULL) {
+      fprintf(stderr, "Allocation failed after %u conses\n", cons_ind);
+      return -1;
+    }
+
+    if (cons_ind < LIVE_CONSES) {
+      *cons = CONS(FROM_FIXNUM(cons_ind), live_list);
+      live_list = FROM_OBJ(cons);
+    } else {
+      *cons = CONS(FROM_FIXNUM(cons_ind), NIL);
+    }
+  }
+
+  double elapsed = seconds_since(&start);
+  GcPauseTimes pauses = inspect_gc_stats(manager).pauses;
+
+  printf("gc_pauses: %-15s %.3fs, %lu pauses, longest %.3fms, "
+         "%.3fms in total, %lu MB heap\n",
+         name, elapsed, (unsigned long)pauses.count, pauses.max_ns / 1e6,
+         pauses.total_ns / 1e6,
+         (unsigned long)(inspect_heap_size(manager) >> 20));
+  printf("gc_pauses: %-15s histogram from under 10us up:", name);
+  for (uint32_t bucket = 0; bucket < GC_PAUSE_BUCKETS; ++bucket) {
+    printf(" %lu", (unsigned long)pauses.histogram[bucket]);
+  }
+  printf("\n");
+
+  cleanup_manager(&manager, NULL);
+
+  return 0;
+}
+
+int main() {
+  if (run("stop-the-world", 0) < 0) {
+    return 1;
+  }
+
+  if (run("incremental", SLICE_US) < 0) {
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,117 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "runtime/memory_manager.h"
+#include "runtime/types.h"
+
+// Collection trigger benchmark. Allocates a small live set, like starting up,
+// then churns through a lot of allocation while the live set stays the same
+// size, like a long-running process. Reports how many full collections each
+// phase did and how big the heap got, for a few growth percentages. The
+// nursery is off so that every collection is a full one.
+
+#define STARTUP_CONSES 20000
+#define LIVE_CONSES 250000
+#define CHURN_CONSES 20000000
+
+static MemoryManager *manager;
+static void **live;
+static uint32_t live_count;
+
+static void mark_live(struct runtime *rt) {
+  (void)rt;
+
+  for (uint32_t ind = 0; ind < live_count; ++ind) {
+    mark_used(manager, live[ind], NULL);
+  }
+}
+
+static double seconds_since(struct timespec *start) {
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  return (double)(end.tv_sec - start->tv_sec) +
+         (double)(end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static int run(uint64_t growth_percent) {
+  ManagerSettings settings = DEFAULT_MANAGER_SETTINGS;
+  settings.nursery_size = 0;
+  settings.gc_growth_percent = growth_percent;
+
+  live_count = 0;
+  if (initialize_manager(&manager, mark_live, NULL, settings) < 0) {
+    return -1;
+  }
+
+  for (uint32_t ind = 0; ind < STARTUP_CONSES; ++ind) {
+    live[live_count] = allocate(manager, sizeof(LishpCons));
+    if (live[live_count] == NULL) {
+      return -1;
+    }
+    ++live_count;
+  }
+
+  uint64_t startup_collections = inspect_gc_stats(manager).cycles.full_collections;
+
+  while (live_count < LIVE_CONSES) {
+    live[live_count] = allocate(manager, sizeof(LishpCons));
+    if (live[live_count] == NULL) {
+      return -1;
+    }
+    ++live_count;
+  }
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  uint64_t max_heap = 0;
+  for (uint32_t ind = 0; ind < CHURN_CONSES; ++ind) {
+    // replace a live cons, so the old one becomes garbage
+    void *cons = allocate(manager, sizeof(LishpCons));
+    if (cons == NULL) {
+      return -1;
+    }
+    live[ind % LIVE_CONSES] = cons;
+
+    uint64_t heap_size = inspect_heap_size(manager);
+    if (heap_size > max_heap) {
+      max_heap = heap_size;
+    }
+  }
+
+  double elapsed = seconds_since(&start);
+  GcCycleStats cycles = inspect_gc_stats(manager).cycles;
+
+  printf("gc_trigger: growth %3lu%%, %lu collections starting up, %lu while "
+         "churning in %.3fs, %lu MB largest heap, last reclaimed %lu KB\n",
+         (unsigned long)growth_percent, (unsigned long)startup_collections,
+         (unsigned long)(cycles.full_collections - startup_collections),
+         elapsed, (unsigned long)(max_heap >> 20),
+         (unsigned long)(cycles.reclaimed_bytes >> 10));
+
+  cleanup_manager(&manager, NULL);
+
+  return 0;
+}
+
+int main() {
+  live = malloc(LIVE_CONSES * sizeof(void *));
+  if (live == NULL) {
+    return 1;
+  }
+
+  uint64_t growth_percents[] = {50, 100, 300};
+  for (uint32_t ind = 0; ind < 3; ++ind) {
+    if (run(growth_percents[ind]) < 0) {
+      return 1;
+    }
+  }
+
+  free(live);
+
+  return 0;
+}
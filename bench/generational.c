@@ -0,0 +1,118 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <time.h>
+
+#include "runtime/memory_manager.h"
+#include "runtime/types.h"
+
+// Generational benchmark. Keeps a long list live, like the symbols and global
+// bindings of a running image, while allocating lots of short-lived argument
+// lists, which is what interpret_function_call does on every call. Runs once
+// without a nursery and once with one, so every collection in the first run
+// marks the whole list while the second run mostly does minor collections.
+
+#define LIVE_CONSES 1000000
+#define TEMP_LISTS 2000000
+#define TEMP_LIST_LENGTH 4
+
+static MemoryManager *manager;
+static LishpForm live_list;
+static LishpForm temp_list;
+
+static void trace_cons(struct runtime *rt, void *ptr) {
+  (void)rt;
+
+  LishpForm cdr = ((LishpCons *)ptr)->cdr;
+  if (IS_OBJECT_TYPE(cdr, kCons)) {
+    mark_used(manager, cdr.object, trace_cons);
+  }
+}
+
+static void mark_list(LishpForm list) {
+  if (IS_OBJECT_TYPE(list, kCons)) {
+    mark_used(manager, list.object, trace_cons);
+  }
+}
+
+static void mark_lists(struct runtime *rt) {
+  (void)rt;
+
+  mark_list(live_list);
+  mark_list(temp_list);
+}
+
+static double seconds_since(struct timespec *start) {
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  return (double)(end.tv_sec - start->tv_sec) +
+         (double)(end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static LishpCons *allocate_cons(LishpForm car, LishpForm cdr) {
+  LishpCons *cons = allocate(manager, sizeof(LishpCons));
+  if (cons == NULL) {
+    fprintf(stderr, "Allocation failed\n");
+    return NULL;
+  }
+  *cons = CONS(car, cdr);
+  return cons;
+}
+
+static int run(const char *name, uint64_t nursery_size) {
+  ManagerSettings settings = DEFAULT_MANAGER_SETTINGS;
+  settings.nursery_size = nursery_size;
+
+  live_list = NIL;
+  temp_list = NIL;
+  if (initialize_manager(&manager, mark_lists, NULL, settings) < 0) {
+    return -1;
+  }
+
+  for (uint32_t cons_ind = 0; cons_ind < LIVE_CONSES; ++cons_ind) {
+    LishpCons *cons = allocate_cons(FROM_FIXNUM(cons_ind), live_list);
+    if (cons == NULL) {
+      return -1;
+    }
+    live_list = FROM_OBJ(cons);
+  }
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  for (uint32_t list_ind = 0; list_ind < TEMP_LISTS; ++list_ind) {
+    temp_list = NIL;
+    for (uint32_t elt_ind = 0; elt_ind < TEMP_LIST_LENGTH; ++elt_ind) {
+      LishpCons *cons = allocate_cons(FROM_FIXNUM(elt_ind), temp_list);
+      if (cons == NULL) {
+        return -1;
+      }
+      temp_list = FROM_OBJ(cons);
+    }
+  }
+
+  double elapsed = seconds_since(&start);
+  uint32_t allocations = TEMP_LISTS * TEMP_LIST_LENGTH;
+
+  printf("generational: %-12s %u temporary conses in %.3fs, %.1f ns/alloc, "
+         "%lu MB heap\n",
+         name, allocations, elapsed, 1e9 * elapsed / allocations,
+         (unsigned long)(inspect_heap_size(manager) >> 20));
+
+  cleanup_manager(&manager, NULL);
+
+  return 0;
+}
+
+int main() {
+  if (run("no nursery", 0) < 0) {
+    return 1;
+  }
+
+  if (run("nursery", DEFAULT_MANAGER_SETTINGS.nursery_size) < 0) {
+    return 1;
+  }
+
+  return 0;
+}
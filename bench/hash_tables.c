@@ -0,0 +1,195 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <time.h>
+
+#include "runtime.h"
+#include "runtime/arrays.h"
+#include "runtime/hash_tables.h"
+#include "runtime/memory_manager.h"
+#include "runtime/types.h"
+
+// Hash table benchmark. Fills an EQL table keyed by fixnums and an EQ table
+// keyed by conses, which can only be hashed by address, and times inserts,
+// hits and misses against walking an association list for the same keys.
+// Then compacts the heap, which moves the conses, and checks that every one
+// of them is still found, timing the first lookup, which has to rehash the
+// table.
+
+#define KEYS 100000
+#define LOOKUPS 1000000
+#define ALIST_LOOKUPS 1000
+
+static Runtime rt;
+static LishpSymbol *root_sym;
+
+static double seconds_since(struct timespec *start) {
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  return (double)(end.tv_sec - start->tv_sec) +
+         (double)(end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// the global binding is what keeps everything alive, as a simple vector of
+// the tables, the alist and the cons keys
+static LishpSimpleVector *roots() {
+  Package *user = find_package(&rt, "USER");
+  return AS_OBJECT(LishpSimpleVector,
+                   symbol_value(&rt, user->global, root_sym));
+}
+
+static LishpHashTable *root_table(uint32_t index) {
+  return AS_OBJECT(LishpHashTable, roots()->elements[index]);
+}
+
+static int fill(uint32_t table_index, int by_cons) {
+  LishpSimpleVector *keys =
+      AS_OBJECT(LishpSimpleVector, roots()->elements[3]);
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int64_t ind = 0; ind < KEYS; ++ind) {
+    LishpForm key = by_cons ? keys->elements[ind] : FROM_FIXNUM(ind * 7);
+    hash_table_put(&rt, root_table(table_index), key, FROM_FIXNUM(ind));
+  }
+  double insert_time = seconds_since(&start) / KEYS;
+
+  uint32_t seed = 1;
+  int64_t checksum = 0;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (uint32_t ind = 0; ind < LOOKUPS; ++ind) {
+    seed = seed * 1103515245 + 12345;
+    int64_t index = (seed >> 4) % KEYS;
+    LishpForm key = by_cons ? keys->elements[index] : FROM_FIXNUM(index * 7);
+
+    LishpForm value = NIL;
+    if (!hash_table_get(&rt, root_table(table_index), key, &value) ||
+        AS_FIXNUM(value) != index) {
+      printf("hash_tables: lost key %ld\n", (long)index);
+      return -1;
+    }
+    checksum += AS_FIXNUM(value);
+  }
+  double hit_time = seconds_since(&start) / LOOKUPS;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (uint32_t ind = 0; ind < LOOKUPS; ++ind) {
+    LishpForm value;
+    // multiples of 7 plus one are never keys
+    checksum += hash_table_get(&rt, root_table(table_index),
+                               FROM_FIXNUM(ind * 7 + 1), &value);
+  }
+  double miss_time = seconds_since(&start) / LOOKUPS;
+
+  printf("hash_tables: %-5s insert %6.1fns, hit %6.1fns, miss %6.1fns "
+         "(checksum %ld)\n",
+         by_cons ? "eq" : "eql", insert_time * 1e9, hit_time * 1e9,
+         miss_time * 1e9, (long)checksum);
+  return 0;
+}
+
+static void alist_lookups() {
+  LishpForm alist = roots()->elements[2];
+
+  uint32_t seed = 1;
+  int64_t checksum = 0;
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (uint32_t ind = 0; ind < ALIST_LOOKUPS; ++ind) {
+    seed = seed * 1103515245 + 12345;
+    LishpForm key = FROM_FIXNUM((seed >> 4) % KEYS * 7);
+
+    for (LishpForm cur = alist; IS_OBJECT_TYPE(cur, kCons);
+         cur = AS_OBJECT(LishpCons, cur)->cdr) {
+      LishpCons *pair = AS_OBJECT(LishpCons, AS_OBJECT(LishpCons, cur)->car);
+      if (EQ_P(pair->car, key)) {
+        checksum += AS_FIXNUM(pair->cdr);
+        break;
+      }
+    }
+  }
+  double hit_time = seconds_since(&start) / ALIST_LOOKUPS;
+
+  printf("hash_tables: alist hit %10.1fns (checksum %ld)\n", hit_time * 1e9,
+         (long)checksum);
+}
+
+// each pair is held by the roots while the cons for it is allocated
+static void build_alist() {
+  for (int64_t ind = KEYS - 1; ind >= 0; --ind) {
+    LishpCons *pair = ALLOCATE_OBJ(LishpCons, &rt);
+    *pair = CONS(FROM_FIXNUM(ind * 7), FROM_FIXNUM(ind));
+    roots()->elements[4] = FROM_OBJ(pair);
+    OBJ_WRITE_BARRIER(&rt, roots(), pair);
+
+    LishpCons *cons = ALLOCATE_OBJ(LishpCons, &rt);
+    *cons = CONS(roots()->elements[4], roots()->elements[2]);
+    roots()->elements[2] = FROM_OBJ(cons);
+    OBJ_WRITE_BARRIER(&rt, roots(), cons);
+  }
+  roots()->elements[4] = NIL;
+}
+
+int main() {
+  if (initialize_runtime(&rt) < 0) {
+    return 1;
+  }
+
+  Package *user = find_package(&rt, "USER");
+  root_sym = intern_symbol(&rt, user, "*HASH-TABLES*");
+  bind_value(&rt, user->global, root_sym,
+             FROM_OBJ(make_vector(&rt, kSimpleVector, 5, NIL)));
+
+  LishpObject *keys = make_vector(&rt, kSimpleVector, KEYS, NIL);
+  roots()->elements[3] = FROM_OBJ(keys);
+  OBJ_WRITE_BARRIER(&rt, roots(), keys);
+  for (int64_t ind = 0; ind < KEYS; ++ind) {
+    LishpCons *cons = ALLOCATE_OBJ(LishpCons, &rt);
+    *cons = CONS(FROM_FIXNUM(ind), NIL);
+    vector_set(&rt, roots()->elements[3].object, ind, FROM_OBJ(cons));
+  }
+
+  LishpHashTable *eql_table = make_hash_table(&rt, kTestEql, 0);
+  roots()->elements[0] = FROM_OBJ(eql_table);
+  OBJ_WRITE_BARRIER(&rt, roots(), eql_table);
+  LishpHashTable *eq_table = make_hash_table(&rt, kTestEq, 0);
+  roots()->elements[1] = FROM_OBJ(eq_table);
+  OBJ_WRITE_BARRIER(&rt, roots(), eq_table);
+
+  build_alist();
+
+  if (fill(0, 0) < 0 || fill(1, 1) < 0) {
+    return 1;
+  }
+  alist_lookups();
+
+  // drop the alist, so that there are holes for the keys to move into
+  roots()->elements[2] = NIL;
+  uint64_t compactions = inspect_compactions(rt.memory_manager);
+  compact_garbage(rt.memory_manager);
+  int moved = inspect_compactions(rt.memory_manager) != compactions;
+
+  LishpSimpleVector *key_vector =
+      AS_OBJECT(LishpSimpleVector, roots()->elements[3]);
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  LishpForm value;
+  int found = hash_table_get(&rt, root_table(1), key_vector->elements[0],
+                             &value);
+  double rehash_time = seconds_since(&start);
+
+  for (int64_t ind = 0; ind < KEYS && found; ++ind) {
+    found = hash_table_get(&rt, root_table(1), key_vector->elements[ind],
+                           &value) &&
+            AS_FIXNUM(value) == ind;
+  }
+  printf("hash_tables: after %s, first lookup %.3fms, every key %s\n",
+         moved ? "compacting" : "a collection (nothing moved)",
+         rehash_time * 1e3, found ? "found" : "NOT found");
+
+  bind_value(&rt, user->global, root_sym, NIL);
+  cleanup_runtime(&rt);
+
+  return found ? 0 : 1;
+}
@@ -0,0 +1,89 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <time.h>
+
+#include "runtime/memory_manager.h"
+#include "runtime/types.h"
+
+// Heap growth benchmark. Builds one list of millions of live conses, which
+// needs the heap to grow well past a single block, then drops it and checks
+// that collecting gives the empty blocks back.
+
+#define CONS_COUNT 4000000
+
+static MemoryManager *manager;
+static LishpForm live_list;
+
+static void trace_cons(struct runtime *rt, void *ptr) {
+  (void)rt;
+
+  LishpForm cdr = ((LishpCons *)ptr)->cdr;
+  if (IS_OBJECT_TYPE(cdr, kCons)) {
+    mark_used(manager, cdr.object, trace_cons);
+  }
+}
+
+static void mark_list(struct runtime *rt) {
+  (void)rt;
+
+  if (IS_OBJECT_TYPE(live_list, kCons)) {
+    mark_used(manager, live_list.object, trace_cons);
+  }
+}
+
+static double seconds_since(struct timespec *start) {
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  return (double)(end.tv_sec - start->tv_sec) +
+         (double)(end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int main() {
+  if (initialize_manager(&manager, mark_list, NULL, DEFAULT_MANAGER_SETTINGS) <
+      0) {
+    return 1;
+  }
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  live_list = NIL;
+  for (uint32_t cons_ind = 0; cons_ind < CONS_COUNT; ++cons_ind) {
+    LishpCons *cons = allocate(manager, sizeof(LishpCons));
+    if (cons == NULL) {
+      fprintf(stderr, "Allocation failed after %u conses\n", cons_ind);
+      return 1;
+    }
+    *cons = CONS(FROM_FIXNUM(cons_ind), live_list);
+    live_list = FROM_OBJ(cons);
+  }
+
+  double elapsed = seconds_since(&start);
+
+  printf("heap_growth: %u live conses in %.3fs, %u bytes live, %lu MB heap\n",
+         CONS_COUNT, elapsed, inspect_allocation(manager),
+         (unsigned long)(inspect_heap_size(manager) >> 20));
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  collect_garbage(manager);
+  elapsed = seconds_since(&start);
+
+  printf("heap_growth: collecting with the list live took %.3fs\n", elapsed);
+
+  live_list = NIL;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  collect_garbage(manager);
+  elapsed = seconds_since(&start);
+
+  printf("heap_growth: collecting the dropped list took %.3fs, %u bytes live, "
+         "%lu MB heap\n",
+         elapsed, inspect_allocation(manager),
+         (unsigned long)(inspect_heap_size(manager) >> 20));
+
+  cleanup_manager(&manager, NULL);
+
+  return 0;
+}
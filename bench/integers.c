@@ -0,0 +1,175 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "runtime.h"
+#include "runtime/memory_manager.h"
+#include "runtime/numbers.h"
+#include "runtime/types.h"
+
+// Integer arithmetic benchmark, one part for each tier. The fixnum part runs
+// sums, products and divisions that never leave the fixnum range, so it only
+// measures the fast paths. The bignum part works out a factorial, then squares
+// numbers of doubling length, where each doubling should cost about three
+// times as much once Karatsuba takes over from the four times of the
+// schoolbook method. Every product is divided back out again to check it.
+// Nothing the benchmark makes is reachable from the runtime, so collecting is
+// paused throughout.
+
+#define FIXNUM_ROUNDS 10000000
+#define FACTORIAL 3000
+#define SQUARE_SIZES 5
+#define SMALLEST_SQUARE 64 // limbs
+#define SQUARES 20
+
+static double seconds_since(struct timespec *start) {
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  return (double)(end.tv_sec - start->tv_sec) +
+         (double)(end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static int run_fixnums(Runtime *rt) {
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  LishpForm sum = FROM_FIXNUM(0);
+  LishpForm checksum = FROM_FIXNUM(0);
+  for (int64_t ind = 1; ind <= FIXNUM_ROUNDS; ++ind) {
+    LishpForm n = FROM_FIXNUM(ind);
+    sum = integer_add(rt, sum, n);
+    LishpForm product = integer_multiply(rt, n, FROM_FIXNUM(ind - 7));
+    LishpForm quotient = integer_floor(rt, product, FROM_FIXNUM(13));
+    LishpForm remainder = integer_mod(rt, product, FROM_FIXNUM(13));
+    checksum = integer_subtract(rt, checksum, quotient);
+    checksum = integer_add(rt, checksum, remainder);
+  }
+
+  double elapsed = seconds_since(&start);
+  printf("integers: fixnums   %.3fs, %.2fns an operation, sum %ld, "
+         "checksum %ld\n",
+         elapsed, elapsed * 1e9 / (6.0 * FIXNUM_ROUNDS),
+         (long)AS_FIXNUM(sum), (long)AS_FIXNUM(checksum));
+
+  if (!FIXNUM_P(sum) ||
+      AS_FIXNUM(sum) != (int64_t)FIXNUM_ROUNDS * (FIXNUM_ROUNDS + 1) / 2) {
+    fprintf(stderr, "Wrong fixnum sum!\n");
+    return -1;
+  }
+  return 0;
+}
+
+static int same_integer(Runtime *rt, LishpForm l, LishpForm r) {
+  LishpForm difference = integer_subtract(rt, l, r);
+  return FIXNUM_P(difference) && AS_FIXNUM(difference) == 0;
+}
+
+static int check_division(Runtime *rt, LishpForm product, LishpForm l,
+                          LishpForm r) {
+  return same_integer(rt, integer_floor(rt, product, r), l) &&
+         same_integer(rt, integer_mod(rt, product, r), FROM_FIXNUM(0));
+}
+
+static int run_factorial(Runtime *rt) {
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  LishpForm product = FROM_FIXNUM(1);
+  for (int64_t n = 2; n <= FACTORIAL; ++n) {
+    product = integer_multiply(rt, product, FROM_FIXNUM(n));
+  }
+
+  double elapsed = seconds_since(&start);
+  printf("integers: %d! %.3fms, %u limbs\n", FACTORIAL, elapsed * 1e3,
+         AS_OBJECT(LishpBignum, product)->length);
+
+  // dividing back down has to land on exactly one
+  for (int64_t n = FACTORIAL; n >= 2; --n) {
+    if (!same_integer(rt, integer_mod(rt, product, FROM_FIXNUM(n)),
+                      FROM_FIXNUM(0))) {
+      fprintf(stderr, "%ld doesn't divide the factorial!\n", (long)n);
+      return -1;
+    }
+    product = integer_floor(rt, product, FROM_FIXNUM(n));
+  }
+
+  if (!same_integer(rt, product, FROM_FIXNUM(1))) {
+    fprintf(stderr, "Wrong factorial!\n");
+    return -1;
+  }
+  return 0;
+}
+
+static LishpForm random_integer(Runtime *rt, uint32_t limbs, uint32_t *seed) {
+  // a limb is a little over 19 digits
+  uint32_t digit_count = limbs * 19;
+  char *digits = malloc(digit_count);
+
+  digits[0] = '1' + *seed % 9;
+  for (uint32_t ind = 1; ind < digit_count; ++ind) {
+    *seed = *seed * 1103515245 + 12345;
+    digits[ind] = '0' + (*seed >> 16) % 10;
+  }
+
+  LishpForm result = parse_integer(rt, digits, digit_count);
+  free(digits);
+  return result;
+}
+
+static int run_squares(Runtime *rt) {
+  uint32_t seed = 1;
+  double last = 0;
+
+  for (uint32_t size = 0; size < SQUARE_SIZES; ++size) {
+    uint32_t limbs = SMALLEST_SQUARE << size;
+    LishpForm l = random_integer(rt, limbs, &seed);
+    LishpForm r = random_integer(rt, limbs, &seed);
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    LishpForm product;
+    for (uint32_t ind = 0; ind < SQUARES; ++ind) {
+      product = integer_multiply(rt, l, r);
+    }
+
+    double elapsed = seconds_since(&start) / SQUARES;
+    printf("integers: %5u limbs %8.3fms a product", limbs, elapsed * 1e3);
+    if (last > 0) {
+      printf(", %.2fx the last size", elapsed / last);
+    }
+    printf("\n");
+    last = elapsed;
+
+    if (!check_division(rt, product, l, r)) {
+      fprintf(stderr, "Wrong product of %u limbs!\n", limbs);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+int main() {
+  Runtime rt;
+  if (initialize_runtime(&rt) < 0) {
+    return 1;
+  }
+
+  pause_gc(rt.memory_manager);
+
+  int result = run_fixnums(&rt);
+  if (result == 0) {
+    result = run_factorial(&rt);
+  }
+  if (result == 0) {
+    result = run_squares(&rt);
+  }
+
+  resume_gc(rt.memory_manager);
+  cleanup_runtime(&rt);
+
+  return result < 0 ? 1 : 0;
+}
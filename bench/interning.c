@@ -0,0 +1,87 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <time.h>
+
+#include "runtime.h"
+
+// Symbol interning benchmark. Interns a lot of new names into a package,
+// which allocates each symbol, then looks them up again at random the way
+// the reader does, straight out of a buffer that isn't zero terminated, and
+// checks each lookup gives back the same symbol. Then the same for the dozen
+// or so names every program uses over and over.
+
+#define NAMES 200000
+#define LOOKUPS 2000000
+#define NAME_LENGTH 12
+
+static Runtime rt;
+static char names[NAMES][NAME_LENGTH];
+static LishpSymbol *interned[NAMES];
+
+static double seconds_since(struct timespec *start) {
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  return (double)(end.tv_sec - start->tv_sec) +
+         (double)(end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static const char *common_names[] = {
+    "CAR",  "CDR",    "CONS",   "LET*",  "PROGN", "QUOTE",
+    "SETQ", "FORMAT", "LENGTH", "AREF",  "NIL",   "T",
+    "+",    "-",      "FILL",   "GETHASH"};
+
+#define COMMON_COUNT (sizeof(common_names) / sizeof(common_names[0]))
+
+int main() {
+  if (initialize_runtime(&rt) < 0) {
+    return 1;
+  }
+  Package *user = find_package(&rt, "USER");
+
+  for (uint32_t ind = 0; ind < NAMES; ++ind) {
+    // like the tokens in a data file: a common prefix, then a number
+    snprintf(names[ind], NAME_LENGTH, "ITEM-%06u", ind);
+  }
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (uint32_t ind = 0; ind < NAMES; ++ind) {
+    interned[ind] = intern_chars(&rt, user, names[ind], NAME_LENGTH - 1);
+  }
+  double miss_time = seconds_since(&start) / NAMES;
+
+  uint32_t seed = 1;
+  int same = 1;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (uint32_t ind = 0; ind < LOOKUPS; ++ind) {
+    seed = seed * 1103515245 + 12345;
+    uint32_t index = (seed >> 4) % NAMES;
+    same &= intern_chars(&rt, user, names[index], NAME_LENGTH - 1) ==
+            interned[index];
+  }
+  double hit_time = seconds_since(&start) / LOOKUPS;
+
+  LishpSymbol *common[COMMON_COUNT];
+  for (uint32_t ind = 0; ind < COMMON_COUNT; ++ind) {
+    common[ind] = intern_symbol(&rt, user, common_names[ind]);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (uint32_t ind = 0; ind < LOOKUPS; ++ind) {
+    uint32_t index = ind % COMMON_COUNT;
+    same &= intern_symbol(&rt, user, common_names[index]) == common[index];
+  }
+  double common_time = seconds_since(&start) / LOOKUPS;
+
+  printf("interning: %u new names %.1fns each, then looking them up %.1fns, "
+         "and %u common names %.1fns\n",
+         NAMES, miss_time * 1e9, hit_time * 1e9, (uint32_t)COMMON_COUNT,
+         common_time * 1e9);
+  printf("interning: every lookup %s the interned symbol\n",
+         same ? "found" : "did NOT find");
+
+  cleanup_runtime(&rt);
+
+  return same ? 0 : 1;
+}
@@ -0,0 +1,115 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "runtime/memory_manager.h"
+#include "runtime/types.h"
+
+// Large object benchmark. Keeps a list of conses growing while buffers of
+// anywhere from 40K to 1M come and go in between them, the way big strings
+// do in a REPL, and reports how big and how fragmented the heap ends up. Then
+// drops everything and checks how much of the heap goes back to the OS.
+
+#define ROUNDS 20000
+#define CONSES_PER_ROUND 64
+#define BUFFER_SLOTS 16
+#define MIN_BUFFER (40 << 10)
+#define MAX_BUFFER (1 << 20)
+
+static MemoryManager *manager;
+static LishpForm live_list;
+static char *buffers[BUFFER_SLOTS];
+
+static void trace_cons(struct runtime *rt, void *ptr) {
+  (void)rt;
+
+  LishpForm cdr = ((LishpCons *)ptr)->cdr;
+  if (IS_OBJECT_TYPE(cdr, kCons)) {
+    mark_used(manager, cdr.object, trace_cons);
+  }
+}
+
+static void mark_roots(struct runtime *rt) {
+  (void)rt;
+
+  if (IS_OBJECT_TYPE(live_list, kCons)) {
+    mark_used(manager, live_list.object, trace_cons);
+  }
+  for (uint32_t slot = 0; slot < BUFFER_SLOTS; ++slot) {
+    if (buffers[slot] != NULL) {
+      mark_used(manager, buffers[slot], NULL);
+    }
+  }
+}
+
+static double seconds_since(struct timespec *start) {
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  return (double)(end.tv_sec - start->tv_sec) +
+         (double)(end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void report(const char *label, double elapsed) {
+  GcStats stats = inspect_gc_stats(manager);
+
+  printf("large_objects: %-8s %.3fs, heap %4luM (%luM large), %4luM free, "
+         "largest free chunk %luK\n",
+         label, elapsed, (unsigned long)(stats.heap_size >> 20),
+         (unsigned long)(stats.large_bytes >> 20),
+         (unsigned long)(stats.free_bytes >> 20),
+         (unsigned long)(stats.largest_free_chunk >> 10));
+}
+
+int main() {
+  if (initialize_manager(&manager, mark_roots, NULL,
+                         DEFAULT_MANAGER_SETTINGS) < 0) {
+    return 1;
+  }
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  live_list = NIL;
+  uint32_t seed = 1;
+  for (uint32_t round = 0; round < ROUNDS; ++round) {
+    for (uint32_t cons_ind = 0; cons_ind < CONSES_PER_ROUND; ++cons_ind) {
+      LishpCons *cons = allocate(manager, sizeof(LishpCons));
+      if (cons == NULL) {
+        fprintf(stderr, "Cons allocation failed in round %u\n", round);
+        return 1;
+      }
+      *cons = CONS(FROM_FIXNUM(round), live_list);
+      live_list = FROM_OBJ(cons);
+    }
+
+    seed = seed * 1103515245 + 12345;
+    uint32_t size = MIN_BUFFER + (seed >> 8) % (MAX_BUFFER - MIN_BUFFER);
+
+    // the old buffer in the slot becomes garbage
+    char *buffer = allocate(manager, size);
+    if (buffer == NULL) {
+      fprintf(stderr, "Buffer allocation failed in round %u\n", round);
+      return 1;
+    }
+    memset(buffer, round, size);
+    buffers[round % BUFFER_SLOTS] = buffer;
+  }
+
+  report("built", seconds_since(&start));
+
+  live_list = NIL;
+  for (uint32_t slot = 0; slot < BUFFER_SLOTS; ++slot) {
+    buffers[slot] = NULL;
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  collect_garbage(manager);
+  report("dropped", seconds_since(&start));
+
+  cleanup_manager(&manager, NULL);
+
+  return 0;
+}
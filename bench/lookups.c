@@ -0,0 +1,83 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <time.h>
+
+#include "runtime.h"
+#include "runtime/memory_manager.h"
+
+// Symbol lookup benchmark. Nests lexical environments under USER's global
+// environment, about as deep as the REPL is when it calls a function, binds
+// one value halfway up them, and times looking up a built-in function from
+// COMMON-LISP, a global value and that lexical value from the innermost one.
+
+#define DEPTH 8
+#define LOOKUPS 10000000
+
+static Runtime rt;
+
+static double seconds_since(struct timespec *start) {
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  return (double)(end.tv_sec - start->tv_sec) +
+         (double)(end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+int main() {
+  if (initialize_runtime(&rt) < 0) {
+    return 1;
+  }
+  Package *user = find_package(&rt, "USER");
+  Package *common_lisp = find_package(&rt, "COMMON-LISP");
+
+  LishpSymbol *plus_sym = intern_symbol(&rt, common_lisp, "+");
+  LishpSymbol *global_sym = intern_symbol(&rt, user, "*GLOBAL*");
+  LishpSymbol *lexical_sym = intern_symbol(&rt, user, "LEXICAL");
+  bind_value(&rt, user->global, global_sym, FROM_FIXNUM(1));
+
+  // nothing else refers to the environments, so don't let them be collected
+  pause_gc(rt.memory_manager);
+  Environment *env = user->global;
+  for (uint32_t ind = 0; ind < DEPTH; ++ind) {
+    env = allocate_env(&rt, env);
+    if (ind == DEPTH / 2) {
+      bind_value(&rt, env, lexical_sym, FROM_FIXNUM(2));
+    }
+  }
+
+  LishpFunction *plus_fn = symbol_function(&rt, user->global, plus_sym);
+  int same = 1;
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (uint32_t ind = 0; ind < LOOKUPS; ++ind) {
+    same &= symbol_function(&rt, env, plus_sym) == plus_fn;
+  }
+  double function_time = seconds_since(&start) / LOOKUPS;
+
+  int64_t checksum = 0;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (uint32_t ind = 0; ind < LOOKUPS; ++ind) {
+    checksum += AS_FIXNUM(symbol_value(&rt, env, global_sym));
+  }
+  double global_time = seconds_since(&start) / LOOKUPS;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (uint32_t ind = 0; ind < LOOKUPS; ++ind) {
+    checksum += AS_FIXNUM(symbol_value(&rt, env, lexical_sym));
+  }
+  double lexical_time = seconds_since(&start) / LOOKUPS;
+  resume_gc(rt.memory_manager);
+
+  same &= checksum == (int64_t)LOOKUPS * 3;
+  printf("lookups: %u environments deep, global function %.1fns, global "
+         "value %.1fns, lexical value %.1fns\n",
+         DEPTH, function_time * 1e9, global_time * 1e9, lexical_time * 1e9);
+  printf("lookups: every lookup %s the bound value\n",
+         same ? "found" : "did NOT find");
+
+  cleanup_runtime(&rt);
+
+  return same ? 0 : 1;
+}
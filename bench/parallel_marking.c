@@ -0,0 +1,116 @@
+#include <stdio.h>
+
+#include "runtime/memory_manager.h"
+#include "runtime/types.h"
+
+// Parallel marking benchmark. Builds a complete binary tree out of conses, a
+// few million of them, and times full collections of it with different
+// numbers of marking threads. A tree branches at every cons, so there is
+// always plenty of work to hand over to idle threads, and the pauses should
+// shrink with each thread up to the number of cores. The tree is counted
+// after the collections, so that anything swept while live shows up.
+
+#define TREE_DEPTH 21
+#define COLLECTIONS 5
+
+static MemoryManager *manager;
+static LishpForm root;
+
+static void trace_cons(struct runtime *rt, void *ptr) {
+  (void)rt;
+
+  LishpCons *cons = ptr;
+  if (OBJECT_P(cons->cdr)) {
+    mark_used(manager, cons->cdr.object, trace_cons);
+  }
+  if (OBJECT_P(cons->car)) {
+    mark_used(manager, cons->car.object, trace_cons);
+  }
+}
+
+static void mark_root(struct runtime *rt) {
+  (void)rt;
+
+  if (OBJECT_P(root)) {
+    mark_used(manager, root.object, trace_cons);
+  }
+}
+
+static LishpForm build_tree(uint32_t depth) {
+  if (depth == 0) {
+    return FROM_FIXNUM(1);
+  }
+
+  LishpForm car = build_tree(depth - 1);
+  LishpForm cdr = build_tree(depth - 1);
+
+  LishpCons *cons = allocate(manager, sizeof(LishpCons));
+  if (cons == NULL) {
+    return NIL;
+  }
+  *cons = CONS(car, cdr);
+
+  return FROM_OBJ(cons);
+}
+
+static uint64_t count_leaves(LishpForm form) {
+  if (!OBJECT_P(form)) {
+    return FIXNUM_P(form) ? AS_FIXNUM(form) : 0;
+  }
+
+  LishpCons *cons = AS_OBJECT(LishpCons, form);
+  return count_leaves(cons->car) + count_leaves(cons->cdr);
+}
+
+static int run(uint64_t mark_threads) {
+  ManagerSettings settings = DEFAULT_MANAGER_SETTINGS;
+  settings.mark_threads = mark_threads;
+
+  if (initialize_manager(&manager, mark_root, NULL, settings) < 0) {
+    return -1;
+  }
+
+  // nothing in the tree is reachable until it is finished
+  pause_gc(manager);
+  root = build_tree(TREE_DEPTH);
+  resume_gc(manager);
+
+  GcPauseTimes before = inspect_gc_stats(manager).pauses;
+  for (uint32_t ind = 0; ind < COLLECTIONS; ++ind) {
+    collect_garbage(manager);
+  }
+  GcPauseTimes after = inspect_gc_stats(manager).pauses;
+
+  uint64_t leaves = count_leaves(root);
+  uint64_t count = after.count - before.count;
+
+  printf("parallel_marking: %lu threads, heap %4luM, mean pause %.3fms, "
+         "longest %.3fms, %lu leaves\n",
+         (unsigned long)mark_threads,
+         (unsigned long)(inspect_heap_size(manager) >> 20),
+         (double)(after.total_ns - before.total_ns) / count / 1e6,
+         (double)after.max_ns / 1e6, (unsigned long)leaves);
+
+  root = NIL;
+  cleanup_manager(&manager, NULL);
+
+  if (leaves != (uint64_t)1 << TREE_DEPTH) {
+    fprintf(stderr, "Tree changed by collection!\n");
+    return -1;
+  }
+
+  return 0;
+}
+
+int main() {
+  uint64_t thread_counts[] = {1, 2, 4, 8};
+
+  for (uint32_t ind = 0; ind < sizeof(thread_counts) / sizeof(uint64_t);
+       ++ind) {
+    if (run(thread_counts[ind]) < 0) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
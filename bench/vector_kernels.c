@@ -0,0 +1,131 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "runtime/vector_kernels.h"
+
+// Vector kernel benchmark. Runs each of the numeric array kernels over the
+// same double-float and fixnum arrays with every instruction set this CPU
+// supports, and reports the time per element next to the speedup over the
+// plain loop. The arrays fit in L2, so it's the arithmetic being measured
+// rather than memory. Each result is checked against the plain loop's, with
+// some slack for the double-float sums, which add up in a different order.
+
+#define LENGTH 32768
+#define ROUNDS 2000
+
+static double xs[LENGTH], ys[LENGTH], double_out[LENGTH];
+static int64_t is[LENGTH], js[LENGTH], fixnum_out[LENGTH];
+
+// what each kernel came out with under the plain loop, to check the rest by
+static double expected[8];
+
+static double seconds_since(struct timespec *start) {
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  return (double)(end.tv_sec - start->tv_sec) +
+         (double)(end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// returns a checksum of what the kernel made, so nothing is optimized away
+static double run_kernel(const VectorKernels *k, int kernel) {
+  double lo, hi;
+  int64_t fixnum_lo, fixnum_hi;
+
+  switch (kernel) {
+  case 0:
+    return k->sum_doubles(xs, LENGTH);
+  case 1:
+    return k->dot_doubles(xs, ys, LENGTH);
+  case 2:
+    k->min_max_doubles(xs, LENGTH, &lo, &hi);
+    return lo + hi;
+  case 3:
+    k->add_doubles(double_out, xs, ys, LENGTH);
+    return double_out[LENGTH / 2];
+  case 4:
+    return (double)k->sum_fixnums(is, LENGTH);
+  case 5:
+    k->min_max_fixnums(is, LENGTH, &fixnum_lo, &fixnum_hi);
+    return (double)fixnum_lo + (double)fixnum_hi;
+  case 6:
+    if (k->add_fixnums(fixnum_out, is, js, LENGTH) < 0) {
+      return NAN;
+    }
+    return (double)fixnum_out[LENGTH / 2];
+  default:
+    k->fill_words((uint64_t *)fixnum_out, LENGTH, 7);
+    return (double)fixnum_out[LENGTH - 1];
+  }
+}
+
+static const char *kernel_names[8] = {
+    "sum double", "dot double", "min/max double", "add double",
+    "sum fixnum", "min/max fixnum", "add fixnum", "fill"};
+
+static int run(VectorIsa isa, double *scalar_times) {
+  const VectorKernels *k = vector_kernels(isa);
+  if (k == NULL) {
+    printf("vector_kernels: %s isn't supported here\n",
+           isa == kIsaSse2 ? "sse2" : "avx2");
+    return 0;
+  }
+
+  for (int kernel = 0; kernel < 8; ++kernel) {
+    double result = run_kernel(k, kernel);
+    if (isa == kIsaScalar) {
+      expected[kernel] = result;
+    } else if (fabs(result - expected[kernel]) >
+               1e-9 * fabs(expected[kernel])) {
+      printf("vector_kernels: %s %s got %.17g instead of %.17g\n", k->name,
+             kernel_names[kernel], result, expected[kernel]);
+      return -1;
+    }
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    double checksum = 0;
+    for (int round = 0; round < ROUNDS; ++round) {
+      checksum += run_kernel(k, kernel);
+    }
+    double time = seconds_since(&start) / ((double)ROUNDS * LENGTH);
+
+    if (isa == kIsaScalar) {
+      scalar_times[kernel] = time;
+    }
+    printf("vector_kernels: %-6s %-14s %6.3fns an element, %5.2fx the plain "
+           "loop (checksum %g)\n",
+           k->name, kernel_names[kernel], time * 1e9,
+           scalar_times[kernel] / time, checksum);
+  }
+
+  return 0;
+}
+
+int main() {
+  uint32_t seed = 1;
+  for (uint32_t ind = 0; ind < LENGTH; ++ind) {
+    seed = seed * 1103515245 + 12345;
+    xs[ind] = (double)(seed >> 8) / (1 << 24) - 0.5;
+    ys[ind] = (double)(ind % 100) / 7;
+    // big enough that the sums need all 64 bits of the lanes
+    is[ind] = ((int64_t)seed << 28) - ((int64_t)1 << 59);
+    js[ind] = ind;
+  }
+
+  const char *selected = select_vector_kernels(VECTOR_ISA_COUNT - 1)->name;
+  printf("vector_kernels: the runtime would pick %s\n", selected);
+
+  double scalar_times[8];
+  for (int isa = kIsaScalar; isa < VECTOR_ISA_COUNT; ++isa) {
+    if (run(isa, scalar_times) < 0) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,145 @@
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <time.h>
+
+#include "runtime.h"
+#include "runtime/arrays.h"
+#include "runtime/memory_manager.h"
+#include "runtime/types.h"
+
+// Vector benchmark. Holds the same fixnums in a list, a simple vector and a
+// fixnum vector, and for each one times summing every element, reading every
+// element at a random index through aref's path, and a full collection with
+// only that one live. The list has to be walked from the front to get to an
+// index, so it only gets a hundred random reads. The fixnum vector is never
+// looked inside of by the collector, so its collections should cost next to
+// nothing.
+
+#define LENGTH 1000000
+#define SUMS 20
+#define LIST_LOOKUPS 100
+
+static Runtime rt;
+static LishpSymbol *root_sym;
+
+static double seconds_since(struct timespec *start) {
+  struct timespec end;
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  return (double)(end.tv_sec - start->tv_sec) +
+         (double)(end.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+// the global binding is what keeps the sequence alive
+static void set_root(LishpForm form) {
+  Package *user = find_package(&rt, "USER");
+  bind_value(&rt, user->global, root_sym, form);
+}
+
+static LishpForm get_root() {
+  Package *user = find_package(&rt, "USER");
+  return symbol_value(&rt, user->global, root_sym);
+}
+
+static LishpForm build_list() {
+  set_root(NIL);
+  LishpCons *tail = NULL;
+
+  for (int64_t ind = 0; ind < LENGTH; ++ind) {
+    LishpCons *cons = ALLOCATE_OBJ(LishpCons, &rt);
+    *cons = CONS(FROM_FIXNUM(ind), NIL);
+
+    if (tail == NULL) {
+      set_root(FROM_OBJ(cons));
+    } else {
+      tail->cdr = FROM_OBJ(cons);
+      OBJ_WRITE_BARRIER(&rt, tail, cons);
+    }
+    tail = cons;
+  }
+
+  return get_root();
+}
+
+static LishpForm build_vector(ObjectType type) {
+  set_root(NIL);
+  LishpObject *vector = make_vector(&rt, type, LENGTH, FROM_FIXNUM(0));
+  for (int64_t ind = 0; ind < LENGTH; ++ind) {
+    vector_set(&rt, vector, ind, FROM_FIXNUM(ind));
+  }
+
+  set_root(FROM_OBJ(vector));
+  return get_root();
+}
+
+static int64_t nth_fixnum(LishpForm list, uint32_t index) {
+  while (index-- > 0) {
+    list = AS_OBJECT(LishpCons, list)->cdr;
+  }
+  return AS_FIXNUM(AS_OBJECT(LishpCons, list)->car);
+}
+
+static void run(const char *label, LishpForm sequence) {
+  int is_list = IS_OBJECT_TYPE(sequence, kCons);
+
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  int64_t sum = 0;
+  for (uint32_t round = 0; round < SUMS; ++round) {
+    if (is_list) {
+      for (LishpForm cur = sequence; IS_OBJECT_TYPE(cur, kCons);
+           cur = AS_OBJECT(LishpCons, cur)->cdr) {
+        sum += AS_FIXNUM(AS_OBJECT(LishpCons, cur)->car);
+      }
+    } else if (IS_OBJECT_TYPE(sequence, kSimpleVector)) {
+      LishpSimpleVector *vector = AS_OBJECT(LishpSimpleVector, sequence);
+      for (uint32_t ind = 0; ind < LENGTH; ++ind) {
+        sum += AS_FIXNUM(vector->elements[ind]);
+      }
+    } else {
+      LishpFixnumVector *vector = AS_OBJECT(LishpFixnumVector, sequence);
+      for (uint32_t ind = 0; ind < LENGTH; ++ind) {
+        sum += vector->elements[ind];
+      }
+    }
+  }
+  double sum_time = seconds_since(&start) / ((double)SUMS * LENGTH);
+
+  uint32_t lookups = is_list ? LIST_LOOKUPS : LENGTH;
+  uint32_t seed = 1;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (uint32_t ind = 0; ind < lookups; ++ind) {
+    seed = seed * 1103515245 + 12345;
+    uint32_t index = (seed >> 4) % LENGTH;
+    sum += is_list ? nth_fixnum(sequence, index)
+                   : AS_FIXNUM(vector_ref(&rt, sequence.object, index));
+  }
+  double lookup_time = seconds_since(&start) / lookups;
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  collect_garbage(rt.memory_manager);
+  double pause = seconds_since(&start);
+
+  printf("vectors: %-13s sum %6.2fns an element, random read %10.2fns, "
+         "collection %7.3fms (checksum %ld)\n",
+         label, sum_time * 1e9, lookup_time * 1e9, pause * 1e3, (long)sum);
+}
+
+int main() {
+  if (initialize_runtime(&rt) < 0) {
+    return 1;
+  }
+
+  root_sym = intern_symbol(&rt, find_package(&rt, "USER"), "*VECTORS*");
+
+  run("list", build_list());
+  run("simple-vector", build_vector(kSimpleVector));
+  run("fixnum-vector", build_vector(kFixnumVector));
+
+  set_root(NIL);
+  cleanup_runtime(&rt);
+
+  return 0;
+}
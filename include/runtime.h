@@ -3,63 +3,165 @@
 
 #include "runtime/memory_manager.h"
 #include "runtime/types.h"
+#include "runtime/vector_kernels.h"
 #include "util.h"
 
 typedef struct interpreter Interpreter;
+typedef struct allocation_profile AllocationProfile;
+
+DEFINE_HASH_MAP(SymbolValues, symbol_values, LishpSymbol *, LishpForm,
+                hash_pointer, POINTER_EQ)
+DEFINE_HASH_MAP(SymbolFunctions, symbol_functions, LishpSymbol *,
+                LishpFunction *, hash_pointer, POINTER_EQ)
 
 typedef struct environment {
   struct environment *parent;
-  const char *package;
+  struct package *package;
 
-  OrderedMap symbol_values;
-  OrderedMap symbol_functions;
+  SymbolValues symbol_values;
+  SymbolFunctions symbol_functions;
 } Environment;
 
+// what a package interns a symbol under. for a symbol in the table, chars is
+// its lexeme, but a lookup can point it into anything, like the reader's
+// token, so that nothing is copied unless the symbol is new
 typedef struct {
+  const char *chars; // NULL for gensyms without a name
+  uint32_t length;
+  uint32_t hash;
+} SymbolName;
+
+static inline uint32_t symbol_name_hash(const char *chars, uint32_t length) {
+  return chars == NULL ? 0 : (uint32_t)hash_bytes(chars, length);
+}
+
+static inline int symbol_name_eq(SymbolName l, SymbolName r) {
+  if (l.chars == NULL || r.chars == NULL) {
+    return l.chars == r.chars;
+  }
+  return l.length == r.length && memcmp(l.chars, r.chars, l.length) == 0;
+}
+
+#define SYMBOL_NAME_HASH(name) ((name).hash)
+
+DEFINE_HASH_MAP(InternedSymbols, interned_symbols, SymbolName, LishpSymbol *,
+                SYMBOL_NAME_HASH, symbol_name_eq)
+
+// packages are allocated on their own and never move, so symbols and
+// environments can point straight at the one they belong to
+typedef struct package {
   const char *name;
   Environment *global;
   LishpReadtable *current_readtable;
 
-  OrderedMap interned_symbols;
+  InternedSymbols interned_symbols;
   List exported_symbols;
 } Package;
 
+typedef struct {
+  uint64_t objects[OBJECT_TYPE_COUNT]; // indexed by ObjectType
+  uint64_t environments;
+} LiveObjectCounts;
+
 typedef struct runtime {
   void (*repl)(struct runtime *);
 
   MemoryManager *memory_manager;
   LishpReadtable *system_readtable;
-  List packages;
+  List packages; // of Package *
   Interpreter *interpreter;
+  LiveObjectCounts *live_counts; // tallied while count_live_objects collects
+  AllocationProfile *profile; // NULL unless LISHP_ALLOC_PROFILE is set
+  const VectorKernels *kernels; // what the numeric array built-ins run
+  // how many functions have ever been bound in a lexical environment. while
+  // there are none, function lookups go straight to the symbol
+  uint64_t lexical_functions;
 } Runtime;
 
 int initialize_runtime(Runtime *rt);
 int cleanup_runtime(Runtime *rt);
 Package *find_package(Runtime *rt, const char *name);
 
-#define ALLOCATE_OBJ(t, rt) ((t *)_allocate_obj(rt, sizeof(t)))
+// does a full collection, counting everything that survives it by type
+void count_live_objects(Runtime *rt, LiveObjectCounts *counts);
+
+// what the allocation profile sorts allocations into. the objects come first,
+// with their ObjectType as the kind
+typedef enum {
+  kAllocEnvironment = OBJECT_TYPE_COUNT,
+  kAllocText, // strings that belong to strings and symbols
+  kAllocOther,
+} AllocationKind;
+
+#define ALLOCATION_KIND_COUNT (kAllocOther + 1)
+#define ALLOCATION_KIND(t)                                                     \
+  _Generic((t *)NULL,                                                          \
+      LishpCons *: kCons,                                                      \
+      LishpString *: kString,                                                  \
+      LishpSymbol *: kSymbol,                                                  \
+      LishpFunction *: kFunction,                                              \
+      LishpReadtable *: kReadtable,                                            \
+      LishpStream *: kStream,                                                  \
+      LishpDoubleFloat *: kDoubleFloat,                                        \
+      LishpHashTable *: kHashTable,                                            \
+      Environment *: kAllocEnvironment,                                        \
+      default: kAllocOther)
+
+#define ALLOCATE_OBJ(t, rt)                                                    \
+  ((t *)_allocate_obj(rt, sizeof(t), ALLOCATION_KIND(t)))
 #define DEALLOCATE_OBJ(t, o, rt) (_deallocate_obj(rt, (o), sizeof(t)))
 #define OBJ_MARK_USED(rt, o) (_obj_mark_used(rt, (LishpObject *)(o)))
 #define FORM_MARK_USED(rt, f)                                                  \
   do {                                                                         \
-    if ((f).type == kObject) {                                                 \
+    if (OBJECT_P(f)) {                                                         \
       OBJ_MARK_USED(rt, (f).object);                                           \
     }                                                                          \
   } while (0)
 
-void *_allocate_obj(Runtime *rt, uint32_t size);
+// marks the object that a form stored at f refers to, while letting compaction
+// move it and update f to match. only use this where f is the sole place that
+// reference is kept, outside of the C stack
+#define FORM_MARK_SLOT(rt, f)                                                  \
+  do {                                                                         \
+    if (OBJECT_P(f)) {                                                         \
+      _obj_mark_slot(rt, &(f).object);                                         \
+    }                                                                          \
+  } while (0)
+
+void *_allocate_obj(Runtime *rt, uint32_t size, uint32_t kind);
 const char *allocate_str(Runtime *rt, const char *to_copy);
 void _deallocate_obj(Runtime *rt, void *ptr, uint32_t size);
 void _obj_mark_used(Runtime *rt, LishpObject *obj);
 void other_mark_used(Runtime *rt, void *obj);
+void _obj_mark_slot(Runtime *rt, LishpObject **slot);
+void other_mark_slot(Runtime *rt, void **slot);
+
+// write barriers, used after storing a reference into an object that may have
+// been allocated or marked before the value it now points to
+#define OBJ_WRITE_BARRIER(rt, c, o)                                            \
+  (_obj_write_barrier(rt, (c), (LishpObject *)(o)))
+#define FORM_WRITE_BARRIER(rt, c, f)                                           \
+  do {                                                                         \
+    if (OBJECT_P(f)) {                                                         \
+      OBJ_WRITE_BARRIER(rt, c, (f).object);                                    \
+    }                                                                          \
+  } while (0)
+
+void _obj_write_barrier(Runtime *rt, void *container, LishpObject *obj);
+void other_write_barrier(Runtime *rt, void *container, void *obj);
 
 Environment *allocate_env(Runtime *rt, Environment *parent);
 
 LishpSymbol *intern_symbol(Runtime *rt, Package *p, const char *lexeme);
+// the same, for a name that needn't be zero terminated
+LishpSymbol *intern_chars(Runtime *rt, Package *p, const char *chars,
+                          uint32_t length);
 LishpSymbol *gensym(Runtime *rt, Package *p, const char *lexeme);
 
-void bind_value(Environment *env, LishpSymbol *sym, LishpForm val);
-void bind_function(Environment *env, LishpSymbol *sym, LishpFunction *fn);
+void bind_value(Runtime *rt, Environment *env, LishpSymbol *sym,
+                LishpForm val);
+void bind_function(Runtime *rt, Environment *env, LishpSymbol *sym,
+                   LishpFunction *fn);
 LishpForm symbol_value(Runtime *rt, Environment *env, LishpSymbol *sym);
 LishpFunction *symbol_function(Runtime *rt, Environment *env, LishpSymbol *sym);
 void environment_mark_used(Runtime *rt, Environment *env);
@@ -0,0 +1,21 @@
+#ifndef runtime_allocation_profile_
+#define runtime_allocation_profile_
+
+#include <stdio.h>
+
+#include "runtime.h"
+
+// Counts every allocation the runtime makes by kind and by the Lisp function
+// that was running, and at each collection how many of the allocations made
+// since the last one survived it.
+
+int initialize_profile(AllocationProfile **pprofile, Runtime *rt);
+void cleanup_profile(AllocationProfile **pprofile);
+
+void profile_allocation(AllocationProfile *profile, void *ptr, uint32_t size,
+                        uint32_t kind);
+void profile_deallocation(AllocationProfile *profile, void *ptr);
+
+void print_profile(AllocationProfile *profile, FILE *out);
+
+#endif
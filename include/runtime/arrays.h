@@ -0,0 +1,52 @@
+#ifndef runtime_arrays_
+#define runtime_arrays_
+
+#include "runtime.h"
+#include "runtime/types.h"
+
+// Vectors, both the simple kind and the ones specialized to hold fixnums,
+// double-floats, characters or bits unboxed. Whatever is stored in a
+// specialized vector has to be of its element type.
+
+#define VECTOR_P(f)                                                            \
+  (OBJECT_P(f) && (f).object->type >= kSimpleVector &&                         \
+   (f).object->type <= kBitVector)
+
+// type is the ObjectType of the vector to make, and every element starts out
+// as initial. NULL if a vector that long would be bigger than can be
+// allocated
+LishpObject *make_vector(Runtime *rt, ObjectType type, uint32_t length,
+                         LishpForm initial);
+
+uint32_t vector_length(LishpObject *vector);
+
+// reading a double-float may have to box it
+LishpForm vector_ref(Runtime *rt, LishpObject *vector, uint32_t index);
+void vector_set(Runtime *rt, LishpObject *vector, uint32_t index,
+                LishpForm value);
+
+// sets the elements from start up to end to value
+void vector_fill(Runtime *rt, LishpObject *vector, LishpForm value,
+                 uint32_t start, uint32_t end);
+// copies count elements as if through a temporary, so the two ranges can
+// overlap. the vectors can be of different types as long as each element
+// fits in the target
+void vector_replace(Runtime *rt, LishpObject *target, uint32_t target_start,
+                    LishpObject *source, uint32_t source_start,
+                    uint32_t count);
+
+// The numeric built-ins only take fixnum and double-float vectors, and run
+// on whichever VectorKernels the runtime picked. The sum of a fixnum vector
+// may be a bignum, while adding or multiplying two of them fails if any
+// element of the result isn't a fixnum.
+
+LishpForm vector_sum(Runtime *rt, LishpObject *vector);
+// double-float vectors only
+LishpForm vector_dot(Runtime *rt, LishpObject *x, LishpObject *y);
+LishpForm vector_min(Runtime *rt, LishpObject *vector);
+LishpForm vector_max(Runtime *rt, LishpObject *vector);
+// a new vector of the same type as x and y
+LishpObject *vector_add(Runtime *rt, LishpObject *x, LishpObject *y);
+LishpObject *vector_multiply(Runtime *rt, LishpObject *x, LishpObject *y);
+
+#endif
@@ -8,7 +8,35 @@ INHERENT_FN(system_read_open_paren);
 INHERENT_FN(system_read_close_paren);
 INHERENT_FN(system_read_double_quote);
 INHERENT_FN(system_read_single_quote);
+INHERENT_FN(system_gc_stats);
+INHERENT_FN(system_alloc_profile);
+INHERENT_FN(system_aset);
+INHERENT_FN(system_puthash);
+INHERENT_FN(system_vector_sum);
+INHERENT_FN(system_vector_dot);
+INHERENT_FN(system_vector_min);
+INHERENT_FN(system_vector_max);
+INHERENT_FN(system_vector_add);
+INHERENT_FN(system_vector_multiply);
 INHERENT_FN(common_lisp_read);
 INHERENT_FN(common_lisp_format);
+INHERENT_FN(common_lisp_room);
+INHERENT_FN(common_lisp_plus);
+INHERENT_FN(common_lisp_minus);
+INHERENT_FN(common_lisp_times);
+INHERENT_FN(common_lisp_divide);
+INHERENT_FN(common_lisp_floor);
+INHERENT_FN(common_lisp_mod);
+INHERENT_FN(common_lisp_float);
+INHERENT_FN(common_lisp_make_array);
+INHERENT_FN(common_lisp_aref);
+INHERENT_FN(common_lisp_length);
+INHERENT_FN(common_lisp_fill);
+INHERENT_FN(common_lisp_replace);
+INHERENT_FN(common_lisp_make_hash_table);
+INHERENT_FN(common_lisp_gethash);
+INHERENT_FN(common_lisp_remhash);
+INHERENT_FN(common_lisp_maphash);
+INHERENT_FN(common_lisp_hash_table_count);
 
 #endif
@@ -0,0 +1,36 @@
+#ifndef runtime_hash_tables_
+#define runtime_hash_tables_
+
+#include "runtime.h"
+#include "runtime/types.h"
+
+// Hash tables, open addressed with linear probing. Each entry keeps its hash,
+// so growing never has to look at a key again, and removed entries are left
+// as markers that the next resize drops.
+//
+// Symbols, numbers and, under EQUAL, strings and lists of them are hashed by
+// what they hold, so they hash the same wherever they are. Anything else is
+// hashed by address, and compaction can move it, so a table with any such
+// keys rehashes the first time it is used after a compaction.
+
+#define HASH_TABLE_P(f) IS_OBJECT_TYPE(f, kHashTable)
+
+int eql_p(LishpForm l, LishpForm r);
+int equal_p(LishpForm l, LishpForm r);
+
+// size is how many entries it should hold before it first has to grow
+LishpHashTable *make_hash_table(Runtime *rt, HashTableTest test,
+                                uint32_t size);
+
+// these may rehash or grow the table, which allocates, so the key and value
+// have to be reachable by the collector
+
+// 1 and the value in *value if the key is there, otherwise 0
+int hash_table_get(Runtime *rt, LishpHashTable *table, LishpForm key,
+                   LishpForm *value);
+void hash_table_put(Runtime *rt, LishpHashTable *table, LishpForm key,
+                    LishpForm value);
+// 1 if the key was there
+int hash_table_remove(Runtime *rt, LishpHashTable *table, LishpForm key);
+
+#endif
@@ -22,6 +22,8 @@ int bind_symbol_value(Interpreter *interpreter, LishpSymbol *sym,
 
 Runtime *get_runtime(Interpreter *interpreter);
 Environment *get_current_environment(Interpreter *interpreter);
+// the innermost function being called, NULL outside of any call
+LishpFunction *current_function(Interpreter *interpreter);
 
 void interpreter_mark_used_objs(Interpreter *interpreter);
 
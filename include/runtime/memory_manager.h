@@ -5,18 +5,136 @@
 
 struct runtime;
 typedef void (*RuntimeMarker)(struct runtime *);
+// marks everything that an allocation references, NULL for allocations that
+// don't reference anything
+typedef void (*Tracer)(struct runtime *, void *);
+// called by every collection once it is done marking, before anything is
+// swept or moved
+typedef void (*CollectionHook)(struct runtime *);
 
 typedef struct manager MemoryManager;
 
+typedef struct {
+  uint64_t max_heap_size; // in bytes, 0 means the heap can grow without limit
+  uint64_t nursery_size;  // bytes allocated between minor collections, 0
+                          // turns the nursery off
+  uint64_t mark_slice_us; // longest a slice of incremental marking may run,
+                          // 0 marks everything in a single pause
+  uint64_t gc_growth_percent; // how much the old heap may grow between full
+                              // collections, as a percentage of what was
+                              // live after the last one
+  uint64_t compact; // non-zero lets compact_if_fragmented move allocations
+  uint64_t mark_threads; // threads that share the marking of a full
+                         // collection, counting the one collecting. 0 is
+                         // one per core
+} ManagerSettings;
+
+// pauses are counted in buckets by powers of ten: under 10us, under 100us,
+// and so on up to the last bucket, for everything 100ms and over
+#define GC_PAUSE_BUCKETS 6
+
+typedef struct {
+  uint64_t count;
+  uint64_t total_ns;
+  uint64_t max_ns;
+  uint64_t histogram[GC_PAUSE_BUCKETS];
+} GcPauseTimes;
+
+typedef struct {
+  uint64_t full_collections;
+  uint64_t minor_collections;
+  uint64_t compactions; // full collections that also moved allocations
+  uint64_t live_bytes;            // after the last full collection
+  uint64_t reclaimed_bytes;       // by the last full collection
+  uint64_t minor_reclaimed_bytes; // by the last minor collection
+  uint64_t next_gc_bytes; // old heap size that starts the next full collection
+} GcCycleStats;
+
+typedef struct {
+  GcCycleStats cycles;
+  GcPauseTimes pauses;
+  uint64_t allocated_bytes; // over the life of the manager
+  uint64_t reclaimed_bytes; // over the life of the manager
+  uint64_t heap_size;
+  uint64_t large_objects; // each mapped on their own, outside of the blocks
+  uint64_t large_bytes;   // mapped for the large objects, part of heap_size
+  // fragmentation of the free space, which includes the rest of the
+  // nursery's current hole
+  uint64_t free_bytes;
+  uint64_t free_chunks;
+  uint64_t largest_free_chunk;
+} GcStats;
+
+#define MEGABYTES(n) ((uint64_t)(n) << 20)
+#define GIGABYTES(n) ((uint64_t)(n) << 30)
+#define DEFAULT_MANAGER_SETTINGS                                               \
+  ((ManagerSettings){.max_heap_size = GIGABYTES(1),                            \
+                     .nursery_size = MEGABYTES(1),                             \
+                     .mark_slice_us = 0,                                       \
+                     .gc_growth_percent = 100,                                 \
+                     .compact = 0,                                             \
+                     .mark_threads = 0})
+
 int initialize_manager(MemoryManager **pmanager, RuntimeMarker runtime_marker,
-                       struct runtime *rt);
+                       struct runtime *rt, ManagerSettings settings);
 int cleanup_manager(MemoryManager **pmanager, uint32_t *final_allocated);
 
+// the most that can be allocated at once. a chunk's size, counting its header
+// and the rounding up to the alignment, has to fit in 32 bits, so allocate
+// returns NULL for anything bigger
+#define MAX_ALLOCATION_SIZE (UINT32_MAX - 64)
+
 void *allocate(MemoryManager *manager, uint32_t size);
 void deallocate(MemoryManager *manager, void *ptr, uint32_t size);
 
-void mark_used(MemoryManager *manager, void *ptr);
+// a full collection that sweeps the whole heap before returning. collections
+// started by allocating leave the sweeping to later allocations instead
+void collect_garbage(MemoryManager *manager);
 
+// a full collection that also slides the surviving allocations together,
+// giving back blocks that end up empty. allocations reported with mark_used,
+// or pointed at from the C stack, are pinned where they are, and every
+// reference reported with mark_slot is updated. only call these where there
+// are no other references to allocations, such as in malloc'd memory that
+// isn't traced. the manager has to be used from the thread that created it
+void compact_garbage(MemoryManager *manager);
+// compacts when compaction is turned on, and enough of the heap is free space
+// stuck between live allocations
+void compact_if_fragmented(MemoryManager *manager);
+
+// while paused, allocations never trigger a collection. use this around code
+// that holds freshly allocated objects which are not yet reachable
+void pause_gc(MemoryManager *manager);
+void resume_gc(MemoryManager *manager);
+
+// marks an allocation as used. the tracer is called on it later, rather than
+// recursing, so marking can be split into slices. old allocations are skipped
+// in a minor collection
+void mark_used(MemoryManager *manager, void *ptr, Tracer tracer);
+// marks the allocation that *slot points at as used, like mark_used, but
+// tells the manager where the reference is, so that compaction can move the
+// allocation and update *slot to match. slot has to stay put until marking is
+// done
+void mark_slot(MemoryManager *manager, void **slot, Tracer tracer);
+
+// write barrier, call this after storing a pointer to value inside of the
+// allocation container, with the tracer for value
+void write_barrier(MemoryManager *manager, void *container, void *value,
+                   Tracer tracer);
+
+void set_collection_hook(MemoryManager *manager, CollectionHook hook);
+// whether an allocation was marked by the collection that called the
+// CollectionHook. a minor collection never marks old allocations
+int inspect_marked(MemoryManager *manager, void *ptr);
+
+// inspect_allocation and inspect_gc_stats finish any sweeping left over from
+// the last full collection first, so that its garbage isn't counted
 uint32_t inspect_allocation(MemoryManager *manager);
+uint64_t inspect_heap_size(MemoryManager *manager);
+GcStats inspect_gc_stats(MemoryManager *manager);
+
+// how many times allocations have been moved. anything keyed by address has
+// to be redone once this changes
+uint64_t inspect_compactions(MemoryManager *manager);
 
 #endif
@@ -0,0 +1,67 @@
+#ifndef runtime_numbers_
+#define runtime_numbers_
+
+#include <stdio.h>
+
+#include "runtime.h"
+#include "runtime/types.h"
+
+// Integer arithmetic. Fixnums are handled without leaving the fixnum tier
+// unless the result doesn't fit, in which case it comes back as a bignum, and
+// bignum results that shrink back into the fixnum range come back as fixnums.
+// The arguments have to be reachable by the collector, since the result may
+// be allocated.
+
+#define INTEGER_P(f) (FIXNUM_P(f) || IS_OBJECT_TYPE(f, kBignum))
+#define DOUBLE_FLOAT_P(f)                                                      \
+  (IMMEDIATE_FLOAT_P(f) || IS_OBJECT_TYPE(f, kDoubleFloat))
+#define NUMBER_P(f) (INTEGER_P(f) || DOUBLE_FLOAT_P(f))
+
+LishpForm integer_add(Runtime *rt, LishpForm l, LishpForm r);
+LishpForm integer_subtract(Runtime *rt, LishpForm l, LishpForm r);
+LishpForm integer_multiply(Runtime *rt, LishpForm l, LishpForm r);
+LishpForm integer_negate(Runtime *rt, LishpForm f);
+
+// the quotient rounded towards negative infinity, and the remainder that goes
+// with it, which has the sign of the divisor
+LishpForm integer_floor(Runtime *rt, LishpForm n, LishpForm d);
+LishpForm integer_mod(Runtime *rt, LishpForm n, LishpForm d);
+
+// FIXME: there are no ratios yet, so d has to divide n exactly
+LishpForm integer_divide(Runtime *rt, LishpForm n, LishpForm d);
+
+LishpForm integer_from_int64(Runtime *rt, int64_t value);
+LishpForm integer_from_int128(Runtime *rt, __int128 value);
+// value has to be a whole number
+LishpForm integer_from_double(Runtime *rt, double value);
+
+// Double-floats are immediates whenever they fit, which is every one with a
+// magnitude between about 6e-39 and 7e38, and zero. Only the rest are boxed,
+// so arithmetic on them rarely allocates.
+
+LishpForm make_double(Runtime *rt, double value);
+// converts integers, so it takes any number
+double as_double(LishpForm f);
+
+// the same as the integer versions when both sides are integers, and in
+// double-floats when either one is a double-float
+LishpForm number_add(Runtime *rt, LishpForm l, LishpForm r);
+LishpForm number_subtract(Runtime *rt, LishpForm l, LishpForm r);
+LishpForm number_multiply(Runtime *rt, LishpForm l, LishpForm r);
+LishpForm number_divide(Runtime *rt, LishpForm l, LishpForm r);
+LishpForm number_negate(Runtime *rt, LishpForm f);
+LishpForm number_floor(Runtime *rt, LishpForm n, LishpForm d);
+LishpForm number_mod(Runtime *rt, LishpForm n, LishpForm d);
+// either kind of zero, which nothing can be divided by
+int number_zerop(LishpForm f);
+
+// reads an integer in decimal from an optional sign, digits and an optional
+// trailing decimal point
+LishpForm parse_integer(Runtime *rt, const char *text, uint32_t length);
+// reads a float, with any of the exponent markers e, s, f, d or l
+LishpForm parse_double(Runtime *rt, const char *text, uint32_t length);
+
+void print_bignum(LishpBignum *big, FILE *out);
+void print_double(double value, FILE *out);
+
+#endif
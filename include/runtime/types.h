@@ -7,17 +7,59 @@
 
 #include "util.h"
 
-#define NIL ((LishpForm){.type = kNil, {.object = NULL}})
-#define T ((LishpForm){.type = kT, {.object = NULL}})
-
-#define FROM_FIXNUM(f) ((LishpForm){.type = kFixnum, {.fixnum = (f)}})
-#define FROM_CHAR(c) ((LishpForm){.type = kChar, {.ch = (c)}})
-#define FROM_OBJ(o)                                                            \
-  ((LishpForm){.type = kObject, {.object = ((LishpObject *)o)}})
-
-#define NIL_P(form) ((form).type == kNil)
-#define T_P(form) ((form).type == kT)
-#define OBJECT_P(form) ((form).type == kObject)
+// A form is a single tagged word. Objects are always 8 byte aligned, so a form
+// with the low three bits clear is a pointer to one, and any other form is an
+// immediate. Fixnums have 01 in the low two bits and a signed 62 bit value
+// above them, characters are tagged 010, double-floats that can be packed
+// into 61 bits are tagged 011, and NIL and T are constants tagged 110.
+#define FORM_TAG_BITS 3
+#define FORM_TAG_MASK 7
+#define FIXNUM_TAG_MASK 3
+#define FIXNUM_TAG 1
+#define CHAR_TAG 2
+#define FLOAT_TAG 3
+#define CONSTANT_TAG 6
+
+#define NIL_BITS CONSTANT_TAG
+#define T_BITS ((1 << FORM_TAG_BITS) | CONSTANT_TAG)
+
+// what an empty value cell holds. it's never handed to Lisp code
+#define UNBOUND_BITS ((2 << FORM_TAG_BITS) | CONSTANT_TAG)
+
+#define NIL ((LishpForm){.bits = NIL_BITS})
+#define T ((LishpForm){.bits = T_BITS})
+#define UNBOUND ((LishpForm){.bits = UNBOUND_BITS})
+
+#define FROM_FIXNUM(f)                                                         \
+  ((LishpForm){.bits = ((uintptr_t)(int64_t)(f) << 2) | FIXNUM_TAG})
+#define FROM_CHAR(c)                                                           \
+  ((LishpForm){.bits = ((uintptr_t)(unsigned char)(c) << FORM_TAG_BITS) |     \
+                       CHAR_TAG})
+#define FROM_OBJ(o) ((LishpForm){.object = ((LishpObject *)(o))})
+
+#define NIL_P(form) ((form).bits == NIL_BITS)
+#define T_P(form) ((form).bits == T_BITS)
+#define UNBOUND_P(form) ((form).bits == UNBOUND_BITS)
+#define OBJECT_P(form) (((form).bits & FORM_TAG_MASK) == 0)
+#define FIXNUM_P(form) (((form).bits & FIXNUM_TAG_MASK) == FIXNUM_TAG)
+#define CHAR_P(form) (((form).bits & FORM_TAG_MASK) == CHAR_TAG)
+#define IMMEDIATE_FLOAT_P(form) (((form).bits & FORM_TAG_MASK) == FLOAT_TAG)
+#define EQ_P(l, r) ((l).bits == (r).bits)
+
+#define FORM_TYPE(form)                                                        \
+  (OBJECT_P(form)            ? kObject                                         \
+   : FIXNUM_P(form)          ? kFixnum                                         \
+   : CHAR_P(form)            ? kChar                                           \
+   : IMMEDIATE_FLOAT_P(form) ? kImmediateFloat                                 \
+   : NIL_P(form)             ? kNil                                            \
+                             : kT)
+
+#define MOST_POSITIVE_FIXNUM (((int64_t)1 << 61) - 1)
+#define MOST_NEGATIVE_FIXNUM (-((int64_t)1 << 61))
+
+// the shift is arithmetic, so negative fixnums keep their sign
+#define AS_FIXNUM(form) ((int64_t)(form).bits >> 2)
+#define AS_CHAR(form) ((char)((form).bits >> FORM_TAG_BITS))
 
 #define IS_OBJECT_TYPE(f, t) (OBJECT_P(f) && ((f).object->type == t))
 
@@ -28,12 +70,22 @@
 
 #define CONS(a, d) ((LishpCons){.obj = {.type = kCons}, .car = (a), .cdr = (d)})
 #define STRING(l) ((LishpString){.obj = {.type = kString}, .lexeme = (l)})
-#define SYMBOL(l, p)                                                           \
-  ((LishpSymbol){                                                              \
-      .obj = {.type = kSymbol}, .lexeme = (l), .package = (p), .id = 0})
-#define GENSYM(l, p, i)                                                        \
-  ((LishpSymbol){                                                              \
-      .obj = {.type = kSymbol}, .lexeme = (l), .package = (p), .id = (i)})
+#define SYMBOL(l, p, h)                                                        \
+  ((LishpSymbol){.obj = {.type = kSymbol},                                     \
+                 .lexeme = (l),                                                \
+                 .package = (p),                                               \
+                 .id = 0,                                                      \
+                 .hash = (h),                                                  \
+                 .value = UNBOUND,                                             \
+                 .function = NULL})
+#define GENSYM(l, p, i, h)                                                     \
+  ((LishpSymbol){.obj = {.type = kSymbol},                                     \
+                 .lexeme = (l),                                                \
+                 .package = (p),                                               \
+                 .id = (i),                                                    \
+                 .hash = (h),                                                  \
+                 .value = UNBOUND,                                             \
+                 .function = NULL})
 #define FUNCTION_INHERENT(p)                                                   \
   ((LishpFunction){                                                            \
       .obj = {.type = kFunction}, .type = kInherent, {.inherent_fn = (p)}})
@@ -78,11 +130,22 @@ typedef enum {
   kFunction,
   kReadtable,
   kStream,
+  kBignum,
+  kDoubleFloat,
+  kSimpleVector,
+  kFixnumVector,
+  kDoubleFloatVector,
+  kCharacterVector,
+  kBitVector,
+  kHashTable,
 } ObjectType;
 
+#define OBJECT_TYPE_COUNT (kHashTable + 1)
+
 typedef enum {
   kFixnum,
   kChar,
+  kImmediateFloat,
   kNil,
   kT,
   kObject,
@@ -111,21 +174,25 @@ typedef enum {
   kInputOutput,
 } StreamType;
 
+typedef enum {
+  kTestEq,
+  kTestEql,
+  kTestEqual,
+} HashTableTest;
+
 // types
 
 typedef struct {
   ObjectType type;
 } LishpObject;
 
-typedef struct {
-  FormType type;
-  union {
-    uint32_t fixnum;
-    char ch;
-    LishpObject *object;
-  };
+typedef union {
+  uintptr_t bits;
+  LishpObject *object; // the same word, when the form is an object
 } LishpForm;
 
+DEFINE_LIST(FormList, form_list, LishpForm)
+
 typedef struct {
   LishpObject obj;
   LishpForm car;
@@ -142,12 +209,21 @@ typedef struct {
   const char *lexeme;
 } LishpString;
 
+struct package;
+struct lishp_function;
+
 typedef struct {
   LishpObject obj;
   const char *lexeme;
-  const char *package; // FIXME: how should I reference packages?
+  struct package *package; // the one it was interned in
   uint32_t id; // NOTE: if id == 0, it's not unique, but if it's non-zero it has
                // been gensym'ed.
+  uint32_t hash; // of the lexeme, see symbol_name_hash
+
+  // the global value and function, shared by every package the symbol is
+  // interned in. lexical bindings live in environments instead
+  LishpForm value; // UNBOUND if it has no global value
+  struct lishp_function *function; // NULL if it has no global function
 } LishpSymbol;
 
 typedef struct {
@@ -170,7 +246,7 @@ typedef LishpFunctionReturn (*InherentFnPtr)(struct interpreter *,
 #define INHERENT_FN(name)                                                      \
   LishpFunctionReturn name(struct interpreter *interpreter, LishpList args)
 
-typedef struct {
+typedef struct lishp_function {
   LishpObject obj;
   FunctionType type;
   union {
@@ -181,7 +257,7 @@ typedef struct {
 typedef struct {
   LishpObject obj;
   ReadtableCase readcase;
-  OrderedMap reader_macros;
+  HashMap reader_macros;
 } LishpReadtable;
 
 typedef struct {
@@ -190,7 +266,79 @@ typedef struct {
   FILE *file;
 } LishpStream;
 
+// an integer too big to be a fixnum. the magnitude is kept least significant
+// limb first without any leading zero limbs, and an integer that fits in a
+// fixnum is never a bignum, so each integer has only the one representation
+typedef struct {
+  LishpObject obj;
+  uint32_t negative;
+  uint32_t length; // in limbs
+  uint64_t limbs[];
+} LishpBignum;
+
+// a double-float that doesn't fit in an immediate, which is one too big, too
+// small, infinite or not a number
+typedef struct {
+  LishpObject obj;
+  double value;
+} LishpDoubleFloat;
+
+// one dimensional arrays. a simple vector holds any forms, and is the only
+// one the collector looks inside of; the specialized ones keep their elements
+// unboxed, one after the other
+typedef struct {
+  LishpObject obj;
+  uint32_t length;
+  LishpForm elements[];
+} LishpSimpleVector;
+
+typedef struct {
+  LishpObject obj;
+  uint32_t length;
+  int64_t elements[];
+} LishpFixnumVector;
+
+typedef struct {
+  LishpObject obj;
+  uint32_t length;
+  double elements[];
+} LishpDoubleFloatVector;
+
+typedef struct {
+  LishpObject obj;
+  uint32_t length;
+  char elements[];
+} LishpCharacterVector;
+
+typedef struct {
+  LishpObject obj;
+  uint32_t length; // in bits
+  uint64_t words[];
+} LishpBitVector;
+
+// one slot of a hash table. the hash is cached with the top bit set, which
+// tells a live entry apart from an empty slot (0) or a deleted one (1)
+typedef struct {
+  uint64_t hash;
+  LishpForm key;
+  LishpForm value;
+} HashTableEntry;
+
+#define HASH_ENTRY_LIVE_P(e) (((e)->hash >> 63) != 0)
+
+typedef struct {
+  LishpObject obj;
+  HashTableTest test;
+  uint32_t count;
+  uint32_t deleted;  // slots left behind by remhash, until the next resize
+  uint32_t capacity; // a power of two
+  uint32_t address_keys; // keys whose hash depends on where something is
+  uint64_t hashed_at; // compactions when the address hashes were taken
+  HashTableEntry *entries;
+} LishpHashTable;
+
 void print_form(LishpForm);
+const char *object_type_name(ObjectType type);
 int form_cmp(LishpForm l, LishpForm r);
 
 #endif
@@ -0,0 +1,52 @@
+#ifndef runtime_vector_kernels_
+#define runtime_vector_kernels_
+
+#include <stdint.h>
+
+// The loops behind the numeric array built-ins, written once as plain C and
+// again with SSE2 and AVX2 intrinsics. Which set is used is picked when the
+// runtime starts, from what the CPU supports. The vector versions add doubles
+// up in a different order, so their sums can differ from the plain ones in
+// the last few bits, and what min and max make of NaNs is unspecified.
+
+typedef enum {
+  kIsaScalar,
+  kIsaSse2,
+  kIsaAvx2,
+} VectorIsa;
+
+#define VECTOR_ISA_COUNT (kIsaAvx2 + 1)
+
+typedef struct {
+  const char *name;
+
+  double (*sum_doubles)(const double *x, uint32_t n);
+  double (*dot_doubles)(const double *x, const double *y, uint32_t n);
+  void (*min_max_doubles)(const double *x, uint32_t n, double *min,
+                          double *max);
+  void (*add_doubles)(double *out, const double *x, const double *y,
+                      uint32_t n);
+  void (*multiply_doubles)(double *out, const double *x, const double *y,
+                           uint32_t n);
+
+  // fixnums can't overflow the sum, since it's 128 bits. the elementwise
+  // ones return -1 if any result doesn't fit in a fixnum
+  __int128 (*sum_fixnums)(const int64_t *x, uint32_t n);
+  void (*min_max_fixnums)(const int64_t *x, uint32_t n, int64_t *min,
+                          int64_t *max);
+  int (*add_fixnums)(int64_t *out, const int64_t *x, const int64_t *y,
+                     uint32_t n);
+  int (*multiply_fixnums)(int64_t *out, const int64_t *x, const int64_t *y,
+                          uint32_t n);
+
+  // for doubles and fixnums alike
+  void (*fill_words)(uint64_t *out, uint32_t n, uint64_t value);
+} VectorKernels;
+
+// NULL if the CPU doesn't support isa
+const VectorKernels *vector_kernels(VectorIsa isa);
+
+// the widest set the CPU supports, and no wider than widest
+const VectorKernels *select_vector_kernels(VectorIsa widest);
+
+#endif
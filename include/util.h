@@ -2,11 +2,13 @@
 #define util_
 
 #include <stdint.h>
+#include <stdlib.h>
 
 #define INITIAL_CAPACITY 8
 #define NEXT_CAPACITY(cap) ((cap) == 0 ? INITIAL_CAPACITY : (2 * (cap)))
 
 void shift_items(void *items, uint32_t size, uint32_t count, int direction);
+int parse_byte_size(const char *str, uint64_t *result);
 
 typedef struct {
   uint32_t size;
@@ -16,6 +18,10 @@ typedef struct {
 
 typedef int (*ListIterator)(void *arg, void *obj);
 
+// makes room for at least needed items of the given size, growing the same
+// way a List does
+int grow_items(void **items, uint32_t *cap, uint32_t size, uint32_t needed);
+
 int list_init(List *l);
 int list_clear(List *l);
 int list_push(List *l, uint32_t size, void *item);
@@ -54,4 +60,309 @@ int map_ref(OrderedMap *m, uint32_t key_size, uint32_t val_size, void *key,
 int map_foreach(OrderedMap *m, uint32_t key_size, uint32_t val_size,
                 MapIterator it_fn, void *arg);
 
+// for maps that are only ever looked up by key, open addressed with linear
+// probing. the same calls as OrderedMap, but foreach goes in no useful order,
+// and a reference into it only lasts until the next insert
+
+typedef uint32_t (*Hasher)(void *key);
+
+#define HASH_MAP_EMPTY 0
+#define HASH_MAP_DELETED 1
+// grows past three quarters full, counting the removed slots
+#define HASH_MAP_OVER_LOAD(count, cap)                                         \
+  (4 * (uint64_t)(count) > 3 * (uint64_t)(cap))
+
+typedef struct {
+  Hasher hash_fn;
+  Comparator cmp_fn;
+  uint32_t size;
+  uint32_t deleted;
+  uint32_t cap;
+  uint32_t *hashes; // one for each slot, HASH_MAP_EMPTY or HASH_MAP_DELETED
+                    // if there's nothing in it
+  void *items;      // follows the hashes, in the same allocation
+} HashMap;
+
+int hash_map_init(HashMap *m, Hasher hash_fn, Comparator cmp_fn);
+int hash_map_clear(HashMap *m);
+int hash_map_insert(HashMap *m, uint32_t key_size, uint32_t val_size,
+                    void *key, void *value);
+int hash_map_remove(HashMap *m, uint32_t key_size, uint32_t val_size,
+                    void *key, void *value);
+int hash_map_get(HashMap *m, uint32_t key_size, uint32_t val_size, void *key,
+                 void *value);
+int hash_map_ref(HashMap *m, uint32_t key_size, uint32_t val_size, void *key,
+                 void **pvalue);
+int hash_map_foreach(HashMap *m, uint32_t key_size, uint32_t val_size,
+                     MapIterator it_fn, void *arg);
+
+// for writing hashers with. these are 64 bits, and a hasher can take either
+// half of them
+
+// the splitmix64 finalizer, so that nearby addresses and small integers end
+// up spread over the whole table
+static inline uint64_t hash_word(uint64_t word) {
+  word ^= word >> 30;
+  word *= 0xbf58476d1ce4e5b9;
+  word ^= word >> 27;
+  word *= 0x94d049bb133111eb;
+  word ^= word >> 31;
+
+  return word;
+}
+
+static inline uint32_t hash_pointer(const void *ptr) {
+  return hash_word((uintptr_t)ptr);
+}
+
+uint64_t hash_bytes(const void *bytes, uint64_t len);
+
+#define POINTER_EQ(l, r) ((l) == (r))
+
+// Typed containers, for the ones on hot paths. They have the same calls and
+// return values as List and HashMap, but are generated for one element type,
+// so everything is inline and moves elements by assignment, and the compiler
+// can see through all of it. Elements go in and out by value.
+//
+//   DEFINE_LIST(FormList, form_list, LishpForm)
+//
+// makes a FormList, along with form_list_push(&list, form) and the rest, and
+//
+//   DEFINE_HASH_MAP(SymbolValues, symbol_values, LishpSymbol *, LishpForm,
+//                   hash_pointer, POINTER_EQ)
+//
+// makes a map from symbols to forms, calling (or expanding) hash_pointer with
+// a key and POINTER_EQ with two of them.
+
+#define DEFINE_LIST(name, prefix, type)                                        \
+  typedef struct {                                                             \
+    uint32_t size;                                                             \
+    uint32_t cap;                                                              \
+    type *items;                                                               \
+  } name;                                                                      \
+                                                                               \
+  static inline int prefix##_init(name *l) {                                   \
+    *l = (name){.size = 0, .cap = 0, .items = NULL};                           \
+    return 0;                                                                  \
+  }                                                                            \
+                                                                               \
+  static inline int prefix##_clear(name *l) {                                  \
+    free(l->items);                                                            \
+    return prefix##_init(l);                                                   \
+  }                                                                            \
+                                                                               \
+  static inline int prefix##_push(name *l, type item) {                        \
+    if (l->size == l->cap && grow_items((void **)&l->items, &l->cap,           \
+                                        sizeof(type), l->size + 1) < 0) {      \
+      return -1;                                                               \
+    }                                                                          \
+    l->items[l->size++] = item;                                                \
+    return 0;                                                                  \
+  }                                                                            \
+                                                                               \
+  static inline int prefix##_pop(name *l, type *item) {                        \
+    if (l->size == 0) {                                                        \
+      return -1;                                                               \
+    }                                                                          \
+    --l->size;                                                                 \
+    if (item != NULL) {                                                        \
+      *item = l->items[l->size];                                               \
+    }                                                                          \
+    return 0;                                                                  \
+  }                                                                            \
+                                                                               \
+  static inline int prefix##_popn(name *l, uint32_t n) {                       \
+    if (l->size < n) {                                                         \
+      return -1;                                                               \
+    }                                                                          \
+    l->size -= n;                                                              \
+    return 0;                                                                  \
+  }                                                                            \
+                                                                               \
+  static inline int prefix##_ref(name *l, uint32_t index, type **pitem) {      \
+    if (index >= l->size) {                                                    \
+      return -1;                                                               \
+    }                                                                          \
+    *pitem = &l->items[index];                                                 \
+    return 0;                                                                  \
+  }                                                                            \
+                                                                               \
+  static inline int prefix##_ref_last(name *l, type **pitem) {                 \
+    return prefix##_ref(l, l->size - 1, pitem);                                \
+  }                                                                            \
+                                                                               \
+  static inline int prefix##_get(name *l, uint32_t index, type *item) {        \
+    if (index >= l->size) {                                                    \
+      return -1;                                                               \
+    }                                                                          \
+    *item = l->items[index];                                                   \
+    return 0;                                                                  \
+  }                                                                            \
+                                                                               \
+  static inline int prefix##_get_last(name *l, type *item) {                   \
+    return prefix##_get(l, l->size - 1, item);                                 \
+  }                                                                            \
+                                                                               \
+  static inline int prefix##_foreach(                                          \
+      name *l, int (*it_fn)(void *arg, type *item), void *arg) {               \
+    for (uint32_t ind = 0; ind < l->size; ++ind) {                             \
+      int res = it_fn(arg, &l->items[ind]);                                    \
+      if (res != 0) {                                                          \
+        return res;                                                            \
+      }                                                                        \
+    }                                                                          \
+    return 0;                                                                  \
+  }
+
+#define DEFINE_HASH_MAP(name, prefix, key_type, val_type, hash_fn, eq_fn)     \
+  typedef struct {                                                             \
+    uint32_t hash; /* HASH_MAP_EMPTY or HASH_MAP_DELETED if unused */          \
+    key_type key;                                                              \
+    val_type value;                                                            \
+  } name##Entry;                                                               \
+                                                                               \
+  typedef struct {                                                             \
+    uint32_t size;                                                             \
+    uint32_t deleted;                                                          \
+    uint32_t cap;                                                              \
+    name##Entry *entries;                                                      \
+  } name;                                                                      \
+                                                                               \
+  static inline int prefix##_init(name *m) {                                   \
+    *m = (name){.size = 0, .deleted = 0, .cap = 0, .entries = NULL};           \
+    return 0;                                                                  \
+  }                                                                            \
+                                                                               \
+  static inline int prefix##_clear(name *m) {                                  \
+    free(m->entries);                                                          \
+    return prefix##_init(m);                                                   \
+  }                                                                            \
+                                                                               \
+  static inline uint32_t prefix##_hash(key_type key) {                         \
+    uint32_t hash = hash_fn(key);                                              \
+    return hash <= HASH_MAP_DELETED ? hash + 2 : hash;                         \
+  }                                                                            \
+                                                                               \
+  /* leaves *ind on the key, or else the first slot it could go in */          \
+  static inline int prefix##_find(name *m, key_type key, uint32_t hash,        \
+                                  uint32_t *ind) {                             \
+    uint32_t mask = m->cap - 1;                                                \
+    uint32_t cur_ind = hash & mask;                                            \
+    int have_deleted = 0;                                                      \
+    for (; m->entries[cur_ind].hash != HASH_MAP_EMPTY;                         \
+         cur_ind = (cur_ind + 1) & mask) {                                     \
+      if (m->entries[cur_ind].hash == HASH_MAP_DELETED) {                      \
+        if (!have_deleted) {                                                   \
+          have_deleted = 1;                                                    \
+          *ind = cur_ind;                                                      \
+        }                                                                      \
+      } else if (m->entries[cur_ind].hash == hash &&                           \
+                 eq_fn(m->entries[cur_ind].key, key)) {                        \
+        *ind = cur_ind;                                                        \
+        return 1;                                                              \
+      }                                                                        \
+    }                                                                          \
+    if (!have_deleted) {                                                       \
+      *ind = cur_ind;                                                          \
+    }                                                                          \
+    return 0;                                                                  \
+  }                                                                            \
+                                                                               \
+  static inline int prefix##_resize(name *m, uint32_t cap) {                   \
+    name##Entry *entries = calloc(cap, sizeof(name##Entry));                   \
+    if (entries == NULL) {                                                     \
+      return -1;                                                               \
+    }                                                                          \
+    uint32_t mask = cap - 1;                                                   \
+    for (uint32_t ind = 0; ind < m->cap; ++ind) {                              \
+      if (m->entries[ind].hash <= HASH_MAP_DELETED) {                          \
+        continue;                                                              \
+      }                                                                        \
+      uint32_t new_ind = m->entries[ind].hash & mask;                          \
+      while (entries[new_ind].hash != HASH_MAP_EMPTY) {                        \
+        new_ind = (new_ind + 1) & mask;                                        \
+      }                                                                        \
+      entries[new_ind] = m->entries[ind];                                      \
+    }                                                                          \
+    free(m->entries);                                                          \
+    m->entries = entries;                                                      \
+    m->cap = cap;                                                              \
+    m->deleted = 0;                                                            \
+    return 0;                                                                  \
+  }                                                                            \
+                                                                               \
+  static inline int prefix##_ref(name *m, key_type key, val_type **pvalue) {   \
+    uint32_t ind;                                                              \
+    if (m->cap == 0 || !prefix##_find(m, key, prefix##_hash(key), &ind)) {     \
+      return -1;                                                               \
+    }                                                                          \
+    if (pvalue != NULL) {                                                      \
+      *pvalue = &m->entries[ind].value;                                        \
+    }                                                                          \
+    return 0;                                                                  \
+  }                                                                            \
+                                                                               \
+  static inline int prefix##_get(name *m, key_type key, val_type *value) {     \
+    val_type *found;                                                           \
+    if (prefix##_ref(m, key, &found) < 0) {                                    \
+      return -1;                                                               \
+    }                                                                          \
+    *value = *found;                                                           \
+    return 0;                                                                  \
+  }                                                                            \
+                                                                               \
+  static inline int prefix##_insert(name *m, key_type key, val_type value) {   \
+    uint32_t hash = prefix##_hash(key);                                        \
+    uint32_t ind;                                                              \
+    if (m->cap > 0 && prefix##_find(m, key, hash, &ind)) {                     \
+      m->entries[ind].value = value;                                           \
+      return 0;                                                                \
+    }                                                                          \
+    if (m->cap == 0 ||                                                         \
+        HASH_MAP_OVER_LOAD(m->size + m->deleted + 1, m->cap)) {                \
+      uint32_t next_cap = HASH_MAP_OVER_LOAD(m->size + 1, m->cap)              \
+                              ? NEXT_CAPACITY(m->cap)                          \
+                              : m->cap;                                        \
+      if (prefix##_resize(m, next_cap) < 0) {                                  \
+        return -1;                                                             \
+      }                                                                        \
+    }                                                                          \
+    prefix##_find(m, key, hash, &ind);                                         \
+    if (m->entries[ind].hash == HASH_MAP_DELETED) {                            \
+      --m->deleted;                                                            \
+    }                                                                          \
+    m->entries[ind] = (name##Entry){.hash = hash, .key = key, .value = value}; \
+    ++m->size;                                                                 \
+    return 0;                                                                  \
+  }                                                                            \
+                                                                               \
+  static inline int prefix##_remove(name *m, key_type key, val_type *value) {  \
+    uint32_t ind;                                                              \
+    if (m->cap == 0 || !prefix##_find(m, key, prefix##_hash(key), &ind)) {     \
+      return -1;                                                               \
+    }                                                                          \
+    if (value != NULL) {                                                       \
+      *value = m->entries[ind].value;                                          \
+    }                                                                          \
+    m->entries[ind].hash = HASH_MAP_DELETED;                                   \
+    --m->size;                                                                 \
+    ++m->deleted;                                                              \
+    return 0;                                                                  \
+  }                                                                            \
+                                                                               \
+  static inline int prefix##_foreach(                                          \
+      name *m, int (*it_fn)(void *arg, key_type *key, val_type *value),        \
+      void *arg) {                                                             \
+    for (uint32_t ind = 0; ind < m->cap; ++ind) {                              \
+      if (m->entries[ind].hash <= HASH_MAP_DELETED) {                          \
+        continue;                                                              \
+      }                                                                        \
+      int res = it_fn(arg, &m->entries[ind].key, &m->entries[ind].value);      \
+      if (res != 0) {                                                          \
+        return res;                                                            \
+      }                                                                        \
+    }                                                                          \
+    return 0;                                                                  \
+  }
+
 #endif
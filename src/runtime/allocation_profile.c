@@ -0,0 +1,295 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "runtime.h"
+#include "runtime/allocation_profile.h"
+#include "runtime/interpreter.h"
+#include "runtime/memory_manager.h"
+#include "runtime/types.h"
+#include "util.h"
+
+#define SITE_NAME_LENGTH 64
+
+typedef struct {
+  uint64_t count;
+  uint64_t bytes;
+  uint64_t judged; // allocations that have been through a collection
+  uint64_t survived;
+} AllocationTally;
+
+// everything allocated while a function was the innermost one being called
+typedef struct {
+  LishpFunction *fn; // NULL for allocations made outside of any call
+  char name[SITE_NAME_LENGTH];
+  AllocationTally tally;
+} AllocationSite;
+
+typedef struct {
+  void *ptr;
+  uint32_t kind;
+  uint32_t site; // index into sites
+} RecentAllocation;
+
+struct allocation_profile {
+  Runtime *rt;
+  AllocationTally kinds[ALLOCATION_KIND_COUNT];
+  List sites;              // AllocationSite
+  HashMap site_indices;    // LishpFunction * -> uint32_t
+  // allocated since the last collection, and not judged yet. functions never
+  // move, but anything else in here could, so the next collection has to
+  // judge them before it compacts
+  List recent;
+  uint64_t collections;
+};
+
+static int fn_cmp(void *l, void *r) {
+  LishpFunction **l_fn = l;
+  LishpFunction **r_fn = r;
+
+  return *l_fn < *r_fn ? -1 : *l_fn > *r_fn ? 1 : 0;
+}
+
+static uint32_t fn_hash(void *key) {
+  LishpFunction **fn = key;
+
+  return hash_word((uintptr_t)*fn);
+}
+
+static const char *kind_name(uint32_t kind) {
+  switch (kind) {
+  case kAllocEnvironment:
+    return "ENVIRONMENT";
+  case kAllocText:
+    return "TEXT";
+  case kAllocOther:
+    return "OTHER";
+  }
+
+  return object_type_name(kind);
+}
+
+static void judge_it(AllocationTally *tally, int survived) {
+  ++tally->judged;
+  if (survived) {
+    ++tally->survived;
+  }
+}
+
+static int judge_recent_it(void *arg, void *obj) {
+  AllocationProfile *profile = arg;
+  RecentAllocation *recent = obj;
+
+  int survived = inspect_marked(profile->rt->memory_manager, recent->ptr);
+
+  AllocationSite *site;
+  list_ref(&profile->sites, sizeof(AllocationSite), recent->site,
+           (void **)&site);
+
+  judge_it(&profile->kinds[recent->kind], survived);
+  judge_it(&site->tally, survived);
+
+  return 0;
+}
+
+static void judge_recent(Runtime *rt) {
+  AllocationProfile *profile = rt->profile;
+
+  list_foreach(&profile->recent, sizeof(RecentAllocation), judge_recent_it,
+               profile);
+  list_popn(&profile->recent, sizeof(RecentAllocation), profile->recent.size);
+
+  ++profile->collections;
+}
+
+int initialize_profile(AllocationProfile **pprofile, Runtime *rt) {
+  AllocationProfile *profile = malloc(sizeof(AllocationProfile));
+  if (profile == NULL) {
+    return -1;
+  }
+
+  profile->rt = rt;
+  memset(profile->kinds, 0, sizeof(profile->kinds));
+  profile->collections = 0;
+
+  TEST_CALL(list_init(&profile->sites));
+  TEST_CALL(hash_map_init(&profile->site_indices, fn_hash, fn_cmp));
+  TEST_CALL(list_init(&profile->recent));
+
+  set_collection_hook(rt->memory_manager, judge_recent);
+
+  *pprofile = profile;
+  return 0;
+}
+
+void cleanup_profile(AllocationProfile **pprofile) {
+  AllocationProfile *profile = *pprofile;
+
+  list_clear(&profile->recent);
+  hash_map_clear(&profile->site_indices);
+  list_clear(&profile->sites);
+  free(profile);
+
+  *pprofile = NULL;
+}
+
+typedef struct {
+  LishpFunction *fn;
+  LishpSymbol *found;
+} FunctionSearch;
+
+static int find_function_it(void *arg, SymbolName *name, LishpSymbol **sym) {
+  (void)name;
+
+  FunctionSearch *search = arg;
+
+  if ((*sym)->function == search->fn) {
+    search->found = *sym;
+    return 1;
+  }
+
+  return 0;
+}
+
+// functions don't know their own names, so this looks through each package
+// for a symbol the function is bound to. only done the first time the
+// function allocates
+static void name_site(Runtime *rt, AllocationSite *site) {
+  if (site->fn == NULL) {
+    snprintf(site->name, SITE_NAME_LENGTH, "(top level)");
+    return;
+  }
+
+  snprintf(site->name, SITE_NAME_LENGTH, "(anonymous %p)", (void *)site->fn);
+
+  for (uint32_t ind = 0; ind < rt->packages.size; ++ind) {
+    Package **p_ref;
+    list_ref(&rt->packages, sizeof(Package *), ind, (void **)&p_ref);
+    Package *p = *p_ref;
+
+    FunctionSearch search = {.fn = site->fn, .found = NULL};
+    interned_symbols_foreach(&p->interned_symbols, find_function_it, &search);
+
+    if (search.found != NULL) {
+      // imported symbols are named after the package they come from
+      snprintf(site->name, SITE_NAME_LENGTH, "%s:%s",
+               search.found->package->name, search.found->lexeme);
+      return;
+    }
+  }
+}
+
+static int find_site(AllocationProfile *profile, uint32_t *index) {
+  Runtime *rt = profile->rt;
+
+  LishpFunction *fn = NULL;
+  if (rt->interpreter != NULL) {
+    fn = current_function(rt->interpreter);
+  }
+
+  if (hash_map_get(&profile->site_indices, sizeof(LishpFunction *),
+                   sizeof(uint32_t), &fn, index) == 0) {
+    return 0;
+  }
+
+  AllocationSite site = {.fn = fn, .tally = {0}};
+  name_site(rt, &site);
+
+  *index = profile->sites.size;
+  TEST_CALL(list_push(&profile->sites, sizeof(AllocationSite), &site));
+  TEST_CALL(hash_map_insert(&profile->site_indices, sizeof(LishpFunction *),
+                            sizeof(uint32_t), &fn, index));
+
+  return 0;
+}
+
+void profile_allocation(AllocationProfile *profile, void *ptr, uint32_t size,
+                        uint32_t kind) {
+  uint32_t index;
+  if (find_site(profile, &index) < 0) {
+    return;
+  }
+
+  AllocationSite *site;
+  list_ref(&profile->sites, sizeof(AllocationSite), index, (void **)&site);
+
+  ++site->tally.count;
+  site->tally.bytes += size;
+  ++profile->kinds[kind].count;
+  profile->kinds[kind].bytes += size;
+
+  RecentAllocation recent = {.ptr = ptr, .kind = kind, .site = index};
+  list_push(&profile->recent, sizeof(RecentAllocation), &recent);
+}
+
+void profile_deallocation(AllocationProfile *profile, void *ptr) {
+  // whatever is deallocated was almost always just allocated, so it is near
+  // the end
+  for (uint32_t ind = profile->recent.size; ind > 0; --ind) {
+    RecentAllocation *recent;
+    list_ref(&profile->recent, sizeof(RecentAllocation), ind - 1,
+             (void **)&recent);
+
+    if (recent->ptr == ptr) {
+      list_remove(&profile->recent, sizeof(RecentAllocation), ind - 1, NULL);
+      return;
+    }
+  }
+}
+
+static void print_tally(FILE *out, const char *name, AllocationTally *tally) {
+  fprintf(out, "  %-32s %10lu %12lu", name, (unsigned long)tally->count,
+          (unsigned long)tally->bytes);
+
+  if (tally->judged == 0) {
+    fprintf(out, "          -\n");
+  } else {
+    fprintf(out, " %9.1f%%\n", 100.0 * tally->survived / tally->judged);
+  }
+}
+
+static int site_bytes_cmp(const void *l, const void *r) {
+  const AllocationSite *l_site = *(AllocationSite *const *)l;
+  const AllocationSite *r_site = *(AllocationSite *const *)r;
+
+  if (l_site->tally.bytes != r_site->tally.bytes) {
+    return l_site->tally.bytes > r_site->tally.bytes ? -1 : 1;
+  }
+  return strcmp(l_site->name, r_site->name);
+}
+
+void print_profile(AllocationProfile *profile, FILE *out) {
+  fprintf(out,
+          "Allocation profile over %lu collections, survival is of the "
+          "first collection after allocating\n",
+          (unsigned long)profile->collections);
+
+  fprintf(out, "  %-32s %10s %12s %10s\n", "KIND", "COUNT", "BYTES",
+          "SURVIVED");
+  for (uint32_t kind = 0; kind < ALLOCATION_KIND_COUNT; ++kind) {
+    if (profile->kinds[kind].count != 0) {
+      print_tally(out, kind_name(kind), &profile->kinds[kind]);
+    }
+  }
+
+  // the heaviest allocators go first
+  uint32_t site_count = profile->sites.size;
+  AllocationSite **sorted = malloc(site_count * sizeof(AllocationSite *));
+  if (sorted == NULL) {
+    return;
+  }
+
+  for (uint32_t ind = 0; ind < site_count; ++ind) {
+    list_ref(&profile->sites, sizeof(AllocationSite), ind,
+             (void **)&sorted[ind]);
+  }
+  qsort(sorted, site_count, sizeof(AllocationSite *), site_bytes_cmp);
+
+  fprintf(out, "  %-32s %10s %12s %10s\n", "FUNCTION", "COUNT", "BYTES",
+          "SURVIVED");
+  for (uint32_t ind = 0; ind < site_count; ++ind) {
+    print_tally(out, sorted[ind]->name, &sorted[ind]->tally);
+  }
+
+  free(sorted);
+}
@@ -0,0 +1,407 @@
+#include <assert.h>
+#include <string.h>
+
+#include "runtime.h"
+#include "runtime/arrays.h"
+#include "runtime/numbers.h"
+#include "runtime/types.h"
+
+static uint64_t vector_size(ObjectType type, uint64_t length) {
+  switch (type) {
+  case kSimpleVector:
+    return sizeof(LishpSimpleVector) + length * sizeof(LishpForm);
+  case kFixnumVector:
+    return sizeof(LishpFixnumVector) + length * sizeof(int64_t);
+  case kDoubleFloatVector:
+    return sizeof(LishpDoubleFloatVector) + length * sizeof(double);
+  case kCharacterVector:
+    return sizeof(LishpCharacterVector) + length;
+  case kBitVector:
+    return sizeof(LishpBitVector) + (length + 63) / 64 * sizeof(uint64_t);
+  default:
+    assert(0 && "Not a vector type!");
+  }
+}
+
+// the elements are left as whatever the allocator handed back. NULL if the
+// vector is too big to allocate at all
+static LishpObject *allocate_vector(Runtime *rt, ObjectType type,
+                                    uint32_t length) {
+  uint64_t size = vector_size(type, length);
+  if (size > MAX_ALLOCATION_SIZE) {
+    return NULL;
+  }
+
+  LishpObject *vector = _allocate_obj(rt, size, type);
+  if (vector == NULL) {
+    return NULL;
+  }
+  vector->type = type;
+
+  switch (type) {
+  case kSimpleVector:
+    AS(LishpSimpleVector, vector)->length = length;
+    break;
+  case kFixnumVector:
+    AS(LishpFixnumVector, vector)->length = length;
+    break;
+  case kDoubleFloatVector:
+    AS(LishpDoubleFloatVector, vector)->length = length;
+    break;
+  case kCharacterVector:
+    AS(LishpCharacterVector, vector)->length = length;
+    break;
+  case kBitVector:
+    AS(LishpBitVector, vector)->length = length;
+    break;
+  default:
+    break;
+  }
+
+  return vector;
+}
+
+LishpObject *make_vector(Runtime *rt, ObjectType type, uint32_t length,
+                         LishpForm initial) {
+  // the initial element is checked before allocating, so nothing is left
+  // half made
+  switch (type) {
+  case kFixnumVector: {
+    assert(FIXNUM_P(initial) && "Expected a fixnum!");
+  } break;
+  case kDoubleFloatVector: {
+    assert(DOUBLE_FLOAT_P(initial) && "Expected a double-float!");
+  } break;
+  case kCharacterVector: {
+    assert(CHAR_P(initial) && "Expected a character!");
+  } break;
+  case kBitVector: {
+    assert(FIXNUM_P(initial) &&
+           (AS_FIXNUM(initial) == 0 || AS_FIXNUM(initial) == 1) &&
+           "Expected a bit!");
+  } break;
+  default:
+    break;
+  }
+
+  LishpObject *vector = allocate_vector(rt, type, length);
+  if (vector == NULL) {
+    return NULL;
+  }
+
+  switch (type) {
+  case kSimpleVector: {
+    LishpSimpleVector *simple = AS(LishpSimpleVector, vector);
+    for (uint32_t ind = 0; ind < length; ++ind) {
+      simple->elements[ind] = initial;
+    }
+  } break;
+  case kFixnumVector:
+  case kDoubleFloatVector: {
+    vector_fill(rt, vector, initial, 0, length);
+  } break;
+  case kCharacterVector: {
+    LishpCharacterVector *chars = AS(LishpCharacterVector, vector);
+    memset(chars->elements, AS_CHAR(initial), length);
+  } break;
+  case kBitVector: {
+    LishpBitVector *bits = AS(LishpBitVector, vector);
+    memset(bits->words, AS_FIXNUM(initial) ? 0xff : 0,
+           vector_size(type, length) - sizeof(LishpBitVector));
+  } break;
+  default:
+    break;
+  }
+
+  return vector;
+}
+
+uint32_t vector_length(LishpObject *vector) {
+  switch (vector->type) {
+  case kSimpleVector:
+    return AS(LishpSimpleVector, vector)->length;
+  case kFixnumVector:
+    return AS(LishpFixnumVector, vector)->length;
+  case kDoubleFloatVector:
+    return AS(LishpDoubleFloatVector, vector)->length;
+  case kCharacterVector:
+    return AS(LishpCharacterVector, vector)->length;
+  case kBitVector:
+    return AS(LishpBitVector, vector)->length;
+  default:
+    assert(0 && "Expected a vector!");
+  }
+}
+
+LishpForm vector_ref(Runtime *rt, LishpObject *vector, uint32_t index) {
+  assert(index < vector_length(vector) && "Index out of bounds!");
+
+  switch (vector->type) {
+  case kSimpleVector:
+    return AS(LishpSimpleVector, vector)->elements[index];
+  case kFixnumVector:
+    return FROM_FIXNUM(AS(LishpFixnumVector, vector)->elements[index]);
+  case kDoubleFloatVector:
+    return make_double(rt, AS(LishpDoubleFloatVector, vector)->elements[index]);
+  case kCharacterVector:
+    return FROM_CHAR(AS(LishpCharacterVector, vector)->elements[index]);
+  case kBitVector: {
+    uint64_t word = AS(LishpBitVector, vector)->words[index / 64];
+    return FROM_FIXNUM((word >> (index % 64)) & 1);
+  }
+  default:
+    assert(0 && "Expected a vector!");
+  }
+}
+
+void vector_set(Runtime *rt, LishpObject *vector, uint32_t index,
+                LishpForm value) {
+  assert(index < vector_length(vector) && "Index out of bounds!");
+
+  switch (vector->type) {
+  case kSimpleVector: {
+    AS(LishpSimpleVector, vector)->elements[index] = value;
+    FORM_WRITE_BARRIER(rt, vector, value);
+  } break;
+  case kFixnumVector: {
+    assert(FIXNUM_P(value) && "Expected a fixnum!");
+    AS(LishpFixnumVector, vector)->elements[index] = AS_FIXNUM(value);
+  } break;
+  case kDoubleFloatVector: {
+    assert(DOUBLE_FLOAT_P(value) && "Expected a double-float!");
+    AS(LishpDoubleFloatVector, vector)->elements[index] = as_double(value);
+  } break;
+  case kCharacterVector: {
+    assert(CHAR_P(value) && "Expected a character!");
+    AS(LishpCharacterVector, vector)->elements[index] = AS_CHAR(value);
+  } break;
+  case kBitVector: {
+    assert(FIXNUM_P(value) &&
+           (AS_FIXNUM(value) == 0 || AS_FIXNUM(value) == 1) &&
+           "Expected a bit!");
+    uint64_t *word = &AS(LishpBitVector, vector)->words[index / 64];
+    uint64_t mask = (uint64_t)1 << (index % 64);
+    *word = AS_FIXNUM(value) ? *word | mask : *word & ~mask;
+  } break;
+  default:
+    assert(0 && "Expected a vector!");
+  }
+}
+
+static void check_range(LishpObject *vector, uint32_t start, uint32_t end) {
+  assert(start <= end && end <= vector_length(vector) && "Bad range!");
+}
+
+void vector_fill(Runtime *rt, LishpObject *vector, LishpForm value,
+                 uint32_t start, uint32_t end) {
+  check_range(vector, start, end);
+
+  switch (vector->type) {
+  case kSimpleVector: {
+    LishpSimpleVector *simple = AS(LishpSimpleVector, vector);
+    for (uint32_t ind = start; ind < end; ++ind) {
+      simple->elements[ind] = value;
+    }
+    // it's the same value every time, so once covers all of them
+    FORM_WRITE_BARRIER(rt, vector, value);
+  } break;
+  case kFixnumVector: {
+    assert(FIXNUM_P(value) && "Expected a fixnum!");
+    rt->kernels->fill_words(
+        (uint64_t *)AS(LishpFixnumVector, vector)->elements + start,
+        end - start, AS_FIXNUM(value));
+  } break;
+  case kDoubleFloatVector: {
+    assert(DOUBLE_FLOAT_P(value) && "Expected a double-float!");
+    double d = as_double(value);
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    rt->kernels->fill_words(
+        (uint64_t *)AS(LishpDoubleFloatVector, vector)->elements + start,
+        end - start, bits);
+  } break;
+  case kCharacterVector: {
+    assert(CHAR_P(value) && "Expected a character!");
+    memset(AS(LishpCharacterVector, vector)->elements + start,
+           AS_CHAR(value), end - start);
+  } break;
+  default: {
+    for (uint32_t ind = start; ind < end; ++ind) {
+      vector_set(rt, vector, ind, value);
+    }
+  } break;
+  }
+}
+
+static uint32_t element_size(ObjectType type) {
+  switch (type) {
+  case kSimpleVector:
+    return sizeof(LishpForm);
+  case kFixnumVector:
+    return sizeof(int64_t);
+  case kDoubleFloatVector:
+    return sizeof(double);
+  case kCharacterVector:
+    return 1;
+  default:
+    return 0;
+  }
+}
+
+static void *elements(LishpObject *vector) {
+  switch (vector->type) {
+  case kSimpleVector:
+    return AS(LishpSimpleVector, vector)->elements;
+  case kFixnumVector:
+    return AS(LishpFixnumVector, vector)->elements;
+  case kDoubleFloatVector:
+    return AS(LishpDoubleFloatVector, vector)->elements;
+  case kCharacterVector:
+    return AS(LishpCharacterVector, vector)->elements;
+  default:
+    return NULL;
+  }
+}
+
+void vector_replace(Runtime *rt, LishpObject *target, uint32_t target_start,
+                    LishpObject *source, uint32_t source_start,
+                    uint32_t count) {
+  check_range(target, target_start, target_start + count);
+  check_range(source, source_start, source_start + count);
+
+  uint32_t size = element_size(target->type);
+  if (target->type == source->type && size != 0) {
+    memmove((char *)elements(target) + (uint64_t)target_start * size,
+            (char *)elements(source) + (uint64_t)source_start * size,
+            (uint64_t)count * size);
+
+    if (target->type == kSimpleVector && target != source) {
+      LishpSimpleVector *simple = AS(LishpSimpleVector, target);
+      for (uint32_t ind = 0; ind < count; ++ind) {
+        FORM_WRITE_BARRIER(rt, target, simple->elements[target_start + ind]);
+      }
+    }
+    return;
+  }
+
+  // everything else goes an element at a time, backwards when that is what
+  // keeps an overlapping copy from reading what it already wrote
+  if (target == source && target_start > source_start) {
+    for (uint32_t ind = count; ind > 0; --ind) {
+      vector_set(rt, target, target_start + ind - 1,
+                 vector_ref(rt, source, source_start + ind - 1));
+    }
+  } else {
+    for (uint32_t ind = 0; ind < count; ++ind) {
+      vector_set(rt, target, target_start + ind,
+                 vector_ref(rt, source, source_start + ind));
+    }
+  }
+}
+
+LishpForm vector_sum(Runtime *rt, LishpObject *vector) {
+  switch (vector->type) {
+  case kFixnumVector: {
+    LishpFixnumVector *fixnums = AS(LishpFixnumVector, vector);
+    return integer_from_int128(
+        rt, rt->kernels->sum_fixnums(fixnums->elements, fixnums->length));
+  }
+  case kDoubleFloatVector: {
+    LishpDoubleFloatVector *doubles = AS(LishpDoubleFloatVector, vector);
+    return make_double(
+        rt, rt->kernels->sum_doubles(doubles->elements, doubles->length));
+  }
+  default:
+    assert(0 && "Expected a fixnum or double-float vector!");
+  }
+}
+
+LishpForm vector_dot(Runtime *rt, LishpObject *x, LishpObject *y) {
+  assert(x->type == kDoubleFloatVector && y->type == kDoubleFloatVector &&
+         "Expected double-float vectors!");
+
+  LishpDoubleFloatVector *l = AS(LishpDoubleFloatVector, x);
+  LishpDoubleFloatVector *r = AS(LishpDoubleFloatVector, y);
+  assert(l->length == r->length && "Expected vectors of the same length!");
+
+  return make_double(
+      rt, rt->kernels->dot_doubles(l->elements, r->elements, l->length));
+}
+
+static LishpForm min_or_max(Runtime *rt, LishpObject *vector, int max) {
+  switch (vector->type) {
+  case kFixnumVector: {
+    LishpFixnumVector *fixnums = AS(LishpFixnumVector, vector);
+    assert(fixnums->length > 0 && "Expected a non-empty vector!");
+
+    int64_t lo, hi;
+    rt->kernels->min_max_fixnums(fixnums->elements, fixnums->length, &lo,
+                                 &hi);
+    return FROM_FIXNUM(max ? hi : lo);
+  }
+  case kDoubleFloatVector: {
+    LishpDoubleFloatVector *doubles = AS(LishpDoubleFloatVector, vector);
+    assert(doubles->length > 0 && "Expected a non-empty vector!");
+
+    double lo, hi;
+    rt->kernels->min_max_doubles(doubles->elements, doubles->length, &lo,
+                                 &hi);
+    return make_double(rt, max ? hi : lo);
+  }
+  default:
+    assert(0 && "Expected a fixnum or double-float vector!");
+  }
+}
+
+LishpForm vector_min(Runtime *rt, LishpObject *vector) {
+  return min_or_max(rt, vector, 0);
+}
+
+LishpForm vector_max(Runtime *rt, LishpObject *vector) {
+  return min_or_max(rt, vector, 1);
+}
+
+static LishpObject *elementwise(Runtime *rt, LishpObject *x, LishpObject *y,
+                                int multiply) {
+  assert(x->type == y->type &&
+         (x->type == kFixnumVector || x->type == kDoubleFloatVector) &&
+         "Expected two fixnum or two double-float vectors!");
+
+  uint32_t length = vector_length(x);
+  assert(vector_length(y) == length && "Expected vectors of the same length!");
+
+  LishpObject *result = allocate_vector(rt, x->type, length);
+  if (result == NULL) {
+    return NULL;
+  }
+
+  if (x->type == kDoubleFloatVector) {
+    double *out = AS(LishpDoubleFloatVector, result)->elements;
+    const double *l = AS(LishpDoubleFloatVector, x)->elements;
+    const double *r = AS(LishpDoubleFloatVector, y)->elements;
+
+    if (multiply) {
+      rt->kernels->multiply_doubles(out, l, r, length);
+    } else {
+      rt->kernels->add_doubles(out, l, r, length);
+    }
+  } else {
+    int64_t *out = AS(LishpFixnumVector, result)->elements;
+    const int64_t *l = AS(LishpFixnumVector, x)->elements;
+    const int64_t *r = AS(LishpFixnumVector, y)->elements;
+
+    int status = multiply ? rt->kernels->multiply_fixnums(out, l, r, length)
+                          : rt->kernels->add_fixnums(out, l, r, length);
+    assert(status == 0 && "Result doesn't fit in a fixnum vector!");
+  }
+
+  return result;
+}
+
+LishpObject *vector_add(Runtime *rt, LishpObject *x, LishpObject *y) {
+  return elementwise(rt, x, y, 0);
+}
+
+LishpObject *vector_multiply(Runtime *rt, LishpObject *x, LishpObject *y) {
+  return elementwise(rt, x, y, 1);
+}
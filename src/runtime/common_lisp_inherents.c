@@ -1,8 +1,12 @@
 #include <assert.h>
+#include <string.h>
 
 #include "runtime.h"
+#include "runtime/arrays.h"
 #include "runtime/functions.h"
+#include "runtime/hash_tables.h"
 #include "runtime/interpreter.h"
+#include "runtime/numbers.h"
 #include "runtime/reader.h"
 #include "runtime/types.h"
 
@@ -71,3 +75,635 @@ LishpFunctionReturn common_lisp_format(Interpreter *interpreter,
 
   return EMPTY_RETURN;
 }
+
+LishpFunctionReturn common_lisp_room(Interpreter *interpreter, LishpList args) {
+  (void)args;
+
+  Runtime *rt = get_runtime(interpreter);
+
+  // counting what is live takes a full collection, so do that before taking
+  // the rest of the numbers
+  LiveObjectCounts counts;
+  count_live_objects(rt, &counts);
+  GcStats stats = inspect_gc_stats(rt->memory_manager);
+
+  uint64_t live_bytes = stats.allocated_bytes - stats.reclaimed_bytes;
+
+  printf("\nHeap: %luK mapped, %luK live, %luK free in %lu chunks (the "
+         "largest is %luK)\n",
+         (unsigned long)(stats.heap_size >> 10),
+         (unsigned long)(live_bytes >> 10),
+         (unsigned long)(stats.free_bytes >> 10),
+         (unsigned long)stats.free_chunks,
+         (unsigned long)(stats.largest_free_chunk >> 10));
+  printf("Large objects: %lu, mapped in %luK of the heap\n",
+         (unsigned long)stats.large_objects,
+         (unsigned long)(stats.large_bytes >> 10));
+  printf("Allocated %luK and reclaimed %luK in total\n",
+         (unsigned long)(stats.allocated_bytes >> 10),
+         (unsigned long)(stats.reclaimed_bytes >> 10));
+  printf("Collections: %lu full (%lu compacting), %lu minor\n",
+         (unsigned long)stats.cycles.full_collections,
+         (unsigned long)stats.cycles.compactions,
+         (unsigned long)stats.cycles.minor_collections);
+  printf("Pauses: %lu, longest %.3fms, %.3fms in total\n",
+         (unsigned long)stats.pauses.count, stats.pauses.max_ns / 1e6,
+         stats.pauses.total_ns / 1e6);
+
+  uint64_t limit_us = 10;
+  for (uint32_t bucket = 0; bucket < GC_PAUSE_BUCKETS - 1; ++bucket) {
+    printf("  under %6luus: %lu\n", (unsigned long)limit_us,
+           (unsigned long)stats.pauses.histogram[bucket]);
+    limit_us *= 10;
+  }
+  printf("  %6luus and over: %lu\n", (unsigned long)(limit_us / 10),
+         (unsigned long)stats.pauses.histogram[GC_PAUSE_BUCKETS - 1]);
+
+  printf("Live objects:");
+  for (uint32_t type = 0; type < OBJECT_TYPE_COUNT; ++type) {
+    printf(" %lu %s,", (unsigned long)counts.objects[type],
+           object_type_name(type));
+  }
+  printf(" %lu ENVIRONMENT\n", (unsigned long)counts.environments);
+
+  return EMPTY_RETURN;
+}
+
+typedef LishpForm (*IntegerOp)(Runtime *rt, LishpForm l, LishpForm r);
+typedef double (*DoubleOp)(double l, double r);
+
+static double add_doubles(double l, double r) { return l + r; }
+static double subtract_doubles(double l, double r) { return l - r; }
+static double multiply_doubles(double l, double r) { return l * r; }
+static double divide_doubles(double l, double r) { return l / r; }
+
+static LishpCons *next_arg(LishpCons *cons) {
+  if (IS_OBJECT_TYPE(cons->cdr, kCons)) {
+    return AS_OBJECT(LishpCons, cons->cdr);
+  }
+  return NULL;
+}
+
+// the running result is kept on the form stack while it is an integer, since
+// each step can allocate a bignum that nothing else refers to yet. once a
+// double-float turns up, the rest is done in a C double and only the final
+// result is made into a form, so a chain never boxes its intermediates
+static LishpFunctionReturn fold_numbers(Interpreter *interpreter,
+                                        LishpForm first, LishpCons *rest,
+                                        IntegerOp integer_op,
+                                        DoubleOp double_op) {
+  Runtime *rt = get_runtime(interpreter);
+
+  LishpForm *acc;
+  int push_result = push_form_return(interpreter, &acc);
+  assert(push_result == 0 && "Couldn't push the running result!");
+  *acc = first;
+
+  int floating = DOUBLE_FLOAT_P(first);
+  double double_acc = floating ? as_double(first) : 0;
+
+  for (LishpCons *cons = rest; cons != NULL; cons = next_arg(cons)) {
+    assert(NUMBER_P(cons->car) && "Expected a number!");
+
+    if (!floating && DOUBLE_FLOAT_P(cons->car)) {
+      floating = 1;
+      double_acc = as_double(*acc);
+    }
+
+    if (floating) {
+      double_acc = double_op(double_acc, as_double(cons->car));
+    } else {
+      *acc = integer_op(rt, *acc, cons->car);
+    }
+  }
+
+  LishpForm result;
+  int pop_result = pop_form_return(interpreter, &result);
+  assert(pop_result == 0 && "Couldn't pop the running result!");
+
+  if (floating) {
+    result = make_double(rt, double_acc);
+  }
+
+  return SINGLE_RETURN(result);
+}
+
+LishpFunctionReturn common_lisp_plus(Interpreter *interpreter, LishpList args) {
+  return fold_numbers(interpreter, FROM_FIXNUM(0), args.cons, integer_add,
+                      add_doubles);
+}
+
+LishpFunctionReturn common_lisp_times(Interpreter *interpreter,
+                                      LishpList args) {
+  return fold_numbers(interpreter, FROM_FIXNUM(1), args.cons,
+                      integer_multiply, multiply_doubles);
+}
+
+LishpFunctionReturn common_lisp_minus(Interpreter *interpreter,
+                                      LishpList args) {
+  assert(!args.nil && "Arguments expected!");
+
+  LishpForm first = args.cons->car;
+  assert(NUMBER_P(first) && "Expected a number!");
+
+  LishpCons *rest = next_arg(args.cons);
+  if (rest == NULL) {
+    return SINGLE_RETURN(number_negate(get_runtime(interpreter), first));
+  }
+
+  return fold_numbers(interpreter, first, rest, integer_subtract,
+                      subtract_doubles);
+}
+
+static int zero_divisor_p(LishpForm d) {
+  if (number_zerop(d)) {
+    fprintf(stderr, "[runtime]: Division by zero\n");
+    return 1;
+  }
+  return 0;
+}
+
+LishpFunctionReturn common_lisp_divide(Interpreter *interpreter,
+                                       LishpList args) {
+  assert(!args.nil && "Arguments expected!");
+
+  LishpForm first = args.cons->car;
+  assert(NUMBER_P(first) && "Expected a number!");
+
+  LishpCons *rest = next_arg(args.cons);
+  if (rest == NULL) {
+    if (zero_divisor_p(first)) {
+      return SINGLE_RETURN(NIL);
+    }
+    return SINGLE_RETURN(
+        number_divide(get_runtime(interpreter), FROM_FIXNUM(1), first));
+  }
+
+  // the divisors are all checked before anything is divided
+  for (LishpCons *cons = rest; cons != NULL; cons = next_arg(cons)) {
+    if (zero_divisor_p(cons->car)) {
+      return SINGLE_RETURN(NIL);
+    }
+  }
+
+  return fold_numbers(interpreter, first, rest, integer_divide,
+                      divide_doubles);
+}
+
+// FIXME: only the quotient is returned, until functions can return more than
+// one value
+LishpFunctionReturn common_lisp_floor(Interpreter *interpreter,
+                                      LishpList args) {
+  assert(!args.nil && "Arguments expected!");
+
+  LishpForm n = args.cons->car;
+  LishpForm d = FROM_FIXNUM(1);
+
+  LishpCons *rest = next_arg(args.cons);
+  if (rest != NULL) {
+    d = rest->car;
+  }
+
+  assert(NUMBER_P(n) && NUMBER_P(d) && "Expected numbers!");
+  if (zero_divisor_p(d)) {
+    return SINGLE_RETURN(NIL);
+  }
+
+  return SINGLE_RETURN(number_floor(get_runtime(interpreter), n, d));
+}
+
+LishpFunctionReturn common_lisp_mod(Interpreter *interpreter, LishpList args) {
+  assert(!args.nil && "Arguments expected!");
+
+  LishpCons *rest = next_arg(args.cons);
+  assert(rest != NULL && "Divisor expected!");
+
+  LishpForm n = args.cons->car;
+  LishpForm d = rest->car;
+
+  assert(NUMBER_P(n) && NUMBER_P(d) && "Expected numbers!");
+  if (zero_divisor_p(d)) {
+    return SINGLE_RETURN(NIL);
+  }
+
+  return SINGLE_RETURN(number_mod(get_runtime(interpreter), n, d));
+}
+
+LishpFunctionReturn common_lisp_float(Interpreter *interpreter,
+                                      LishpList args) {
+  assert(!args.nil && "Arguments expected!");
+
+  LishpForm n = args.cons->car;
+  assert(NUMBER_P(n) && "Expected a number!");
+
+  if (DOUBLE_FLOAT_P(n)) {
+    return SINGLE_RETURN(n);
+  }
+  return SINGLE_RETURN(make_double(get_runtime(interpreter), as_double(n)));
+}
+
+static int symbol_named(LishpForm form, const char *name) {
+  return IS_OBJECT_TYPE(form, kSymbol) &&
+         strcmp(AS_OBJECT(LishpSymbol, form)->lexeme, name) == 0;
+}
+
+static ObjectType vector_type(LishpForm element_type) {
+  if (T_P(element_type) || symbol_named(element_type, "T")) {
+    return kSimpleVector;
+  }
+  if (symbol_named(element_type, "FIXNUM")) {
+    return kFixnumVector;
+  }
+  if (symbol_named(element_type, "DOUBLE-FLOAT")) {
+    return kDoubleFloatVector;
+  }
+  if (symbol_named(element_type, "CHARACTER")) {
+    return kCharacterVector;
+  }
+  if (symbol_named(element_type, "BIT")) {
+    return kBitVector;
+  }
+
+  assert(0 && "Unimplemented: array element type");
+}
+
+// FIXME: only one dimensional arrays can be made
+LishpFunctionReturn common_lisp_make_array(Interpreter *interpreter,
+                                           LishpList args) {
+  assert(!args.nil && "Arguments expected!");
+
+  LishpForm dimensions = args.cons->car;
+  if (IS_OBJECT_TYPE(dimensions, kCons)) {
+    LishpCons *dimension_cons = AS_OBJECT(LishpCons, dimensions);
+    assert(NIL_P(dimension_cons->cdr) &&
+           "Unimplemented: multidimensional arrays");
+    dimensions = dimension_cons->car;
+  }
+  assert(FIXNUM_P(dimensions) && AS_FIXNUM(dimensions) >= 0 &&
+         "Expected a length!");
+
+  LishpForm element_type = T;
+  LishpForm initial_element;
+  int has_initial_element = 0;
+
+  for (LishpCons *cons = next_arg(args.cons); cons != NULL;
+       cons = next_arg(cons)) {
+    LishpCons *value = next_arg(cons);
+    assert(value != NULL && "Keyword argument without a value!");
+
+    if (symbol_named(cons->car, ":ELEMENT-TYPE")) {
+      element_type = value->car;
+    } else if (symbol_named(cons->car, ":INITIAL-ELEMENT")) {
+      initial_element = value->car;
+      has_initial_element = 1;
+    } else {
+      assert(0 && "Unimplemented: make-array keyword argument");
+    }
+
+    cons = value;
+  }
+
+  Runtime *rt = get_runtime(interpreter);
+  ObjectType type = vector_type(element_type);
+
+  if (!has_initial_element) {
+    switch (type) {
+    case kFixnumVector:
+    case kBitVector: {
+      initial_element = FROM_FIXNUM(0);
+    } break;
+    case kDoubleFloatVector: {
+      initial_element = make_double(rt, 0);
+    } break;
+    case kCharacterVector: {
+      initial_element = FROM_CHAR('\0');
+    } break;
+    default: {
+      initial_element = NIL;
+    } break;
+    }
+  }
+
+  LishpObject *vector =
+      AS_FIXNUM(dimensions) <= UINT32_MAX
+          ? make_vector(rt, type, AS_FIXNUM(dimensions), initial_element)
+          : NULL;
+  if (vector == NULL) {
+    // FIXME: there are no conditions to signal yet, so this is reported and
+    // make-array returns NIL
+    fprintf(stderr, "[runtime]: An array of %ld elements is too big\n",
+            (long)AS_FIXNUM(dimensions));
+    return SINGLE_RETURN(NIL);
+  }
+
+  return SINGLE_RETURN(FROM_OBJ(vector));
+}
+
+LishpFunctionReturn common_lisp_aref(Interpreter *interpreter,
+                                     LishpList args) {
+  assert(!args.nil && "Arguments expected!");
+
+  LishpCons *rest = next_arg(args.cons);
+  assert(rest != NULL && "Index expected!");
+
+  LishpForm vector = args.cons->car;
+  LishpForm index = rest->car;
+
+  assert(VECTOR_P(vector) && "Expected a vector!");
+  assert(FIXNUM_P(index) && AS_FIXNUM(index) >= 0 && "Expected an index!");
+
+  return SINGLE_RETURN(
+      vector_ref(get_runtime(interpreter), vector.object, AS_FIXNUM(index)));
+}
+
+LishpFunctionReturn common_lisp_length(Interpreter *interpreter,
+                                       LishpList args) {
+  (void)interpreter;
+
+  assert(!args.nil && "Arguments expected!");
+
+  LishpForm sequence = args.cons->car;
+
+  if (VECTOR_P(sequence)) {
+    return SINGLE_RETURN(FROM_FIXNUM(vector_length(sequence.object)));
+  }
+  if (IS_OBJECT_TYPE(sequence, kString)) {
+    return SINGLE_RETURN(
+        FROM_FIXNUM(strlen(AS_OBJECT(LishpString, sequence)->lexeme)));
+  }
+
+  int64_t length = 0;
+  while (IS_OBJECT_TYPE(sequence, kCons)) {
+    ++length;
+    sequence = AS_OBJECT(LishpCons, sequence)->cdr;
+  }
+  assert(NIL_P(sequence) && "Expected a sequence!");
+
+  return SINGLE_RETURN(FROM_FIXNUM(length));
+}
+
+// a :start or :end argument, where an :end of nil means the length
+static uint32_t bound_arg(LishpForm form, uint32_t length) {
+  if (NIL_P(form)) {
+    return length;
+  }
+  assert(FIXNUM_P(form) && AS_FIXNUM(form) >= 0 &&
+         AS_FIXNUM(form) <= length && "Expected a bound within the sequence!");
+  return AS_FIXNUM(form);
+}
+
+LishpFunctionReturn common_lisp_fill(Interpreter *interpreter,
+                                     LishpList args) {
+  assert(!args.nil && "Arguments expected!");
+
+  LishpCons *item_cons = next_arg(args.cons);
+  assert(item_cons != NULL && "Item expected!");
+
+  LishpForm sequence = args.cons->car;
+  LishpForm item = item_cons->car;
+  LishpForm start_form = NIL;
+  LishpForm end_form = NIL;
+
+  for (LishpCons *cons = next_arg(item_cons); cons != NULL;
+       cons = next_arg(cons)) {
+    LishpCons *value = next_arg(cons);
+    assert(value != NULL && "Keyword argument without a value!");
+
+    if (symbol_named(cons->car, ":START")) {
+      start_form = value->car;
+    } else if (symbol_named(cons->car, ":END")) {
+      end_form = value->car;
+    } else {
+      assert(0 && "Unimplemented: fill keyword argument");
+    }
+
+    cons = value;
+  }
+
+  Runtime *rt = get_runtime(interpreter);
+
+  if (VECTOR_P(sequence)) {
+    uint32_t length = vector_length(sequence.object);
+    uint32_t start = NIL_P(start_form) ? 0 : bound_arg(start_form, length);
+    uint32_t end = bound_arg(end_form, length);
+
+    vector_fill(rt, sequence.object, item, start, end);
+    return SINGLE_RETURN(sequence);
+  }
+
+  int64_t start = NIL_P(start_form) ? 0 : bound_arg(start_form, UINT32_MAX);
+  int64_t end = NIL_P(end_form) ? INT64_MAX : bound_arg(end_form, UINT32_MAX);
+
+  int64_t ind = 0;
+  for (LishpForm cur = sequence; IS_OBJECT_TYPE(cur, kCons) && ind < end;
+       cur = AS_OBJECT(LishpCons, cur)->cdr, ++ind) {
+    if (ind >= start) {
+      LishpCons *cons = AS_OBJECT(LishpCons, cur);
+      cons->car = item;
+      FORM_WRITE_BARRIER(rt, cons, item);
+    }
+  }
+  assert((IS_OBJECT_TYPE(sequence, kCons) || NIL_P(sequence)) &&
+         "Expected a sequence!");
+
+  return SINGLE_RETURN(sequence);
+}
+
+LishpFunctionReturn common_lisp_replace(Interpreter *interpreter,
+                                        LishpList args) {
+  assert(!args.nil && "Arguments expected!");
+
+  LishpCons *source_cons = next_arg(args.cons);
+  assert(source_cons != NULL && "Two sequences expected!");
+
+  LishpForm target = args.cons->car;
+  LishpForm source = source_cons->car;
+  assert(VECTOR_P(target) && VECTOR_P(source) &&
+         "Unimplemented: replace on anything but vectors");
+
+  LishpForm bounds[4] = {NIL, NIL, NIL, NIL};
+  const char *names[4] = {":START1", ":END1", ":START2", ":END2"};
+
+  for (LishpCons *cons = next_arg(source_cons); cons != NULL;
+       cons = next_arg(cons)) {
+    LishpCons *value = next_arg(cons);
+    assert(value != NULL && "Keyword argument without a value!");
+
+    int found = 0;
+    for (int ind = 0; ind < 4 && !found; ++ind) {
+      if (symbol_named(cons->car, names[ind])) {
+        bounds[ind] = value->car;
+        found = 1;
+      }
+    }
+    assert(found && "Unimplemented: replace keyword argument");
+
+    cons = value;
+  }
+
+  uint32_t target_length = vector_length(target.object);
+  uint32_t source_length = vector_length(source.object);
+  uint32_t start1 = NIL_P(bounds[0]) ? 0 : bound_arg(bounds[0], target_length);
+  uint32_t end1 = bound_arg(bounds[1], target_length);
+  uint32_t start2 = NIL_P(bounds[2]) ? 0 : bound_arg(bounds[2], source_length);
+  uint32_t end2 = bound_arg(bounds[3], source_length);
+  assert(start1 <= end1 && start2 <= end2 && "Bad range!");
+
+  // whichever of the two ranges is shorter decides how much is copied
+  uint32_t count =
+      end1 - start1 < end2 - start2 ? end1 - start1 : end2 - start2;
+  vector_replace(get_runtime(interpreter), target.object, start1,
+                 source.object, start2, count);
+
+  return SINGLE_RETURN(target);
+}
+
+LishpFunctionReturn common_lisp_make_hash_table(Interpreter *interpreter,
+                                                LishpList args) {
+  HashTableTest test = kTestEql;
+  uint32_t size = 0;
+
+  for (LishpCons *cons = args.nil ? NULL : args.cons; cons != NULL;
+       cons = next_arg(cons)) {
+    LishpCons *value = next_arg(cons);
+    assert(value != NULL && "Keyword argument without a value!");
+
+    if (symbol_named(cons->car, ":TEST")) {
+      // there is no #' yet, so the test is given by name
+      if (symbol_named(value->car, "EQ")) {
+        test = kTestEq;
+      } else if (symbol_named(value->car, "EQL")) {
+        test = kTestEql;
+      } else if (symbol_named(value->car, "EQUAL")) {
+        test = kTestEqual;
+      } else {
+        assert(0 && "Unimplemented: hash table test");
+      }
+    } else if (symbol_named(cons->car, ":SIZE")) {
+      assert(FIXNUM_P(value->car) && AS_FIXNUM(value->car) >= 0 &&
+             AS_FIXNUM(value->car) <= UINT32_MAX && "Expected a size!");
+      size = AS_FIXNUM(value->car);
+    } else {
+      assert(0 && "Unimplemented: make-hash-table keyword argument");
+    }
+
+    cons = value;
+  }
+
+  return SINGLE_RETURN(
+      FROM_OBJ(make_hash_table(get_runtime(interpreter), test, size)));
+}
+
+// FIXME: only the value is returned, not whether it was found, since a call
+// can't return more than one value yet
+LishpFunctionReturn common_lisp_gethash(Interpreter *interpreter,
+                                        LishpList args) {
+  assert(!args.nil && "Arguments expected!");
+
+  LishpCons *table_cons = next_arg(args.cons);
+  assert(table_cons != NULL && HASH_TABLE_P(table_cons->car) &&
+         "Expected a hash table!");
+
+  LishpCons *default_cons = next_arg(table_cons);
+  LishpForm value = default_cons != NULL ? default_cons->car : NIL;
+
+  hash_table_get(get_runtime(interpreter),
+                 AS_OBJECT(LishpHashTable, table_cons->car), args.cons->car,
+                 &value);
+
+  return SINGLE_RETURN(value);
+}
+
+LishpFunctionReturn common_lisp_remhash(Interpreter *interpreter,
+                                        LishpList args) {
+  assert(!args.nil && "Arguments expected!");
+
+  LishpCons *table_cons = next_arg(args.cons);
+  assert(table_cons != NULL && HASH_TABLE_P(table_cons->car) &&
+         "Expected a hash table!");
+
+  int removed =
+      hash_table_remove(get_runtime(interpreter),
+                        AS_OBJECT(LishpHashTable, table_cons->car),
+                        args.cons->car);
+
+  return SINGLE_RETURN(removed ? T : NIL);
+}
+
+// pushes form as an argument that evaluates to itself
+static void push_quoted_argument(Interpreter *interpreter, LishpSymbol *quote,
+                                 LishpForm form) {
+  if (!IS_OBJECT_TYPE(form, kSymbol) && !IS_OBJECT_TYPE(form, kCons)) {
+    push_argument(interpreter, form);
+    return;
+  }
+
+  Runtime *rt = get_runtime(interpreter);
+
+  // the outer cons is on the form stack before the inner one is allocated
+  LishpCons *quoted = ALLOCATE_OBJ(LishpCons, rt);
+  *quoted = CONS(FROM_OBJ(quote), NIL);
+  push_argument(interpreter, FROM_OBJ(quoted));
+
+  LishpCons *inner = ALLOCATE_OBJ(LishpCons, rt);
+  *inner = CONS(form, NIL);
+  quoted->cdr = FROM_OBJ(inner);
+  OBJ_WRITE_BARRIER(rt, quoted, inner);
+}
+
+// the function is called with each key and value in turn. it may remove or
+// set the entry it was called with, but adding any other is undefined
+LishpFunctionReturn common_lisp_maphash(Interpreter *interpreter,
+                                        LishpList args) {
+  assert(!args.nil && "Arguments expected!");
+
+  LishpCons *table_cons = next_arg(args.cons);
+  assert(table_cons != NULL && HASH_TABLE_P(table_cons->car) &&
+         "Expected a hash table!");
+
+  Runtime *rt = get_runtime(interpreter);
+  LishpForm fn_form = args.cons->car;
+  LishpHashTable *table = AS_OBJECT(LishpHashTable, table_cons->car);
+
+  LishpFunction *fn;
+  if (IS_OBJECT_TYPE(fn_form, kSymbol)) {
+    fn = symbol_function(rt, get_current_environment(interpreter),
+                         AS_OBJECT(LishpSymbol, fn_form));
+  } else {
+    assert(IS_OBJECT_TYPE(fn_form, kFunction) && "Expected a function!");
+    fn = AS_OBJECT(LishpFunction, fn_form);
+  }
+
+  LishpSymbol *quote =
+      intern_symbol(rt, find_package(rt, "COMMON-LISP"), "QUOTE");
+
+  // the entries are looked up again every time around, since the function
+  // can make the table let go of them
+  for (uint32_t ind = 0; ind < table->capacity; ++ind) {
+    HashTableEntry *entry = &table->entries[ind];
+    if (!HASH_ENTRY_LIVE_P(entry)) {
+      continue;
+    }
+
+    LishpForm value = entry->value;
+    push_function(interpreter, fn);
+    push_quoted_argument(interpreter, quote, entry->key);
+    push_quoted_argument(interpreter, quote, value);
+
+    LishpFunctionReturn ret = interpret_function_call(interpreter, 2);
+    CHECK_GO_RET(ret);
+  }
+
+  return SINGLE_RETURN(NIL);
+}
+
+LishpFunctionReturn common_lisp_hash_table_count(Interpreter *interpreter,
+                                                 LishpList args) {
+  (void)interpreter;
+
+  assert(!args.nil && HASH_TABLE_P(args.cons->car) &&
+         "Expected a hash table!");
+
+  return SINGLE_RETURN(
+      FROM_FIXNUM(AS_OBJECT(LishpHashTable, args.cons->car)->count));
+}
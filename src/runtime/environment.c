@@ -1,124 +1,136 @@
 #include <assert.h>
-#include <string.h>
 
 #include "runtime.h"
 #include "runtime/types.h"
 #include "util.h"
 
-static int bind_value_rec(Environment *env, LishpSymbol *sym, LishpForm val,
-                          int bind_here) {
+// a package's global environment is the only one without a parent, and its
+// bindings are kept in the symbols themselves rather than in its maps
+
+static int bind_value_rec(Runtime *rt, Environment *env, LishpSymbol *sym,
+                          LishpForm val, int bind_here) {
+
+  if (env->parent == NULL) {
+    if (!bind_here && UNBOUND_P(sym->value)) {
+      return 0;
+    }
+
+    sym->value = val;
+    FORM_WRITE_BARRIER(rt, sym, val);
+    return 1;
+  }
 
   LishpForm *value_ptr = NULL;
-  if (map_ref(&env->symbol_values, sizeof(LishpSymbol *), sizeof(LishpForm),
-              &sym, (void **)&value_ptr) == 0) {
+  if (symbol_values_ref(&env->symbol_values, sym, &value_ptr) == 0) {
 
     // symbol is bound in this environment, so just replace the value
     *value_ptr = val;
+    FORM_WRITE_BARRIER(rt, env, val);
     return 1;
   }
 
-  if (env->parent != NULL) {
-    int bound_higher = bind_value_rec(env->parent, sym, val, 0);
-    if (bound_higher) {
-      return 1;
-    }
+  int bound_higher = bind_value_rec(rt, env->parent, sym, val, 0);
+  if (bound_higher) {
+    return 1;
   }
 
   if (bind_here) {
-    map_insert(&env->symbol_values, sizeof(LishpSymbol *), sizeof(LishpForm),
-               &sym, &val);
+    symbol_values_insert(&env->symbol_values, sym, val);
+    OBJ_WRITE_BARRIER(rt, env, sym);
+    FORM_WRITE_BARRIER(rt, env, val);
   }
 
   return bind_here;
 }
 
-static int bind_function_rec(Environment *env, LishpSymbol *sym,
-                             LishpFunction *fn, int bind_here) {
+static int bind_function_rec(Runtime *rt, Environment *env,
+                             LishpSymbol *sym, LishpFunction *fn,
+                             int bind_here) {
+
+  if (env->parent == NULL) {
+    if (!bind_here && sym->function == NULL) {
+      return 0;
+    }
+
+    sym->function = fn;
+    OBJ_WRITE_BARRIER(rt, sym, fn);
+    return 1;
+  }
 
   LishpFunction **value_ptr;
-  if (map_ref(&env->symbol_functions, sizeof(LishpSymbol *),
-              sizeof(LishpFunction *), &sym, (void **)&value_ptr) == 0) {
+  if (symbol_functions_ref(&env->symbol_functions, sym, &value_ptr) == 0) {
 
     // symbol is bound in this environment, so just replace the value
     *value_ptr = fn;
+    OBJ_WRITE_BARRIER(rt, env, fn);
     return 1;
   }
 
-  if (env->parent != NULL) {
-    int bound_higher = bind_function_rec(env->parent, sym, fn, 0);
-    if (bound_higher) {
-      return 1;
-    }
+  int bound_higher = bind_function_rec(rt, env->parent, sym, fn, 0);
+  if (bound_higher) {
+    return 1;
   }
 
   if (bind_here) {
-    map_insert(&env->symbol_functions, sizeof(LishpSymbol *),
-               sizeof(LishpFunction *), &sym, &fn);
+    symbol_functions_insert(&env->symbol_functions, sym, fn);
+    OBJ_WRITE_BARRIER(rt, env, sym);
+    OBJ_WRITE_BARRIER(rt, env, fn);
+    ++rt->lexical_functions;
   }
 
   return bind_here;
 }
 
-void bind_value(Environment *env, LishpSymbol *sym, LishpForm val) {
-  int bind_response = bind_value_rec(env, sym, val, 1);
+void bind_value(Runtime *rt, Environment *env, LishpSymbol *sym,
+                LishpForm val) {
+  int bind_response = bind_value_rec(rt, env, sym, val, 1);
 }
 
-void bind_function(Environment *env, LishpSymbol *sym, LishpFunction *fn) {
-  int bind_response = bind_function_rec(env, sym, fn, 1);
+void bind_function(Runtime *rt, Environment *env, LishpSymbol *sym,
+                   LishpFunction *fn) {
+  int bind_response = bind_function_rec(rt, env, sym, fn, 1);
 }
 
-static int symbol_value_int(Runtime *rt, Environment *env, LishpSymbol *sym,
+static int symbol_value_int(Environment *env, LishpSymbol *sym,
                             LishpForm *result) {
-  if (strcmp(env->package, sym->package) != 0) {
-    // TODO: look for the symbol exported in the package
-    Package *p = find_package(rt, sym->package);
-    *result = symbol_value(rt, p->global, sym);
-    return 1;
-  }
-
-  LishpForm ret;
-  if (map_get(&env->symbol_values, sizeof(LishpSymbol *), sizeof(LishpForm),
-              &sym, &ret) == 0) {
-    *result = ret;
-    return 1;
+  // most environments are pushed for a function call or a tagbody and bind
+  // nothing, so only hash into the ones that do
+  for (; env->parent != NULL; env = env->parent) {
+    if (env->symbol_values.size > 0 &&
+        symbol_values_get(&env->symbol_values, sym, result) == 0) {
+      return 1;
+    }
   }
 
-  if (env->parent != NULL) {
-    *result = symbol_value(rt, env->parent, sym);
-    return 1;
+  if (UNBOUND_P(sym->value)) {
+    return 0;
   }
 
-  return 0;
+  *result = sym->value;
+  return 1;
 }
 
 static int symbol_function_int(Runtime *rt, Environment *env, LishpSymbol *sym,
                                LishpFunction **result) {
-  if (strcmp(env->package, sym->package) != 0) {
-    // TODO: look for the symbol exported in the package
-    Package *p = find_package(rt, sym->package);
-    *result = symbol_function(rt, p->global, sym);
-    return 1;
-  }
-
-  LishpFunction *ret = NULL;
-  if (map_get(&env->symbol_functions, sizeof(LishpSymbol *),
-              sizeof(LishpFunction *), &sym, &ret) == 0) {
-    *result = ret;
-    return 1;
-  }
-
-  if (env->parent != NULL) {
-    *result = symbol_function(rt, env->parent, sym);
-    return 1;
+  if (rt->lexical_functions > 0) {
+    for (; env->parent != NULL; env = env->parent) {
+      if (env->symbol_functions.size > 0 &&
+          symbol_functions_get(&env->symbol_functions, sym, result) == 0) {
+        return 1;
+      }
+    }
   }
 
-  return 0;
+  *result = sym->function;
+  return *result != NULL;
 }
 
 LishpForm symbol_value(Runtime *rt, Environment *env, LishpSymbol *sym) {
+  (void)rt;
+
   LishpForm result;
 
-  int found = symbol_value_int(rt, env, sym, &result);
+  int found = symbol_value_int(env, sym, &result);
 
   if (!found) {
     assert(0 && "Symbol not bound in current environment!");
@@ -0,0 +1,388 @@
+#include <assert.h>
+#include <string.h>
+
+#include "runtime.h"
+#include "runtime/hash_tables.h"
+#include "runtime/memory_manager.h"
+#include "runtime/types.h"
+
+#define EMPTY_SLOT 0
+#define DELETED_SLOT 1
+#define LIVE_BIT ((uint64_t)1 << 63)
+
+#define MIN_CAPACITY 8
+#define MAX_CAPACITY ((uint32_t)1 << 27)
+
+// only this many conses of a key are hashed under EQUAL, so long or circular
+// lists don't take forever. lists that only differ past that collide
+#define EQUAL_HASH_BUDGET 16
+
+// strings and character vectors are both strings as far as EQUAL is concerned
+static int string_contents(LishpForm f, const char **chars, uint32_t *length) {
+  if (IS_OBJECT_TYPE(f, kString)) {
+    const char *lexeme = AS_OBJECT(LishpString, f)->lexeme;
+    *chars = lexeme != NULL ? lexeme : "";
+    *length = strlen(*chars);
+    return 1;
+  }
+  if (IS_OBJECT_TYPE(f, kCharacterVector)) {
+    *chars = AS_OBJECT(LishpCharacterVector, f)->elements;
+    *length = AS_OBJECT(LishpCharacterVector, f)->length;
+    return 1;
+  }
+  return 0;
+}
+
+// the bits past the length of a bit vector aren't kept clear, so the last
+// word is masked
+static uint64_t last_bits(LishpBitVector *bits) {
+  uint32_t rest = bits->length % 64;
+  uint64_t word = bits->words[bits->length / 64];
+  return word & (((uint64_t)1 << rest) - 1);
+}
+
+static int bits_equal(LishpBitVector *l, LishpBitVector *r) {
+  if (l->length != r->length) {
+    return 0;
+  }
+
+  uint32_t full_words = l->length / 64;
+  if (memcmp(l->words, r->words, full_words * sizeof(uint64_t)) != 0) {
+    return 0;
+  }
+  return l->length % 64 == 0 || last_bits(l) == last_bits(r);
+}
+
+int eql_p(LishpForm l, LishpForm r) {
+  if (EQ_P(l, r)) {
+    return 1;
+  }
+  if (!OBJECT_P(l) || !OBJECT_P(r) || l.object->type != r.object->type) {
+    return 0;
+  }
+
+  switch (l.object->type) {
+  case kBignum: {
+    LishpBignum *l_big = AS_OBJECT(LishpBignum, l);
+    LishpBignum *r_big = AS_OBJECT(LishpBignum, r);
+    return l_big->negative == r_big->negative &&
+           l_big->length == r_big->length &&
+           memcmp(l_big->limbs, r_big->limbs,
+                  l_big->length * sizeof(uint64_t)) == 0;
+  }
+  case kDoubleFloat: {
+    // the same representation, so -0.0 and 0.0 aren't, but a NaN is itself
+    return memcmp(&AS_OBJECT(LishpDoubleFloat, l)->value,
+                  &AS_OBJECT(LishpDoubleFloat, r)->value,
+                  sizeof(double)) == 0;
+  }
+  default:
+    return 0;
+  }
+}
+
+int equal_p(LishpForm l, LishpForm r) {
+  while (1) {
+    if (eql_p(l, r)) {
+      return 1;
+    }
+
+    const char *l_chars, *r_chars;
+    uint32_t l_length, r_length;
+    if (string_contents(l, &l_chars, &l_length) &&
+        string_contents(r, &r_chars, &r_length)) {
+      return l_length == r_length && memcmp(l_chars, r_chars, l_length) == 0;
+    }
+
+    if (IS_OBJECT_TYPE(l, kBitVector) && IS_OBJECT_TYPE(r, kBitVector)) {
+      return bits_equal(AS_OBJECT(LishpBitVector, l),
+                        AS_OBJECT(LishpBitVector, r));
+    }
+
+    if (!IS_OBJECT_TYPE(l, kCons) || !IS_OBJECT_TYPE(r, kCons)) {
+      return 0;
+    }
+    if (!equal_p(AS_OBJECT(LishpCons, l)->car, AS_OBJECT(LishpCons, r)->car)) {
+      return 0;
+    }
+
+    // the cdrs are compared in the loop, so long lists don't recurse
+    l = AS_OBJECT(LishpCons, l)->cdr;
+    r = AS_OBJECT(LishpCons, r)->cdr;
+  }
+}
+
+// sets *by_address if the hash depends on where some object is
+static uint64_t hash_form(HashTableTest test, LishpForm f, uint32_t *budget,
+                          int *by_address) {
+  if (!OBJECT_P(f)) {
+    return hash_word(f.bits);
+  }
+
+  switch (f.object->type) {
+  case kSymbol: {
+    // the name was hashed when it was interned
+    LishpSymbol *sym = AS_OBJECT(LishpSymbol, f);
+    return hash_word(((uint64_t)sym->id << 32) | sym->hash);
+  }
+  case kBignum: {
+    if (test != kTestEq) {
+      LishpBignum *big = AS_OBJECT(LishpBignum, f);
+      return hash_word(hash_bytes(big->limbs, big->length * sizeof(uint64_t)) +
+                 big->negative);
+    }
+  } break;
+  case kDoubleFloat: {
+    if (test != kTestEq) {
+      uint64_t bits;
+      memcpy(&bits, &AS_OBJECT(LishpDoubleFloat, f)->value, sizeof(bits));
+      return hash_word(bits);
+    }
+  } break;
+  case kString:
+  case kCharacterVector: {
+    if (test == kTestEqual) {
+      const char *chars;
+      uint32_t length;
+      string_contents(f, &chars, &length);
+      return hash_word(hash_bytes(chars, length));
+    }
+  } break;
+  case kBitVector: {
+    if (test == kTestEqual) {
+      LishpBitVector *bits = AS_OBJECT(LishpBitVector, f);
+      uint64_t hash =
+          hash_bytes(bits->words, bits->length / 64 * sizeof(uint64_t));
+      if (bits->length % 64 != 0) {
+        hash ^= hash_word(last_bits(bits));
+      }
+      return hash_word(hash + bits->length);
+    }
+  } break;
+  case kCons: {
+    if (test == kTestEqual) {
+      uint64_t hash = 0;
+      LishpForm cur = f;
+      for (; IS_OBJECT_TYPE(cur, kCons) && *budget > 0;
+           cur = AS_OBJECT(LishpCons, cur)->cdr) {
+        --*budget;
+        hash = hash_word(hash + hash_form(test, AS_OBJECT(LishpCons, cur)->car,
+                                    budget, by_address));
+      }
+      if (!IS_OBJECT_TYPE(cur, kCons)) {
+        hash = hash_word(hash + hash_form(test, cur, budget, by_address));
+      }
+      return hash;
+    }
+  } break;
+  default:
+    break;
+  }
+
+  *by_address = 1;
+  return hash_word(f.bits);
+}
+
+static uint64_t hash_key(LishpHashTable *table, LishpForm key,
+                         int *by_address) {
+  uint32_t budget = EQUAL_HASH_BUDGET;
+  *by_address = 0;
+  return hash_form(table->test, key, &budget, by_address) | LIVE_BIT;
+}
+
+static int keys_match(HashTableTest test, LishpForm l, LishpForm r) {
+  switch (test) {
+  case kTestEq:
+    return EQ_P(l, r);
+  case kTestEql:
+    return eql_p(l, r);
+  case kTestEqual:
+    return equal_p(l, r);
+  }
+  return 0;
+}
+
+static HashTableEntry *allocate_entries(Runtime *rt, uint32_t capacity) {
+  uint32_t size = capacity * sizeof(HashTableEntry);
+  HashTableEntry *entries = _allocate_obj(rt, size, kAllocOther);
+  memset(entries, 0, size);
+  return entries;
+}
+
+LishpHashTable *make_hash_table(Runtime *rt, HashTableTest test,
+                                uint32_t size) {
+  uint32_t capacity = MIN_CAPACITY;
+  while (capacity / 4 * 3 < size) {
+    assert(capacity < MAX_CAPACITY && "Hash table too big!");
+    capacity *= 2;
+  }
+
+  // neither allocation is reachable until the table is returned
+  pause_gc(rt->memory_manager);
+
+  LishpHashTable *table = ALLOCATE_OBJ(LishpHashTable, rt);
+  HashTableEntry *entries = allocate_entries(rt, capacity);
+  *table = (LishpHashTable){
+      .obj = {.type = kHashTable},
+      .test = test,
+      .count = 0,
+      .deleted = 0,
+      .capacity = capacity,
+      .address_keys = 0,
+      .hashed_at = inspect_compactions(rt->memory_manager),
+      .entries = entries,
+  };
+
+  resume_gc(rt->memory_manager);
+
+  return table;
+}
+
+// moves the live entries over to new ones with the given capacity, dropping
+// the deleted ones. the keys are only hashed again if rehash is set
+static void resize(Runtime *rt, LishpHashTable *table, uint32_t capacity,
+                   int rehash) {
+  HashTableEntry *entries = allocate_entries(rt, capacity);
+  uint32_t mask = capacity - 1;
+  uint32_t address_keys = 0;
+
+  for (uint32_t ind = 0; ind < table->capacity; ++ind) {
+    HashTableEntry *entry = &table->entries[ind];
+    if (!HASH_ENTRY_LIVE_P(entry)) {
+      continue;
+    }
+
+    uint64_t hash = entry->hash;
+    if (rehash) {
+      int by_address;
+      hash = hash_key(table, entry->key, &by_address);
+      address_keys += by_address;
+    }
+
+    uint32_t slot = hash & mask;
+    while (entries[slot].hash != EMPTY_SLOT) {
+      slot = (slot + 1) & mask;
+    }
+    entries[slot] = (HashTableEntry){
+        .hash = hash, .key = entry->key, .value = entry->value};
+  }
+
+  // the old entries are left for the collector
+  table->entries = entries;
+  other_write_barrier(rt, table, entries);
+  table->capacity = capacity;
+  table->deleted = 0;
+  if (rehash) {
+    table->address_keys = address_keys;
+  }
+}
+
+// a compaction may have moved some keys hashed by address since the table
+// last looked
+static void check_hashes(Runtime *rt, LishpHashTable *table) {
+  uint64_t compactions = inspect_compactions(rt->memory_manager);
+  if (table->hashed_at == compactions) {
+    return;
+  }
+
+  if (table->address_keys > 0) {
+    resize(rt, table, table->capacity, 1);
+  }
+  table->hashed_at = compactions;
+}
+
+// there is always an empty slot to stop at, since the table never fills up
+// past three quarters
+static HashTableEntry *find_entry(LishpHashTable *table, LishpForm key,
+                                  uint64_t hash) {
+  uint32_t mask = table->capacity - 1;
+
+  for (uint32_t slot = hash & mask;; slot = (slot + 1) & mask) {
+    HashTableEntry *entry = &table->entries[slot];
+    if (entry->hash == EMPTY_SLOT) {
+      return NULL;
+    }
+    if (entry->hash == hash && keys_match(table->test, entry->key, key)) {
+      return entry;
+    }
+  }
+}
+
+int hash_table_get(Runtime *rt, LishpHashTable *table, LishpForm key,
+                   LishpForm *value) {
+  check_hashes(rt, table);
+
+  int by_address;
+  HashTableEntry *entry =
+      find_entry(table, key, hash_key(table, key, &by_address));
+  if (entry == NULL) {
+    return 0;
+  }
+
+  *value = entry->value;
+  return 1;
+}
+
+void hash_table_put(Runtime *rt, LishpHashTable *table, LishpForm key,
+                    LishpForm value) {
+  check_hashes(rt, table);
+
+  int by_address;
+  uint64_t hash = hash_key(table, key, &by_address);
+
+  HashTableEntry *entry = find_entry(table, key, hash);
+  if (entry != NULL) {
+    entry->value = value;
+    FORM_WRITE_BARRIER(rt, table, value);
+    return;
+  }
+
+  if ((uint64_t)(table->count + table->deleted + 1) * 4 >
+      (uint64_t)table->capacity * 3) {
+    // when it's mostly deleted slots, getting rid of them makes enough room
+    uint32_t capacity = table->capacity;
+    if ((table->count + 1) * 2 > capacity) {
+      assert(capacity < MAX_CAPACITY && "Hash table too big!");
+      capacity *= 2;
+    }
+    resize(rt, table, capacity, 0);
+  }
+
+  uint32_t mask = table->capacity - 1;
+  uint32_t slot = hash & mask;
+  while (HASH_ENTRY_LIVE_P(&table->entries[slot])) {
+    slot = (slot + 1) & mask;
+  }
+
+  entry = &table->entries[slot];
+  if (entry->hash == DELETED_SLOT) {
+    --table->deleted;
+  }
+  *entry = (HashTableEntry){.hash = hash, .key = key, .value = value};
+
+  ++table->count;
+  table->address_keys += by_address;
+
+  FORM_WRITE_BARRIER(rt, table, key);
+  FORM_WRITE_BARRIER(rt, table, value);
+}
+
+int hash_table_remove(Runtime *rt, LishpHashTable *table, LishpForm key) {
+  check_hashes(rt, table);
+
+  int by_address;
+  HashTableEntry *entry =
+      find_entry(table, key, hash_key(table, key, &by_address));
+  if (entry == NULL) {
+    return 0;
+  }
+
+  // the slot still has to be probed past, but nothing in it is kept alive
+  *entry = (HashTableEntry){.hash = DELETED_SLOT, .key = NIL, .value = NIL};
+
+  --table->count;
+  ++table->deleted;
+  table->address_keys -= by_address;
+
+  return 1;
+}
@@ -44,21 +44,24 @@ typedef enum {
 typedef struct frame {
   Environment *env;
   FrameSource source;
+  LishpFunction *fn; // the function called, for kSourceFuncall frames
   struct frame *prev;
 } Frame;
 
+DEFINE_LIST(FrameList, frame_list, Frame)
+
 struct interpreter {
   Runtime *rt;
-  List last_return_value;
-  List form_stack;
-  List frame_stack;
+  FormList last_return_value;
+  FormList form_stack;
+  FrameList frame_stack;
 
-  OrderedMap function_environments; // LishpFunction * -> Environment *
-  OrderedMap environment_bindings;  // Environment * -> LishpForm -> uint32_t
+  HashMap function_environments; // LishpFunction * -> Environment *
+  HashMap environment_bindings;  // Environment * -> LishpForm -> uint32_t
 };
 
 static void get_top_frame_ref(Interpreter *interpreter, Frame **pframe) {
-  list_ref_last(&interpreter->frame_stack, sizeof(Frame), (void **)pframe);
+  frame_list_ref_last(&interpreter->frame_stack, pframe);
 }
 
 #define FORM_COUNT (sizeof(special_forms) / sizeof(special_forms[0]))
@@ -93,7 +96,8 @@ static SpecialForm is_special_form(LishpSymbol *sym) {
   return kSpNone;
 }
 
-static int push_environment(Interpreter *interpreter, FrameSource source);
+static int push_environment(Interpreter *interpreter, FrameSource source,
+                            LishpFunction *fn);
 static void pop_environment(Interpreter *interpreter);
 
 static int incrementer(void *arg, void *obj) {
@@ -316,7 +320,7 @@ static int push_args(List *res, LishpForm args, uint32_t *arg_count) {
 
 static int analyze_cons(List *res, LishpCons *cons, int with_ret) {
   LishpForm car = cons->car;
-  if (car.type != kObject) {
+  if (!OBJECT_P(car)) {
     return -1;
   }
 
@@ -359,12 +363,25 @@ static int analyze_object(List *res, LishpObject *object, int with_ret) {
   } break;
   case kSymbol: {
     PUSH_BYTE_2_TARGET(res, kOpPush, FROM_OBJ(object));
-    PUSH_BYTE_1(res, kOpLookupSymbol);
+
+    // FIXME: there is no KEYWORD package yet, so keywords are any symbol
+    // whose name starts with a colon, and they evaluate to themselves
+    if (AS(LishpSymbol, object)->lexeme[0] != ':') {
+      PUSH_BYTE_1(res, kOpLookupSymbol);
+    }
   } break;
   case kStream:
   case kString:
   case kFunction:
-  case kReadtable: {
+  case kReadtable:
+  case kBignum:
+  case kDoubleFloat:
+  case kSimpleVector:
+  case kFixnumVector:
+  case kDoubleFloatVector:
+  case kCharacterVector:
+  case kBitVector:
+  case kHashTable: {
     PUSH_BYTE_2_TARGET(res, kOpPush, FROM_OBJ(object));
   }
   }
@@ -376,11 +393,12 @@ static int analyze_object(List *res, LishpObject *object, int with_ret) {
 }
 
 static int analyze_form_rec(List *res, LishpForm form, int with_ret) {
-  switch (form.type) {
+  switch (FORM_TYPE(form)) {
   case kT:
   case kNil:
   case kChar:
-  case kFixnum: {
+  case kFixnum:
+  case kImmediateFloat: {
     PUSH_BYTE_2_TARGET(res, kOpPush, form);
   } break;
   case kObject: {
@@ -400,8 +418,7 @@ static int analyze_form(List *res, LishpForm form) {
 
 static void set_last_return(Interpreter *interpreter, LishpForm result) {
   LishpForm *pform = NULL;
-  list_ref_last(&interpreter->last_return_value, sizeof(LishpForm),
-                (void **)&pform);
+  form_list_ref_last(&interpreter->last_return_value, &pform);
 
   *pform = result;
 }
@@ -413,6 +430,12 @@ static int _form_cmp(void *l, void *r) {
   return form_cmp(*lptr, *rptr);
 }
 
+static uint32_t form_hash(void *key) {
+  LishpForm *form = key;
+
+  return hash_word(form->bits);
+}
+
 static int check_valid_tag(Interpreter *interpreter, LishpForm target) {
   Frame *cur_frame;
   get_top_frame_ref(interpreter, &cur_frame);
@@ -423,15 +446,15 @@ static int check_valid_tag(Interpreter *interpreter, LishpForm target) {
   do {
     Environment *env = cur_frame->env;
 
-    OrderedMap *form_to_index;
+    HashMap *form_to_index;
     int binding_ret =
-        map_ref(&interpreter->environment_bindings, sizeof(Environment *),
-                sizeof(OrderedMap), &env, (void **)&form_to_index);
+        hash_map_ref(&interpreter->environment_bindings, sizeof(Environment *),
+                     sizeof(HashMap), &env, (void **)&form_to_index);
 
     if (binding_ret == 0) {
       // there is a map of bindings for this environment...
-      int form_ret = map_ref(form_to_index, sizeof(LishpForm), sizeof(uint32_t),
-                             &target, NULL);
+      int form_ret = hash_map_ref(form_to_index, sizeof(LishpForm),
+                                  sizeof(uint32_t), &target, NULL);
       if (form_ret == 0) {
         // we have the target in the bindings somewhere up the stream
         return 1;
@@ -455,50 +478,50 @@ static int interpret_byte(Interpreter *interpreter, Bytecode *byte_v) {
   } break;
   case kOpPush: {
     LishpForm *target_ptr = &byte->target;
-    list_push(&interpreter->form_stack, sizeof(LishpForm), target_ptr);
+    form_list_push(&interpreter->form_stack, *target_ptr);
   } break;
   case kOpPop: {
-    list_pop(&interpreter->form_stack, sizeof(LishpForm), NULL);
+    form_list_pop(&interpreter->form_stack, NULL);
   } break;
   case kOpRetForm: {
     LishpForm result;
-    list_pop(&interpreter->form_stack, sizeof(LishpForm), &result);
+    form_list_pop(&interpreter->form_stack, &result);
 
     set_last_return(interpreter, result);
   } break;
   case kOpBindTag: {
     LishpForm *ptag_form;
-    list_ref_last(&interpreter->form_stack, sizeof(LishpForm),
-                  (void **)&ptag_form);
+    form_list_ref_last(&interpreter->form_stack, &ptag_form);
 
     uint32_t index = byte->index;
 
     Environment *cur_env = get_current_environment(interpreter);
-    OrderedMap *form_to_index;
+    HashMap *form_to_index;
 
     int ref_res =
-        map_ref(&interpreter->environment_bindings, sizeof(Environment *),
-                sizeof(OrderedMap), &cur_env, (void **)&form_to_index);
+        hash_map_ref(&interpreter->environment_bindings, sizeof(Environment *),
+                     sizeof(HashMap), &cur_env, (void **)&form_to_index);
 
     if (ref_res < 0) {
       // this environment has no bindings, so create a new map...
-      OrderedMap new_map;
-      map_init(&new_map, _form_cmp);
+      HashMap new_map;
+      hash_map_init(&new_map, form_hash, _form_cmp);
 
       // ... insert the binding...
-      map_insert(&new_map, sizeof(LishpForm), sizeof(uint32_t), ptag_form,
-                 &index);
+      hash_map_insert(&new_map, sizeof(LishpForm), sizeof(uint32_t), ptag_form,
+                      &index);
 
       // ... then put that new map in the environment bindings map
-      map_insert(&interpreter->environment_bindings, sizeof(Environment *),
-                 sizeof(OrderedMap), &cur_env, &new_map);
+      hash_map_insert(&interpreter->environment_bindings,
+                      sizeof(Environment *), sizeof(HashMap), &cur_env,
+                      &new_map);
     } else {
       // we already had some bindings, so add them to the existing map
-      map_insert(form_to_index, sizeof(LishpForm), sizeof(uint32_t), ptag_form,
-                 &index);
+      hash_map_insert(form_to_index, sizeof(LishpForm), sizeof(uint32_t),
+                      ptag_form, &index);
     }
 
-    list_pop(&interpreter->form_stack, sizeof(LishpForm), NULL);
+    form_list_pop(&interpreter->form_stack, NULL);
   } break;
   case kOpBindValue: {
     LishpForm *pvalue_form;
@@ -507,10 +530,8 @@ static int interpret_byte(Interpreter *interpreter, Bytecode *byte_v) {
     uint32_t stack_size = interpreter->form_stack.size;
     assert(stack_size > 1 && "Stack does not have the right size!");
 
-    list_ref(&interpreter->form_stack, sizeof(LishpForm), stack_size - 1,
-             (void **)&pvalue_form);
-    list_ref(&interpreter->form_stack, sizeof(LishpForm), stack_size - 2,
-             (void **)&pname_form);
+    form_list_ref(&interpreter->form_stack, stack_size - 1, &pvalue_form);
+    form_list_ref(&interpreter->form_stack, stack_size - 2, &pname_form);
 
     assert(IS_OBJECT_TYPE(*pname_form, kSymbol) &&
            "Cannot bind non-symbol value");
@@ -518,14 +539,14 @@ static int interpret_byte(Interpreter *interpreter, Bytecode *byte_v) {
     LishpSymbol *sym = AS_OBJECT(LishpSymbol, *pname_form);
 
     Environment *cur_env = get_current_environment(interpreter);
-    bind_value(cur_env, sym, *pvalue_form);
+    bind_value(interpreter->rt, cur_env, sym, *pvalue_form);
 
-    list_pop(&interpreter->form_stack, sizeof(LishpForm), NULL);
-    list_pop(&interpreter->form_stack, sizeof(LishpForm), NULL);
-    list_push(&interpreter->form_stack, sizeof(LishpForm), pvalue_form);
+    form_list_pop(&interpreter->form_stack, NULL);
+    form_list_pop(&interpreter->form_stack, NULL);
+    form_list_push(&interpreter->form_stack, *pvalue_form);
   } break;
   case kOpPushLexicalEnv: {
-    TEST_CALL(push_environment(interpreter, kSourceBytes));
+    TEST_CALL(push_environment(interpreter, kSourceBytes, NULL));
   } break;
   case kOpPopLexicalEnv: {
     pop_environment(interpreter);
@@ -537,8 +558,8 @@ static int interpret_byte(Interpreter *interpreter, Bytecode *byte_v) {
     assert(stack_size >= 1 + byte->arg_count &&
            "Stack does not have the right size!");
 
-    list_ref(&interpreter->form_stack, sizeof(LishpForm),
-             stack_size - (1 + byte->arg_count), (void **)&fn_form_ptr);
+    form_list_ref(&interpreter->form_stack, stack_size - (1 + byte->arg_count),
+                  &fn_form_ptr);
 
     assert(IS_OBJECT_TYPE(*fn_form_ptr, kFunction) &&
            "Cannot call non-function form!");
@@ -562,19 +583,18 @@ static int interpret_byte(Interpreter *interpreter, Bytecode *byte_v) {
       // function form
       //
       // for (uint32_t arg_i = 0; arg_i < byte->arg_count; ++arg_i) {
-      //   list_pop(&interpreter->form_stack, sizeof(LishpForm), NULL);
+      //   form_list_pop(&interpreter->form_stack, NULL);
       // }
-      // list_pop(&interpreter->form_stack, sizeof(LishpForm), NULL);
+      // form_list_pop(&interpreter->form_stack, NULL);
     } break;
     }
 
-    list_push(&interpreter->form_stack, sizeof(LishpForm), &funcall_result);
+    form_list_push(&interpreter->form_stack, funcall_result);
   } break;
   case kOpLookupSymbol: {
     LishpForm *form_ptr = NULL;
 
-    list_ref_last(&interpreter->form_stack, sizeof(LishpForm),
-                  (void **)&form_ptr);
+    form_list_ref_last(&interpreter->form_stack, &form_ptr);
 
     assert(IS_OBJECT_TYPE(*form_ptr, kSymbol) &&
            "Cannot lookup form that isn't a symbol!");
@@ -582,19 +602,17 @@ static int interpret_byte(Interpreter *interpreter, Bytecode *byte_v) {
     LishpSymbol *sym = AS_OBJECT(LishpSymbol, *form_ptr);
 
     Frame *frame_ptr = NULL;
-    list_ref_last(&interpreter->frame_stack, sizeof(Frame),
-                  (void **)&frame_ptr);
+    frame_list_ref_last(&interpreter->frame_stack, &frame_ptr);
 
     LishpForm form_val = symbol_value(rt, frame_ptr->env, sym);
 
-    list_pop(&interpreter->form_stack, sizeof(LishpForm), NULL);
-    list_push(&interpreter->form_stack, sizeof(LishpForm), &form_val);
+    form_list_pop(&interpreter->form_stack, NULL);
+    form_list_push(&interpreter->form_stack, form_val);
   } break;
   case kOpLookupFunction: {
     LishpForm *form_ptr = NULL;
 
-    list_ref_last(&interpreter->form_stack, sizeof(LishpForm),
-                  (void **)&form_ptr);
+    form_list_ref_last(&interpreter->form_stack, &form_ptr);
 
     assert(IS_OBJECT_TYPE(*form_ptr, kSymbol) &&
            "Cannot lookup form that isn't a symbol!");
@@ -602,14 +620,13 @@ static int interpret_byte(Interpreter *interpreter, Bytecode *byte_v) {
     LishpSymbol *sym = AS_OBJECT(LishpSymbol, *form_ptr);
 
     Frame *frame_ptr = NULL;
-    list_ref_last(&interpreter->frame_stack, sizeof(Frame),
-                  (void **)&frame_ptr);
+    frame_list_ref_last(&interpreter->frame_stack, &frame_ptr);
 
     LishpFunction *func_val = symbol_function(rt, frame_ptr->env, sym);
     LishpForm func_form = FROM_OBJ(func_val);
 
-    list_pop(&interpreter->form_stack, sizeof(LishpForm), NULL);
-    list_push(&interpreter->form_stack, sizeof(LishpForm), &func_form);
+    form_list_pop(&interpreter->form_stack, NULL);
+    form_list_push(&interpreter->form_stack, func_form);
   } break;
   case kOpGoReturn: {
     int is_valid = check_valid_tag(interpreter, byte->target);
@@ -617,7 +634,7 @@ static int interpret_byte(Interpreter *interpreter, Bytecode *byte_v) {
       // TODO: when restarts and other stuff gets built, add it in here.
       assert(0 && "Tag is unreachable!");
     }
-    list_push(&interpreter->form_stack, sizeof(LishpForm), &byte->target);
+    form_list_push(&interpreter->form_stack, byte->target);
     return 1;
   } break;
   }
@@ -636,7 +653,7 @@ static void handle_go_result(Interpreter *interpreter,
                              GoResultHandleResponse *response) {
 
   LishpForm target;
-  list_pop(&interpreter->form_stack, sizeof(LishpForm), &target);
+  form_list_pop(&interpreter->form_stack, &target);
 
   Frame *cur_frame;
   get_top_frame_ref(interpreter, &cur_frame);
@@ -645,10 +662,10 @@ static void handle_go_result(Interpreter *interpreter,
   while (!decision_made && cur_frame != NULL) {
     Environment *cur_env = cur_frame->env;
 
-    OrderedMap *form_to_bytecode_offset;
-    if (map_ref(&interpreter->environment_bindings, sizeof(Environment *),
-                sizeof(OrderedMap), &cur_env,
-                (void **)&form_to_bytecode_offset) < 0) {
+    HashMap *form_to_bytecode_offset;
+    if (hash_map_ref(&interpreter->environment_bindings, sizeof(Environment *),
+                     sizeof(HashMap), &cur_env,
+                     (void **)&form_to_bytecode_offset) < 0) {
 
       // there were no bindings for this environment, so it should be a
       // binding higher up, either return or continue up the environment chain
@@ -671,8 +688,8 @@ static void handle_go_result(Interpreter *interpreter,
     // there were bindings, so check them now
 
     uint32_t go_index;
-    if (map_get(form_to_bytecode_offset, sizeof(LishpForm), sizeof(uint32_t),
-                &target, &go_index) < 0) {
+    if (hash_map_get(form_to_bytecode_offset, sizeof(LishpForm),
+                     sizeof(uint32_t), &target, &go_index) < 0) {
 
       // form not found in the current environment bindings, so check in an
       // earlier one
@@ -731,7 +748,7 @@ static LishpFunctionReturn interpret_bytes(Interpreter *interpreter,
   }
 
   LishpForm result;
-  list_get_last(&interpreter->last_return_value, sizeof(LishpForm), &result);
+  form_list_get_last(&interpreter->last_return_value, &result);
 
   return SINGLE_RETURN(result);
 }
@@ -740,7 +757,14 @@ static int ptr_diff(void *l, void *r) {
   char **lptr = l;
   char **rptr = r;
 
-  return *lptr - *rptr;
+  // not the difference itself, which needn't fit in an int
+  return *lptr < *rptr ? -1 : *lptr > *rptr ? 1 : 0;
+}
+
+static uint32_t ptr_hash(void *key) {
+  char **ptr = key;
+
+  return hash_word((uintptr_t)*ptr);
 }
 
 int initialize_interpreter(Interpreter **pinterpreter, Runtime *rt,
@@ -754,46 +778,49 @@ int initialize_interpreter(Interpreter **pinterpreter, Runtime *rt,
 
   interpreter->rt = rt;
 
-  list_init(&interpreter->last_return_value);
-  list_init(&interpreter->form_stack);
-  list_init(&interpreter->frame_stack);
-  map_init(&interpreter->function_environments, ptr_diff);
-  map_init(&interpreter->environment_bindings, ptr_diff);
+  form_list_init(&interpreter->last_return_value);
+  form_list_init(&interpreter->form_stack);
+  frame_list_init(&interpreter->frame_stack);
+  hash_map_init(&interpreter->function_environments, ptr_hash, ptr_diff);
+  hash_map_init(&interpreter->environment_bindings, ptr_hash, ptr_diff);
 
   Frame first =
-      (Frame){.env = initial_env, .source = kSourceBase, .prev = NULL};
-  list_push(&interpreter->frame_stack, sizeof(Frame), &first);
+      (Frame){.env = initial_env, .source = kSourceBase, .fn = NULL,
+              .prev = NULL};
+  frame_list_push(&interpreter->frame_stack, first);
 
   LishpForm nil = NIL;
-  list_push(&interpreter->last_return_value, sizeof(LishpForm), &nil);
+  form_list_push(&interpreter->last_return_value, nil);
 
   return 0;
 }
 
 int cleanup_interpreter(Interpreter **interpreter) {
-  list_clear(&(*interpreter)->form_stack);
-  list_clear(&(*interpreter)->frame_stack);
+  form_list_clear(&(*interpreter)->form_stack);
+  frame_list_clear(&(*interpreter)->frame_stack);
   return 0;
 }
 
-static int form_mark_used_it(void *arg, void *obj) {
+static int form_mark_used_it(void *arg, LishpForm *form) {
   Runtime *rt = arg;
-  LishpForm *form = obj;
 
-  FORM_MARK_USED(rt, *form);
+  FORM_MARK_SLOT(rt, *form);
 
   return 0;
 }
 
-static void list_of_forms_mark_used(Runtime *rt, List *list) {
-  list_foreach(list, sizeof(LishpForm), form_mark_used_it, rt);
+static void list_of_forms_mark_used(Runtime *rt, FormList *list) {
+  form_list_foreach(list, form_mark_used_it, rt);
 }
 
-static int frame_mark_used_it(void *arg, void *obj) {
+static int frame_mark_used_it(void *arg, Frame *frame) {
   Runtime *rt = arg;
-  Frame *frame = obj;
 
   environment_mark_used(rt, frame->env);
+  if (frame->fn != NULL) {
+    // frames hold on to it by pointer, so it can't move
+    OBJ_MARK_USED(rt, frame->fn);
+  }
 
   return 0;
 }
@@ -823,11 +850,11 @@ static int binding_map_mark_used_it(void *arg, void *key, void *val) {
 static int env_bindings_mark_used_it(void *arg, void *key, void *val) {
   Runtime *rt = arg;
   Environment **env = key;
-  OrderedMap *binding_map = val;
+  HashMap *binding_map = val;
 
   environment_mark_used(rt, *env);
-  map_foreach(binding_map, sizeof(LishpForm), sizeof(uint32_t),
-              binding_map_mark_used_it, arg);
+  hash_map_foreach(binding_map, sizeof(LishpForm), sizeof(uint32_t),
+                   binding_map_mark_used_it, arg);
 
   return 0;
 }
@@ -839,14 +866,14 @@ void interpreter_mark_used_objs(Interpreter *interpreter) {
 
   list_of_forms_mark_used(rt, &interpreter->form_stack);
   list_of_forms_mark_used(rt, &interpreter->last_return_value);
-  list_foreach(&interpreter->frame_stack, sizeof(Frame), frame_mark_used_it,
-               rt);
+  frame_list_foreach(&interpreter->frame_stack, frame_mark_used_it, rt);
 
-  map_foreach(&interpreter->function_environments, sizeof(LishpFunction *),
-              sizeof(Environment *), func_envs_mark_used_it, rt);
+  hash_map_foreach(&interpreter->function_environments,
+                   sizeof(LishpFunction *), sizeof(Environment *),
+                   func_envs_mark_used_it, rt);
 
-  map_foreach(&interpreter->environment_bindings, sizeof(Environment *),
-              sizeof(OrderedMap), env_bindings_mark_used_it, rt);
+  hash_map_foreach(&interpreter->environment_bindings, sizeof(Environment *),
+                   sizeof(HashMap), env_bindings_mark_used_it, rt);
 }
 
 LishpFunctionReturn interpret(Interpreter *interpreter, LishpForm form) {
@@ -867,11 +894,11 @@ LishpFunctionReturn interpret(Interpreter *interpreter, LishpForm form) {
 
 int push_function(Interpreter *interpreter, LishpFunction *fn) {
   LishpForm fn_form = FROM_OBJ(fn);
-  return list_push(&interpreter->form_stack, sizeof(LishpForm), &fn_form);
+  return form_list_push(&interpreter->form_stack, fn_form);
 }
 
 int push_argument(Interpreter *interpreter, LishpForm form) {
-  return list_push(&interpreter->form_stack, sizeof(LishpForm), &form);
+  return form_list_push(&interpreter->form_stack, form);
 }
 
 LishpFunctionReturn interpret_function_call(Interpreter *interpreter,
@@ -880,27 +907,28 @@ LishpFunctionReturn interpret_function_call(Interpreter *interpreter,
   Runtime *rt = interpreter->rt;
   uint32_t fn_index = interpreter->form_stack.size - (1 + arg_count);
 
-  int push_env_result = push_environment(interpreter, kSourceFuncall);
-
   LishpForm *fn_form;
-  list_ref(&interpreter->form_stack, sizeof(LishpForm), fn_index,
-           (void **)&fn_form);
+  form_list_ref(&interpreter->form_stack, fn_index, &fn_form);
 
   LishpFunction *fn = AS_OBJECT(LishpFunction, *fn_form);
 
+  int push_env_result = push_environment(interpreter, kSourceFuncall, fn);
+
   List bytes;
   list_init(&bytes);
 
   LishpForm evaled_args_form = NIL;
-  list_push(&interpreter->form_stack, sizeof(LishpForm), &evaled_args_form);
+  form_list_push(&interpreter->form_stack, evaled_args_form);
 
-  LishpCons **cur_cons = NULL;
+  // the last cons of the evaluated argument list. the head of the list lives
+  // on the form stack, which can be reallocated while evaluating arguments, so
+  // it is looked up by index rather than held by pointer
+  LishpCons *last_cons = NULL;
   uint32_t pevaled_index = interpreter->form_stack.size - 1;
 
   for (uint32_t arg_i = 0; arg_i < arg_count; ++arg_i) {
     LishpForm *pform;
-    list_ref(&interpreter->form_stack, sizeof(LishpForm), fn_index + 1 + arg_i,
-             (void **)&pform);
+    form_list_ref(&interpreter->form_stack, fn_index + 1 + arg_i, &pform);
 
     int analyze_res = analyze_form(&bytes, *pform);
     if (analyze_res < 0) {
@@ -912,43 +940,28 @@ LishpFunctionReturn interpret_function_call(Interpreter *interpreter,
 
     CHECK_GO_RET(arg_val);
 
-    // cur_pevaled is the pointer to the form that is about to be turned from
-    // NIL to a Cons
-
-    // cur_cons _will_ get assigned to be a pointer to the address of the newly
-    // created cons, so coming in, it's pointer to the address of the
-    // _previously_ allocated cons
+    LishpCons *new_alloc = ALLOCATE_OBJ(LishpCons, rt);
+    *new_alloc = CONS(arg_val.first_return, NIL);
 
-    LishpForm *cur_pevaled;
-    if (cur_cons == NULL) {
-      // first iteration, get the form from the stack
-      list_ref(&interpreter->form_stack, sizeof(LishpForm), pevaled_index,
-               (void **)&cur_pevaled);
+    if (last_cons == NULL) {
+      // first iteration, change the form on the stack from NIL to the cons
+      LishpForm *pevaled;
+      form_list_ref(&interpreter->form_stack, pevaled_index, &pevaled);
 
-      // get a valid reference to the object field of the form on the stack
-      cur_cons = (LishpCons **)&cur_pevaled->object;
+      *pevaled = FROM_OBJ(new_alloc);
     } else {
-      cur_pevaled = &(*cur_cons)->cdr;
+      // last_cons may have been promoted while allocating new_alloc
+      last_cons->cdr = FROM_OBJ(new_alloc);
+      OBJ_WRITE_BARRIER(rt, last_cons, new_alloc);
     }
 
-    LishpCons *new_alloc = ALLOCATE_OBJ(LishpCons, rt);
-
-    // change it from NIL to an object
-    *cur_pevaled = FROM_OBJ(NULL);
-
-    // get the pointer of the address of the cons to be created
-    cur_cons = (LishpCons **)&cur_pevaled->object;
-    // set the address of the cons to be what comes from the allocator
-    *cur_cons = new_alloc;
-    // fill in the cons fields
-    **cur_cons = CONS(arg_val.first_return, NIL);
+    last_cons = new_alloc;
   }
 
   LishpList arg_list = NIL_LIST;
   if (arg_count != 0) {
     LishpForm *pevaled;
-    list_ref(&interpreter->form_stack, sizeof(LishpForm), pevaled_index,
-             (void **)&pevaled);
+    form_list_ref(&interpreter->form_stack, pevaled_index, &pevaled);
 
     LishpCons *arg_cons = AS_OBJECT(LishpCons, *pevaled);
     arg_list = LIST_OF(arg_cons);
@@ -958,13 +971,13 @@ LishpFunctionReturn interpret_function_call(Interpreter *interpreter,
   set_last_return(interpreter, result.first_return);
 
   // pop off the evaled_args_form
-  list_pop(&interpreter->form_stack, sizeof(LishpForm), NULL);
+  form_list_pop(&interpreter->form_stack, NULL);
   // pop the arguments
   for (uint32_t arg_i = 0; arg_i < arg_count; ++arg_i) {
-    list_pop(&interpreter->form_stack, sizeof(LishpForm), NULL);
+    form_list_pop(&interpreter->form_stack, NULL);
   }
   // pop the function form
-  list_pop(&interpreter->form_stack, sizeof(LishpForm), NULL);
+  form_list_pop(&interpreter->form_stack, NULL);
 
   pop_environment(interpreter);
 
@@ -974,15 +987,14 @@ LishpFunctionReturn interpret_function_call(Interpreter *interpreter,
 int push_form_return(Interpreter *interpreter, LishpForm **pform) {
   LishpForm nil_form = NIL;
 
-  TEST_CALL(list_push(&interpreter->form_stack, sizeof(LishpForm), &nil_form));
-  TEST_CALL(list_ref_last(&interpreter->form_stack, sizeof(LishpForm),
-                          (void **)pform));
+  TEST_CALL(form_list_push(&interpreter->form_stack, nil_form));
+  TEST_CALL(form_list_ref_last(&interpreter->form_stack, pform));
 
   return 0;
 }
 
 int pop_form_return(Interpreter *interpreter, LishpForm *result) {
-  TEST_CALL(list_pop(&interpreter->form_stack, sizeof(LishpForm), result));
+  TEST_CALL(form_list_pop(&interpreter->form_stack, result));
   return 0;
 }
 
@@ -990,7 +1002,7 @@ int bind_symbol_value(Interpreter *interpreter, LishpSymbol *sym,
                       LishpForm value) {
 
   Environment *env = get_current_environment(interpreter);
-  bind_value(env, sym, value);
+  bind_value(interpreter->rt, env, sym, value);
   // TODO: make this function void, or make bind return an int?
   return 0;
 }
@@ -1005,7 +1017,22 @@ Environment *get_current_environment(Interpreter *interpreter) {
   return cur_env;
 }
 
-static int push_environment(Interpreter *interpreter, FrameSource source) {
+LishpFunction *current_function(Interpreter *interpreter) {
+  // frames pushed for bytes belong to the function that is running them
+  for (uint32_t ind = interpreter->frame_stack.size; ind > 0; --ind) {
+    Frame *frame;
+    frame_list_ref(&interpreter->frame_stack, ind - 1, &frame);
+
+    if (frame->source == kSourceFuncall) {
+      return frame->fn;
+    }
+  }
+
+  return NULL;
+}
+
+static int push_environment(Interpreter *interpreter, FrameSource source,
+                            LishpFunction *fn) {
   Frame *ptop_frame;
   get_top_frame_ref(interpreter, &ptop_frame);
 
@@ -1017,15 +1044,16 @@ static int push_environment(Interpreter *interpreter, FrameSource source) {
   Frame new_frame = (Frame){
       .env = new_env,
       .source = source,
+      .fn = fn,
       .prev = ptop_frame,
   };
 
   LishpForm nil = NIL;
-  TEST_CALL_LABEL(cleanup, list_push(&interpreter->last_return_value,
-                                     sizeof(LishpForm), &nil));
+  TEST_CALL_LABEL(cleanup,
+                  form_list_push(&interpreter->last_return_value, nil));
 
-  TEST_CALL_LABEL(
-      cleanup, list_push(&interpreter->frame_stack, sizeof(Frame), &new_frame));
+  TEST_CALL_LABEL(cleanup,
+                  frame_list_push(&interpreter->frame_stack, new_frame));
 
   return 0;
 
@@ -1036,14 +1064,13 @@ cleanup:
 
 static void pop_environment(Interpreter *interpreter) {
   LishpForm last_return;
-  list_pop(&interpreter->last_return_value, sizeof(LishpForm), &last_return);
-  list_pop(&interpreter->frame_stack, sizeof(Frame), NULL);
+  form_list_pop(&interpreter->last_return_value, &last_return);
+  frame_list_pop(&interpreter->frame_stack, NULL);
 
   // TODO: verify that every time I pop a lexical environment I want to be
   // setting the previous last return to the return of the popped environment...
   LishpForm *prev_last_return;
-  list_ref_last(&interpreter->last_return_value, sizeof(LishpForm),
-                (void **)&prev_last_return);
+  form_list_ref_last(&interpreter->last_return_value, &prev_last_return);
 
   *prev_last_return = last_return;
 }
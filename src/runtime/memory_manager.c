@@ -1,134 +1,1720 @@
+#define _GNU_SOURCE // for MAP_ANONYMOUS and pthread_getattr_np
+
 #include <assert.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "runtime/memory_manager.h"
+#include "util.h"
+
+#define BLOCK_SIZE MEGABYTES(4)
+#define PAGE_SIZE 4096
+#define PAGES_PER_BLOCK (BLOCK_SIZE / PAGE_SIZE)
+
+// round up to a multiple of a power of two
+#define ROUND_UP(n, to) (((n) + ((to) - 1)) & ~(uint64_t)((to) - 1))
+
+// the next full collection happens once the old heap has grown by a
+// percentage of what was live after the last one, but by at least
+// MIN_GC_GROWTH so that a small heap isn't collected over and over
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+#define NEXT_GC_CHECK(live, percent)                                           \
+  ((live) + MAX((live) * (percent) / 100, MIN_GC_GROWTH))
+
+#ifdef DEBUG_MEMORY
+// collect on every allocation, so that unrooted objects get caught quickly.
+// with a nursery that is a minor collection, with a full collection after
+// every few hundred bytes promoted, so that missing write barriers show up
+#define MIN_GC_GROWTH 512
+#else
+#define MIN_GC_GROWTH BLOCK_SIZE
+#endif
+
+#ifdef DEBUG_MEMORY
+// incremental marking does a tiny slice on every allocation, so the mutator
+// runs as much as possible in between
+#define MARK_SLICE_BYTES 0
+#define MARK_SLICE_OBJECTS 8
+// overflow the mark stack all the time, to exercise recovering from it
+#define MARK_STACK_LIMIT 4
+// mark every full collection in parallel, handing work over in tiny batches
+#define PARALLEL_MARK_HEAP 0
+#define SHARE_BATCH 2
+#else
+// how much is allocated between slices of incremental marking, and how many
+// objects are marked between checks of the clock
+#define MARK_SLICE_BYTES (64 << 10)
+#define MARK_SLICE_OBJECTS 256
+// the most entries the mark stack can hold before it overflows
+#define MARK_STACK_LIMIT (1 << 20)
+// the smallest heap worth waking the marking threads for, and how many
+// entries a thread hands over to the shared stack at a time
+#define PARALLEL_MARK_HEAP MEGABYTES(16)
+#define SHARE_BATCH 64
+#endif
+
+// the most threads a full collection marks with when left to pick one per
+// core
+#define MAX_MARK_THREADS 8
+
+// every chunk is rounded up to a multiple of the alignment, so that small
+// chunks of the same payload size all land in the same size class. forms tag
+// immediates in the low three bits that this leaves clear in every pointer
+#define ALIGNMENT 8
+#define ALIGN_UP(n) (((n) + (ALIGNMENT - 1)) & ~(uint64_t)(ALIGNMENT - 1))
+
+// payloads up to this size are served from an exact-fit bin, anything larger
+// goes through the general first-fit list
+#define SMALL_SIZE_LIMIT 256
+#define SIZE_CLASS_COUNT (SMALL_SIZE_LIMIT / ALIGNMENT)
+#define SIZE_CLASS(payload) (((payload) / ALIGNMENT) - 1)
+
+// the smallest chunk that can be split off, a header and one aligned word
+#define MIN_CHUNK_SIZE (sizeof(MarkingInfo) + ALIGNMENT)
+
+// payloads over this size go in the large object space, each in a block of
+// its own that is mapped just big enough to hold it
+#ifdef DEBUG_MEMORY
+// small enough that some of the runtime's own allocations are large
+#define LARGE_OBJECT_SIZE 64
+#else
+#define LARGE_OBJECT_SIZE (32 << 10)
+#endif
+
+// payloads up to this size are bump allocated in the nursery, anything larger
+// is allocated from the free lists straight away so that it doesn't cut the
+// current hole short
+#define NURSERY_SIZE_LIMIT 4096
+
+#define CHECK_FOR_GARBAGE
+
+// the most distinct tracers a manager can be handed, so that a chunk can
+// keep the one it was marked with in a byte
+#define TRACER_LIMIT 256
+
+// Every chunk starts with this header. A chunk is marked by setting the bit
+// for its first word in its block's mark bitmap, so a chunk that was already
+// marked can be skipped without touching it. Grey chunks are the marked ones
+// that haven't been traced yet.
+typedef struct marking_info {
+  uint32_t size;
+  uint8_t allocated : 1;
+  uint8_t young : 1;  // allocated since the last collection, not yet promoted
+  uint8_t pinned : 1; // marked through a reference that compaction can't update
+  uint8_t grey;
+  uint8_t tracer; // index into the manager's tracers, of the tracer the chunk
+                  // was marked with
+} MarkingInfo;
+
+static_assert(MAX_ALLOCATION_SIZE <=
+                  UINT32_MAX - sizeof(MarkingInfo) - ALIGNMENT,
+              "The biggest chunk's size has to fit in its header");
+
+// a free chunk links to the next one on its free list through its payload,
+// which always has room for a pointer
+#define NEXT_FREE(chunk) (*(MarkingInfo **)((chunk) + 1))
+
+// a run of chunks that were bump allocated out of a single hole
+typedef struct {
+  MarkingInfo *start;
+  char *end;
+} YoungRange;
+
+// an allocation that has been marked, but whose references haven't been
+typedef struct {
+  void *ptr;
+  Tracer tracer;
+} GreyEntry;
+
+// a reference that compaction has to update, and what it pointed at
+typedef struct {
+  void **slot;
+  void *target;
+} SlotEntry;
+
+// space between chunks that compaction left empty
+typedef struct {
+  char *start;
+  char *end;
+} Gap;
+
+// where compaction moves a live chunk to, and its size once it is there,
+// which can take in a sliver of free space too small for a header
+typedef struct {
+  MarkingInfo *from;
+  MarkingInfo *to;
+  uint32_t moved_size;
+} Forward;
+
+// where compaction moves chunks to. they are placed one after the other from
+// top up to limit, which is either the next chunk that stays or the end of
+// the block
+typedef struct {
+  struct block *block;
+  char *top;
+  char *limit;
+  uint32_t stay_ind; // the next chunk in stays
+} CompactCursor;
+
+// a thread that helps mark full collections, and waits for the next one in
+// between
+typedef struct {
+  struct manager *manager;
+  pthread_t thread;
+  List grey; // void *, this thread's own mark stack
+} MarkWorker;
+
+typedef enum {
+  kGcIdle,
+  kGcMarking, // an incremental collection is part way through marking
+} GcPhase;
+
+// Blocks are mapped at BLOCK_SIZE alignment with this header at the front, so
+// the block owning a chunk can be found by masking the chunk's address. A
+// large allocation gets a large block all to itself, which is unmapped as soon
+// as that allocation dies. Large blocks only have room for the front of the
+// header, up to the word of the mark bitmap that their one chunk uses, and the
+// chunk starts right after it.
+typedef struct block {
+  struct block *next;
+  uint64_t mapped_size;
+  uint32_t live_chunks; // the block is empty, and can be unmapped, at 0
+  int large;
+  int unswept; // still holds the marks of the last full collection
+  // the range of forwards for chunks in this block, while compacting
+  uint32_t first_forward;
+  uint32_t forward_count;
+  // pages that the C stack might point into, which compaction leaves alone
+  uint32_t pinned_pages[PAGES_PER_BLOCK / 32];
+  // a bit for every aligned word in the block, set for the first word of
+  // each marked chunk
+  uint64_t marks[BLOCK_SIZE / ALIGNMENT / 64];
+} Block;
+
+#define BLOCK_HEADER_SIZE ROUND_UP(sizeof(Block), ALIGNMENT)
+#define BLOCK_OF(chunk) ((Block *)((uintptr_t)(chunk) & ~(uintptr_t)(BLOCK_SIZE - 1)))
+#define FIRST_CHUNK(block) ((MarkingInfo *)((char *)(block) + BLOCK_HEADER_SIZE))
+#define LARGE_HEADER_SIZE 1024
+#define LARGE_CHUNK(block) ((MarkingInfo *)((char *)(block) + LARGE_HEADER_SIZE))
+#define MARK_INDEX(chunk) (((uintptr_t)(chunk) & (BLOCK_SIZE - 1)) / ALIGNMENT)
+
+static_assert(offsetof(Block, marks) +
+                      (LARGE_HEADER_SIZE / ALIGNMENT / 64 + 1) *
+                          sizeof(uint64_t) <=
+                  LARGE_HEADER_SIZE,
+              "A large chunk's mark has to come before the chunk");
+static_assert(LARGE_HEADER_SIZE + sizeof(MarkingInfo) + LARGE_OBJECT_SIZE <=
+                  BLOCK_SIZE - BLOCK_HEADER_SIZE,
+              "Anything too big for a regular block has to be large");
+
+struct manager {
+  Block *first_block;
+  uint64_t heap_size; // bytes mapped for all of the blocks
+  uint64_t max_heap_size;
+
+  MarkingInfo *first_free; // general free list, for chunks of any size
+  MarkingInfo *bins[SIZE_CLASS_COUNT]; // exact-fit free lists for small chunks
+
+  // The nursery bump allocates out of a hole taken off of the free lists.
+  // Everything allocated since the last collection is young, and a minor
+  // collection only traces and sweeps young objects, promoting the survivors
+  // in place. Old objects that are changed to point at young ones have to be
+  // reported through needs_remembering, since a minor collection never looks
+  // inside of them.
+  uint64_t nursery_size; // 0 when there is no nursery
+  uint64_t nursery_allocated; // bytes bump allocated since the last collection
+  char *hole_start;
+  char *hole_top;
+  char *hole_limit;
+  List young_ranges; // YoungRange, for the holes that have been used up
+  List young_large; // MarkingInfo *, young chunks not in the nursery
+  int young_overflowed; // couldn't record a young chunk or a remembered
+                        // allocation, so the next collection has to be full
+  int minor_gc; // currently running a minor collection
+  List remembered; // GreyEntry, young allocations stored into old ones
+
+  // Marking greys allocations onto the mark stack, and they are traced when
+  // they come off of it. With a slice time, a full collection marks a slice
+  // at a time between allocations. New references from black allocations
+  // are greyed by the write barrier, and the roots are marked again in the
+  // final pause since they don't have one.
+  //
+  // The mark stack is bounded. When it overflows, allocations are still
+  // greyed but not pushed, and once the stack runs dry the heap is scanned
+  // for grey chunks to push. Since each chunk keeps its tracer, nothing
+  // about it is lost by not being on the stack.
+  List grey; // void *, the allocations as handed out
+  int grey_overflowed;
+  Tracer tracers[TRACER_LIMIT];
+  uint32_t tracer_count;
+  GcPhase phase;
+  uint64_t mark_slice_ns; // 0 when collections aren't incremental
+  uint64_t allocated_at_last_slice;
+  GcPauseTimes pauses;
+
+  // The final drain of a full collection can be spread over worker threads,
+  // with the collecting thread marking from grey and each worker from its
+  // own stack. Chunks are marked with an atomic or into their block's mark
+  // bitmap, so only the thread that set the bit traces the chunk. A thread with a long stack
+  // moves a batch of it over to shared_grey while another is idle, and an
+  // idle thread takes its work from there. Marking is done once every thread
+  // is idle with shared_grey empty. Overflow is left for the collecting
+  // thread to rescan after the workers are done.
+  MarkWorker *workers;
+  uint32_t worker_count; // marking threads, not counting the collecting one
+  int parallel_marking;  // the workers are currently marking
+  pthread_mutex_t mark_lock; // guards everything below
+  pthread_cond_t mark_start; // a round of marking starts, or workers_exit
+  pthread_cond_t mark_ready; // shared_grey was filled, or marking is done
+  pthread_cond_t mark_finished; // a worker finished its round
+  uint64_t mark_round;
+  uint32_t idle_markers;
+  uint32_t workers_finished; // in the current round
+  int workers_exit;
+  List shared_grey; // void *
+
+  // Compaction slides the survivors of a full collection towards the front of
+  // the heap, and only happens when the runtime says it is safe to. The
+  // references reported with mark_slot are logged while marking so they can
+  // be pointed at the new addresses. Anything that might be referenced in a
+  // way the manager can't update, either through mark_used or from the C
+  // stack, stays where it is and the others are moved around it.
+  int compact; // compaction is turned on
+  int compacting; // currently marking for a compaction
+  char *stack_base; // the top of the C stack, which grows down towards it
+  List slots; // SlotEntry
+  List stays; // MarkingInfo *, pinned chunks in the order compaction meets them
+  List gaps; // Gap
+  List forwards; // Forward, in the order the chunks are moved
+  uint64_t fragmented_bytes; // free space in blocks that still have live
+                             // chunks, after the last full collection
+  uint64_t compacted_at; // full_collections at the last compaction
+
+  // Sweeping is lazy. A full collection only flags every block as unswept
+  // once it is done marking, and the free lists start out empty. The
+  // allocator sweeps a block at a time whenever they can't serve it, and the
+  // next full collection sweeps whatever is left before it marks. The
+  // survivors in an unswept block keep their marks and young flags until it
+  // is swept, so they are treated as old in the meantime. The live bytes,
+  // and so when the next full collection is due, are only known once the
+  // last block has been swept.
+  uint32_t unswept_blocks;
+  int kept_empty_block; // a block swept since the collection came up empty,
+                        // and was kept rather than unmapped
+  uint64_t swept_live_bytes;  // survivors found by the sweep so far
+  uint64_t swept_freed_bytes; // garbage found by the sweep so far
+
+  uint64_t gc_growth_percent;
+  GcCycleStats cycles; // next_gc_bytes is the old heap size that triggers the
+                       // next full collection
+
+  // these are cumulative over the life of the manager, so they need to be
+  // wide enough to not wrap around on long-running programs
+  uint64_t allocated_bytes;
+  uint64_t freed_bytes;
+  uint64_t promoted_bytes; // allocations that made it into the old heap
+  uint64_t promoted_at_last_gc;
+  uint32_t gc_paused; // nesting count of pause_gc calls
+  RuntimeMarker runtime_marker;
+  CollectionHook collection_hook; // NULL unless set_collection_hook was called
+  struct runtime *rt;
+};
+
+static Block *map_block(uint64_t size) {
+  // map an extra block's worth so that an aligned block can be carved out of
+  // the middle, then give back the unaligned ends
+  uint64_t mapped_size = size + BLOCK_SIZE;
+  char *mapped = mmap(NULL, mapped_size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (mapped == MAP_FAILED) {
+    return NULL;
+  }
+
+  char *start = (char *)ROUND_UP((uintptr_t)mapped, BLOCK_SIZE);
+  uint64_t head = start - mapped;
+  uint64_t tail = mapped_size - head - size;
+
+  if (head > 0) {
+    munmap(mapped, head);
+  }
+  if (tail > 0) {
+    munmap(start + size, tail);
+  }
+
+  Block *block = (Block *)start;
+  block->next = NULL;
+  block->mapped_size = size;
+  block->live_chunks = 0;
+  block->large = 0;
+  block->unswept = 0;
+
+  return block;
+}
+
+static void unmap_block(Block *block) { munmap(block, block->mapped_size); }
+
+static void free_list_push(MemoryManager *manager, MarkingInfo *chunk);
+
+static void clear_free_lists(MemoryManager *manager) {
+  manager->first_free = NULL;
+  for (uint32_t bin = 0; bin < SIZE_CLASS_COUNT; ++bin) {
+    manager->bins[bin] = NULL;
+  }
+}
+
+// maps a block of size bytes and adds it to the heap, with a single free chunk
+// starting first_chunk bytes in. returns NULL if that would go over the
+// maximum heap size
+static Block *add_block(MemoryManager *manager, uint64_t size,
+                        uint64_t first_chunk) {
+  if (manager->max_heap_size != 0 &&
+      manager->heap_size + size > manager->max_heap_size) {
+    return NULL;
+  }
+
+  Block *block = map_block(size);
+  if (block == NULL) {
+    return NULL;
+  }
+
+  block->next = manager->first_block;
+  manager->first_block = block;
+  manager->heap_size += size;
+
+  MarkingInfo *chunk = (MarkingInfo *)((char *)block + first_chunk);
+  chunk->allocated = 0;
+  chunk->young = 0;
+  chunk->pinned = 0;
+  chunk->grey = 0;
+  chunk->size = size - first_chunk;
+
+  return block;
+}
+
+// maps a new regular block and puts its space on the free lists
+static Block *grow_heap(MemoryManager *manager) {
+  Block *block = add_block(manager, BLOCK_SIZE, BLOCK_HEADER_SIZE);
+  if (block != NULL) {
+    free_list_push(manager, FIRST_CHUNK(block));
+  }
+
+  return block;
+}
+
+// maps a large block for a chunk of chunk_size bytes. any slack at the end of
+// the last page stays unused
+static Block *map_large(MemoryManager *manager, uint64_t chunk_size) {
+  uint64_t size = ROUND_UP(LARGE_HEADER_SIZE + chunk_size, PAGE_SIZE);
+
+  Block *block = add_block(manager, size, LARGE_HEADER_SIZE);
+  if (block != NULL) {
+#ifdef MADV_POPULATE_WRITE
+    // it is about to be filled in, and faulting it all in up front is
+    // cheaper than a page at a time. older kernels just ignore this
+    madvise(block, size, MADV_POPULATE_WRITE);
+#endif
+    block->large = 1;
+    LARGE_CHUNK(block)->size = chunk_size;
+  }
+
+  return block;
+}
+
+// the top of the calling thread's stack, or NULL if it can't be found
+static char *find_stack_base() {
+  pthread_attr_t attr;
+  if (pthread_getattr_np(pthread_self(), &attr) != 0) {
+    return NULL;
+  }
+
+  void *stack_addr;
+  size_t stack_size;
+  int result = pthread_attr_getstack(&attr, &stack_addr, &stack_size);
+  pthread_attr_destroy(&attr);
+
+  return result == 0 ? (char *)stack_addr + stack_size : NULL;
+}
+
+static void start_workers(MemoryManager *manager, uint32_t count);
+
+int initialize_manager(MemoryManager **pmanager, RuntimeMarker runtime_marker,
+                       struct runtime *rt, ManagerSettings settings) {
+
+  MemoryManager *manager = calloc(1, sizeof(MemoryManager));
+  if (manager == NULL) {
+    return -1;
+  }
+
+  manager->first_block = NULL;
+  manager->heap_size = 0;
+  manager->max_heap_size = settings.max_heap_size;
+  if (manager->max_heap_size != 0 && manager->max_heap_size < BLOCK_SIZE) {
+    // there has to be room for at least one block
+    manager->max_heap_size = BLOCK_SIZE;
+  }
+  clear_free_lists(manager);
+  manager->nursery_size = settings.nursery_size;
+  manager->nursery_allocated = 0;
+  manager->hole_start = NULL;
+  manager->hole_top = NULL;
+  manager->hole_limit = NULL;
+  list_init(&manager->young_ranges);
+  list_init(&manager->young_large);
+  manager->young_overflowed = 0;
+  manager->minor_gc = 0;
+  list_init(&manager->remembered);
+  list_init(&manager->grey);
+  manager->grey_overflowed = 0;
+  manager->tracer_count = 0;
+  manager->phase = kGcIdle;
+  manager->mark_slice_ns = settings.mark_slice_us * 1000;
+  manager->allocated_at_last_slice = 0;
+  manager->pauses =
+      (GcPauseTimes){.count = 0, .total_ns = 0, .max_ns = 0, .histogram = {0}};
+  manager->compact = settings.compact != 0;
+  manager->compacting = 0;
+  manager->stack_base = find_stack_base();
+  if (manager->stack_base == NULL) {
+    // without the stack there is no telling what C code is holding on to
+    manager->compact = 0;
+  }
+  list_init(&manager->slots);
+  list_init(&manager->stays);
+  list_init(&manager->gaps);
+  list_init(&manager->forwards);
+  manager->fragmented_bytes = 0;
+  manager->compacted_at = 0;
+  manager->workers = NULL;
+  manager->worker_count = 0;
+  manager->parallel_marking = 0;
+  pthread_mutex_init(&manager->mark_lock, NULL);
+  pthread_cond_init(&manager->mark_start, NULL);
+  pthread_cond_init(&manager->mark_ready, NULL);
+  pthread_cond_init(&manager->mark_finished, NULL);
+  manager->mark_round = 0;
+  manager->idle_markers = 0;
+  manager->workers_finished = 0;
+  manager->workers_exit = 0;
+  list_init(&manager->shared_grey);
+  manager->unswept_blocks = 0;
+  manager->kept_empty_block = 0;
+  manager->swept_live_bytes = 0;
+  manager->swept_freed_bytes = 0;
+  manager->gc_growth_percent = settings.gc_growth_percent;
+  manager->cycles = (GcCycleStats){.full_collections = 0,
+                                   .minor_collections = 0,
+                                   .compactions = 0,
+                                   .live_bytes = 0,
+                                   .reclaimed_bytes = 0,
+                                   .minor_reclaimed_bytes = 0,
+                                   .next_gc_bytes = NEXT_GC_CHECK(
+                                       0, settings.gc_growth_percent)};
+  manager->allocated_bytes = 0;
+  manager->freed_bytes = 0;
+  manager->promoted_bytes = 0;
+  manager->promoted_at_last_gc = 0;
+  manager->gc_paused = 0;
+  manager->runtime_marker = runtime_marker;
+  manager->collection_hook = NULL;
+  manager->rt = rt;
+
+  if (grow_heap(manager) == NULL) {
+    free(manager);
+    return -1;
+  }
+
+  uint64_t mark_threads = settings.mark_threads;
+  if (mark_threads == 0) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    mark_threads = cores > MAX_MARK_THREADS ? MAX_MARK_THREADS
+                   : cores > 0              ? cores
+                                            : 1;
+  }
+  start_workers(manager, mark_threads - 1);
+
+  *pmanager = manager;
+
+  return 0;
+}
+
+static int is_marked(MarkingInfo *chunk) {
+  uint64_t index = MARK_INDEX(chunk);
+  uint64_t word =
+      __atomic_load_n(&BLOCK_OF(chunk)->marks[index / 64], __ATOMIC_RELAXED);
+
+  return (word >> (index % 64)) & 1;
+}
+
+// marks a chunk, returning 0 if it already was. the bit is set atomically
+// while other threads are marking too, so only one of them gets a 1
+static int set_mark(MemoryManager *manager, MarkingInfo *chunk) {
+  uint64_t index = MARK_INDEX(chunk);
+  uint64_t *word = &BLOCK_OF(chunk)->marks[index / 64];
+  uint64_t bit = (uint64_t)1 << (index % 64);
+
+  if (manager->parallel_marking) {
+    return (__atomic_fetch_or(word, bit, __ATOMIC_RELAXED) & bit) == 0;
+  }
+
+  int was_marked = (*word & bit) != 0;
+  *word |= bit;
+  return !was_marked;
+}
+
+static void clear_mark(MarkingInfo *chunk) {
+  uint64_t index = MARK_INDEX(chunk);
+  BLOCK_OF(chunk)->marks[index / 64] &= ~((uint64_t)1 << (index % 64));
+}
+
+// clears the marks of every chunk from start up to end, which are in the same
+// block
+static void clear_marks(MarkingInfo *start, char *end) {
+  Block *block = BLOCK_OF(start);
+  uint64_t first = MARK_INDEX(start);
+  uint64_t last = (end - (char *)block) / ALIGNMENT;
+
+  while (first < last) {
+    uint64_t from = first % 64;
+    uint64_t to = from + (last - first) < 64 ? from + (last - first) : 64;
+    uint64_t mask = (to == 64 ? ~(uint64_t)0 : ((uint64_t)1 << to) - 1) &
+                    ~(((uint64_t)1 << from) - 1);
+
+    block->marks[first / 64] &= ~mask;
+    first += to - from;
+  }
+}
+
+// frees an allocation that wasn't marked during the collection
+static void sweep_chunk(MemoryManager *manager, MarkingInfo *chunk) {
+  uint32_t payload = chunk->size - sizeof(MarkingInfo);
+
+#ifdef DEBUG_MEMORY
+  // poison the payload so that use-after-free shows up as garbage
+  memset((char *)chunk + sizeof(MarkingInfo), 0xDB, payload);
+#endif
+
+  chunk->allocated = 0;
+  manager->freed_bytes += payload;
+}
+
+// a marked chunk survives the collection, and is old from now on
+static void promote_chunk(MemoryManager *manager, MarkingInfo *chunk) {
+  chunk->pinned = 0;
+  if (chunk->young) {
+    chunk->young = 0;
+    manager->promoted_bytes += chunk->size - sizeof(MarkingInfo);
+  }
+}
+
+// walks the chunks from start up to end in address order, freeing everything
+// that wasn't marked and merging each run of adjacent free chunks into one,
+// which goes back on the free lists. returns how many chunks are still live,
+// sets swept to how many were freed, live_bytes to the payload still in use,
+// and free_bytes to how much space is free. the marks are cleared after
+static uint32_t sweep_chunks(MemoryManager *manager, MarkingInfo *start,
+                             char *end, uint32_t *swept, uint64_t *live_bytes,
+                             uint64_t *free_bytes) {
+  uint32_t live_chunks = 0;
+  *swept = 0;
+  *live_bytes = 0;
+  *free_bytes = 0;
+  MarkingInfo *run = NULL; // the first chunk in the current run of free chunks
+
+  MarkingInfo *cur = start;
+  while ((char *)cur < end) {
+    MarkingInfo *next = (MarkingInfo *)((char *)cur + cur->size);
+
+    if (cur->allocated && is_marked(cur)) {
+      promote_chunk(manager, cur);
+      ++live_chunks;
+      *live_bytes += cur->size - sizeof(MarkingInfo);
+
+      if (run != NULL) {
+        *free_bytes += run->size;
+        free_list_push(manager, run);
+        run = NULL;
+      }
+    } else {
+      if (cur->allocated) {
+        sweep_chunk(manager, cur);
+        ++*swept;
+      }
+
+      if (run == NULL) {
+        run = cur;
+        run->young = 0;
+      } else {
+        run->size += cur->size;
+      }
+    }
+
+    cur = next;
+  }
+
+  if (run != NULL) {
+    *free_bytes += run->size;
+    free_list_push(manager, run);
+  }
+
+  clear_marks(start, end);
+
+  return live_chunks;
+}
+
+static void sweep_block(MemoryManager *manager, Block *block) {
+  if (block->large) {
+    MarkingInfo *chunk = LARGE_CHUNK(block);
+    uint32_t live_chunks = 0;
+    if (chunk->allocated && is_marked(chunk)) {
+      promote_chunk(manager, chunk);
+      ++live_chunks;
+      manager->swept_live_bytes += chunk->size - sizeof(MarkingInfo);
+    } else if (chunk->allocated) {
+      sweep_chunk(manager, chunk);
+    }
+    clear_mark(chunk);
+
+    // a large block is never reused, so nothing goes on the free lists
+    block->live_chunks = live_chunks;
+    return;
+  }
+
+  uint32_t swept;
+  uint64_t live_bytes;
+  uint64_t free_bytes;
+  block->live_chunks = sweep_chunks(manager, FIRST_CHUNK(block),
+                                    (char *)block + block->mapped_size, &swept,
+                                    &live_bytes, &free_bytes);
+  manager->swept_live_bytes += live_bytes;
+  if (block->live_chunks > 0) {
+    manager->fragmented_bytes += free_bytes;
+  }
+}
+
+// once every block is swept, what survived the last full collection is known,
+// and so is when the next one is due
+static void end_sweep(MemoryManager *manager) {
+  manager->cycles.live_bytes = manager->swept_live_bytes;
+  manager->cycles.reclaimed_bytes = manager->swept_freed_bytes;
+  manager->cycles.next_gc_bytes =
+      NEXT_GC_CHECK(manager->swept_live_bytes, manager->gc_growth_percent);
+}
+
+// sweeps the first block still flagged as unswept. a block left with no live
+// allocations goes back to the OS, other than one regular block that is kept
+// so the next allocation doesn't need to map. returns 0 once there is nothing
+// left to sweep
+static int sweep_next_block(MemoryManager *manager) {
+  if (manager->unswept_blocks == 0) {
+    return 0;
+  }
+
+  Block **pblock = &manager->first_block;
+  while (!(*pblock)->unswept) {
+    pblock = &(*pblock)->next;
+  }
+  Block *block = *pblock;
+
+  // survivors promoted here were already counted as live by the collection
+  uint64_t promoted_before = manager->promoted_bytes;
+  uint64_t freed_before = manager->freed_bytes;
+  sweep_block(manager, block);
+  block->unswept = 0;
+  manager->promoted_at_last_gc += manager->promoted_bytes - promoted_before;
+  manager->swept_freed_bytes += manager->freed_bytes - freed_before;
+
+  if (block->live_chunks == 0 &&
+      (block->large || manager->kept_empty_block)) {
+    if (!block->large) {
+      // the whole block coalesced into a single chunk, which was the last
+      // thing pushed onto the general free list
+      assert(manager->first_free == FIRST_CHUNK(block));
+      manager->first_free = NEXT_FREE(manager->first_free);
+    }
+
+    *pblock = block->next;
+    manager->heap_size -= block->mapped_size;
+    unmap_block(block);
+  } else if (block->live_chunks == 0) {
+    manager->kept_empty_block = 1;
+  }
+
+  if (--manager->unswept_blocks == 0) {
+    end_sweep(manager);
+  }
+
+  return 1;
+}
+
+static void finish_sweep(MemoryManager *manager) {
+  while (sweep_next_block(manager)) {
+  }
+}
+
+// flags every block as unswept, starting over with empty free lists, once a
+// full collection is done marking
+static void start_sweep(MemoryManager *manager) {
+  clear_free_lists(manager);
+  manager->fragmented_bytes = 0;
+  manager->kept_empty_block = 0;
+  manager->swept_live_bytes = 0;
+  manager->swept_freed_bytes = 0;
+
+  manager->unswept_blocks = 0;
+  for (Block *block = manager->first_block; block != NULL;
+       block = block->next) {
+    block->unswept = 1;
+    ++manager->unswept_blocks;
+  }
+}
+
+// gives back large blocks whose only allocation died in a minor collection
+static void unmap_empty_large(MemoryManager *manager) {
+  Block **pblock = &manager->first_block;
+  while (*pblock != NULL) {
+    Block *block = *pblock;
+
+    if (block->large && block->live_chunks == 0 && !block->unswept) {
+      *pblock = block->next;
+      manager->heap_size -= block->mapped_size;
+      unmap_block(block);
+      continue;
+    }
+
+    pblock = &block->next;
+  }
+}
+
+// stops allocating out of the current hole, so that the heap can be walked
+// chunk by chunk. whatever is left of the hole goes back on the free lists
+static void retire_hole(MemoryManager *manager) {
+  if (manager->hole_start == NULL) {
+    return;
+  }
+
+  if (manager->hole_top > manager->hole_start) {
+    YoungRange range = {.start = (MarkingInfo *)manager->hole_start,
+                        .end = manager->hole_top};
+    if (list_push(&manager->young_ranges, sizeof(YoungRange), &range) < 0) {
+      manager->young_overflowed = 1;
+    }
+  }
+
+  if (manager->hole_limit > manager->hole_top) {
+    MarkingInfo *rest = (MarkingInfo *)manager->hole_top;
+    rest->allocated = 0;
+    rest->young = 0;
+    rest->pinned = 0;
+    rest->grey = 0;
+    rest->size = manager->hole_limit - manager->hole_top;
+    free_list_push(manager, rest);
+  }
+
+  manager->hole_start = NULL;
+  manager->hole_top = NULL;
+  manager->hole_limit = NULL;
+}
+
+static void forget_young(MemoryManager *manager) {
+  list_popn(&manager->young_ranges, sizeof(YoungRange),
+            manager->young_ranges.size);
+  list_popn(&manager->young_large, sizeof(MarkingInfo *),
+            manager->young_large.size);
+  manager->young_overflowed = 0;
+  manager->nursery_allocated = 0;
+}
+
+// only the young chunks get swept, everything old is assumed to be live
+static void sweep_young(MemoryManager *manager) {
+  for (uint32_t ind = 0; ind < manager->young_ranges.size; ++ind) {
+    YoungRange *range = (YoungRange *)manager->young_ranges.items + ind;
+
+    uint32_t swept;
+    uint64_t live_bytes;
+    uint64_t free_bytes;
+    sweep_chunks(manager, range->start, range->end, &swept, &live_bytes,
+                 &free_bytes);
+    BLOCK_OF(range->start)->live_chunks -= swept;
+  }
+
+  int large_died = 0;
+  for (uint32_t ind = 0; ind < manager->young_large.size; ++ind) {
+    MarkingInfo *chunk = ((MarkingInfo **)manager->young_large.items)[ind];
+    if (!chunk->allocated || !chunk->young) {
+      // explicitly deallocated, or listed twice
+      continue;
+    }
+
+    if (is_marked(chunk)) {
+      promote_chunk(manager, chunk);
+      clear_mark(chunk);
+      continue;
+    }
+
+    Block *block = BLOCK_OF(chunk);
+    sweep_chunk(manager, chunk);
+    chunk->young = 0;
+    --block->live_chunks;
+
+    if (block->large) {
+      large_died = 1;
+    } else {
+      free_list_push(manager, chunk);
+    }
+  }
+
+  if (large_died) {
+    unmap_empty_large(manager);
+  }
+}
+
+static uint64_t now_ns() {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+static void record_pause(MemoryManager *manager, uint64_t start_ns) {
+  uint64_t pause_ns = now_ns() - start_ns;
+
+  ++manager->pauses.count;
+  manager->pauses.total_ns += pause_ns;
+  if (pause_ns > manager->pauses.max_ns) {
+    manager->pauses.max_ns = pause_ns;
+  }
+
+  uint32_t bucket = 0;
+  for (uint64_t limit_ns = 10000;
+       bucket < GC_PAUSE_BUCKETS - 1 && pause_ns >= limit_ns; limit_ns *= 10) {
+    ++bucket;
+  }
+  ++manager->pauses.histogram[bucket];
+}
+
+// the mark stack of the marking worker running on this thread, NULL on the
+// collecting thread, which uses the manager's
+static _Thread_local List *worker_grey = NULL;
+
+// the index a tracer is kept under in chunk headers, which it is given the
+// first time it is seen
+static uint8_t tracer_index(MemoryManager *manager, Tracer tracer) {
+  uint32_t count = __atomic_load_n(&manager->tracer_count, __ATOMIC_ACQUIRE);
+  for (uint32_t ind = 0; ind < count; ++ind) {
+    if (manager->tracers[ind] == tracer) {
+      return ind;
+    }
+  }
+
+  // another marking thread could be adding one at the same time
+  pthread_mutex_lock(&manager->mark_lock);
+  uint32_t ind = count;
+  while (ind < manager->tracer_count && manager->tracers[ind] != tracer) {
+    ++ind;
+  }
+
+  if (ind == manager->tracer_count) {
+    if (ind == TRACER_LIMIT) {
+      fprintf(stderr, "[memory]: More than %d tracers\n", TRACER_LIMIT);
+      abort();
+    }
+
+    manager->tracers[ind] = tracer;
+    __atomic_store_n(&manager->tracer_count, ind + 1, __ATOMIC_RELEASE);
+  }
+  pthread_mutex_unlock(&manager->mark_lock);
+
+  return ind;
+}
+
+static void shade(MemoryManager *manager, void *ptr, Tracer tracer) {
+  MarkingInfo *header = (MarkingInfo *)ptr - 1;
+
+  if (manager->minor_gc && !header->young) {
+    // old objects are all assumed live in a minor collection, and anything
+    // young that they point to has been remembered
+    return;
+  }
+
+  if (is_marked(header) || !set_mark(manager, header) || tracer == NULL) {
+    // nothing to trace, or some other thread has it
+    return;
+  }
+
+  header->grey = 1;
+  header->tracer = tracer_index(manager, tracer);
+
+  List *grey = worker_grey != NULL ? worker_grey : &manager->grey;
+  if (grey->size >= MARK_STACK_LIMIT ||
+      list_push(grey, sizeof(void *), &ptr) < 0) {
+    __atomic_store_n(&manager->grey_overflowed, 1, __ATOMIC_RELAXED);
+  }
+}
+
+// refills the mark stack after it overflowed, with grey chunks found by
+// walking every block. stops early if the stack overflows again
+static void rescan_grey(MemoryManager *manager) {
+  manager->grey_overflowed = 0;
+
+  for (Block *block = manager->first_block; block != NULL;
+       block = block->next) {
+    MarkingInfo *cur = block->large ? LARGE_CHUNK(block) : FIRST_CHUNK(block);
+    char *end = block->large ? (char *)cur + cur->size
+                             : (char *)block + block->mapped_size;
+
+    while ((char *)cur < end) {
+      if ((char *)cur == manager->hole_top &&
+          manager->hole_top < manager->hole_limit) {
+        // the rest of the hole hasn't been split into chunks yet
+        cur = (MarkingInfo *)manager->hole_limit;
+        continue;
+      }
+
+      if (cur->allocated && cur->grey) {
+        void *ptr = (char *)cur + sizeof(MarkingInfo);
+        if (manager->grey.size >= MARK_STACK_LIMIT ||
+            list_push(&manager->grey, sizeof(void *), &ptr) < 0) {
+          manager->grey_overflowed = 1;
+          return;
+        }
+      }
+
+      cur = (MarkingInfo *)((char *)cur + cur->size);
+    }
+  }
+}
+
+// traces a chunk taken off of a mark stack
+static void blacken(MemoryManager *manager, void *ptr) {
+  MarkingInfo *header = (MarkingInfo *)ptr - 1;
+  if (!header->allocated || !header->grey) {
+    // explicitly deallocated after it was marked, or pushed again by a
+    // rescan after it had already been traced
+    return;
+  }
+
+  header->grey = 0;
+  manager->tracers[header->tracer](manager->rt, ptr);
+}
+
+// traces grey allocations until there are none left, returning 1, or until
+// the deadline passes, returning 0. a deadline of 0 never passes
+static int drain_grey(MemoryManager *manager, uint64_t deadline_ns) {
+  uint32_t until_check = MARK_SLICE_OBJECTS;
+
+  while (1) {
+    void *ptr;
+    if (list_pop(&manager->grey, sizeof(void *), &ptr) < 0) {
+      if (!manager->grey_overflowed) {
+        break;
+      }
+
+      rescan_grey(manager);
+      continue;
+    }
+
+    blacken(manager, ptr);
+
+    if (deadline_ns != 0 && --until_check == 0) {
+      if (now_ns() >= deadline_ns) {
+        return manager->grey.size == 0 && !manager->grey_overflowed;
+      }
+      until_check = MARK_SLICE_OBJECTS;
+    }
+  }
+
+  return 1;
+}
+
+// moves up to count entries from the top of one mark stack to another
+static void move_grey(MemoryManager *manager, List *from, List *to,
+                      uint32_t count) {
+  void *ptr;
+  while (count-- > 0 && list_pop(from, sizeof(void *), &ptr) == 0) {
+    if (list_push(to, sizeof(void *), &ptr) < 0) {
+      // stays grey, and gets rescanned
+      __atomic_store_n(&manager->grey_overflowed, 1, __ATOMIC_RELAXED);
+      break;
+    }
+  }
+}
+
+// gives a batch of a thread's mark stack to whichever thread is idle
+static void share_grey(MemoryManager *manager, List *grey) {
+  pthread_mutex_lock(&manager->mark_lock);
+  move_grey(manager, grey, &manager->shared_grey, SHARE_BATCH);
+  pthread_cond_signal(&manager->mark_ready);
+  pthread_mutex_unlock(&manager->mark_lock);
+}
+
+// waits for shared work once a thread's own mark stack is empty, and moves a
+// batch of it onto grey. returns 0 once every thread is out of work
+static int take_shared_grey(MemoryManager *manager, List *grey) {
+  pthread_mutex_lock(&manager->mark_lock);
+  __atomic_add_fetch(&manager->idle_markers, 1, __ATOMIC_RELAXED);
+
+  while (manager->shared_grey.size == 0 &&
+         manager->idle_markers < manager->worker_count + 1) {
+    pthread_cond_wait(&manager->mark_ready, &manager->mark_lock);
+  }
+
+  if (manager->shared_grey.size == 0) {
+    // nobody is left holding anything to trace
+    pthread_cond_broadcast(&manager->mark_ready);
+    pthread_mutex_unlock(&manager->mark_lock);
+    return 0;
+  }
+
+  __atomic_sub_fetch(&manager->idle_markers, 1, __ATOMIC_RELAXED);
+  move_grey(manager, &manager->shared_grey, grey, SHARE_BATCH);
+  pthread_mutex_unlock(&manager->mark_lock);
+
+  return 1;
+}
+
+// one thread's part of a parallel drain
+static void drain_grey_shared(MemoryManager *manager, List *grey) {
+  do {
+    void *ptr;
+    while (list_pop(grey, sizeof(void *), &ptr) == 0) {
+      blacken(manager, ptr);
+
+      if (grey->size >= 2 * SHARE_BATCH &&
+          __atomic_load_n(&manager->idle_markers, __ATOMIC_RELAXED) > 0) {
+        share_grey(manager, grey);
+      }
+    }
+  } while (take_shared_grey(manager, grey));
+}
+
+static void *mark_worker_main(void *arg) {
+  MarkWorker *worker = arg;
+  MemoryManager *manager = worker->manager;
+  worker_grey = &worker->grey;
+
+  uint64_t round = 0;
+  pthread_mutex_lock(&manager->mark_lock);
+  while (1) {
+    while (manager->mark_round == round && !manager->workers_exit) {
+      pthread_cond_wait(&manager->mark_start, &manager->mark_lock);
+    }
+    if (manager->workers_exit) {
+      break;
+    }
+    round = manager->mark_round;
+    pthread_mutex_unlock(&manager->mark_lock);
+
+    drain_grey_shared(manager, &worker->grey);
+
+    pthread_mutex_lock(&manager->mark_lock);
+    ++manager->workers_finished;
+    pthread_cond_signal(&manager->mark_finished);
+  }
+  pthread_mutex_unlock(&manager->mark_lock);
+
+  return NULL;
+}
+
+// starts a thread per worker. if one can't be started, marks with the ones
+// that could
+static void start_workers(MemoryManager *manager, uint32_t count) {
+  if (count == 0) {
+    return;
+  }
+
+  manager->workers = malloc(count * sizeof(MarkWorker));
+  if (manager->workers == NULL) {
+    return;
+  }
+
+  for (uint32_t ind = 0; ind < count; ++ind) {
+    MarkWorker *worker = &manager->workers[ind];
+    worker->manager = manager;
+    list_init(&worker->grey);
+
+    if (pthread_create(&worker->thread, NULL, mark_worker_main, worker) != 0) {
+      break;
+    }
+    ++manager->worker_count;
+  }
+}
+
+static void stop_workers(MemoryManager *manager) {
+  pthread_mutex_lock(&manager->mark_lock);
+  manager->workers_exit = 1;
+  pthread_cond_broadcast(&manager->mark_start);
+  pthread_mutex_unlock(&manager->mark_lock);
+
+  for (uint32_t ind = 0; ind < manager->worker_count; ++ind) {
+    pthread_join(manager->workers[ind].thread, NULL);
+    list_clear(&manager->workers[ind].grey);
+  }
+  free(manager->workers);
+}
+
+// drains the mark stack with no deadline, together with the workers when
+// the heap is big enough to be worth waking them
+static void drain_grey_all(MemoryManager *manager) {
+  if (manager->worker_count > 0 && !manager->compacting &&
+      manager->heap_size >= PARALLEL_MARK_HEAP) {
+    pthread_mutex_lock(&manager->mark_lock);
+    manager->parallel_marking = 1;
+    manager->idle_markers = 0;
+    manager->workers_finished = 0;
+    ++manager->mark_round;
+    pthread_cond_broadcast(&manager->mark_start);
+    pthread_mutex_unlock(&manager->mark_lock);
+
+    drain_grey_shared(manager, &manager->grey);
+
+    pthread_mutex_lock(&manager->mark_lock);
+    while (manager->workers_finished < manager->worker_count) {
+      pthread_cond_wait(&manager->mark_finished, &manager->mark_lock);
+    }
+    manager->parallel_marking = 0;
+    pthread_mutex_unlock(&manager->mark_lock);
+  }
+
+  // rescans whatever overflowed
+  drain_grey(manager, 0);
+}
+
+static int remembered_shade_it(void *arg, void *obj) {
+  MemoryManager *manager = arg;
+  GreyEntry *entry = obj;
+
+  shade(manager, entry->ptr, entry->tracer);
+
+  return 0;
+}
+
+// lets the runtime look at what survived, while the marks still tell
+static void done_marking(MemoryManager *manager) {
+  if (manager->collection_hook != NULL) {
+    manager->collection_hook(manager->rt);
+  }
+}
+
+// after a collection every survivor is old, so there is nothing to remember
+static void forget_remembered(MemoryManager *manager) {
+  list_popn(&manager->remembered, sizeof(GreyEntry),
+            manager->remembered.size);
+}
+
+// hands the heap over to the sweep once a full collection is done marking.
+// the young chunks are all either garbage or survivors now, so the nursery
+// starts over
+static void end_full_gc(MemoryManager *manager) {
+  start_sweep(manager);
+  forget_young(manager);
+  forget_remembered(manager);
+  manager->phase = kGcIdle;
+
+  ++manager->cycles.full_collections;
+  manager->promoted_at_last_gc = manager->promoted_bytes;
+}
+
+static void finish_gc(MemoryManager *manager) {
+  // mark everything reachable from the runtime as used. when marking
+  // incrementally this catches what was stored in the roots since the start
+  manager->runtime_marker(manager->rt);
+  drain_grey_all(manager);
+  done_marking(manager);
+
+  // everything still white (not used) is freed as it is swept
+  retire_hole(manager);
+  end_full_gc(manager);
+}
+
+// does a whole collection in one pause, finishing an incremental collection
+// if one is in progress
+static void run_gc(MemoryManager *manager) {
+#ifdef CHECK_FOR_GARBAGE
+  uint64_t start_ns = now_ns();
+  // the marks left over from the last collection have to be swept away
+  // before marking again
+  finish_sweep(manager);
+  finish_gc(manager);
+  record_pause(manager, start_ns);
+#endif
+}
+
+static Block *next_regular_block(Block *block) {
+  while (block != NULL && block->large) {
+    block = block->next;
+  }
+  return block;
+}
+
+// the regular block that addr points into, or NULL if it isn't in one
+static Block *regular_block_of(MemoryManager *manager, char *addr) {
+  Block *owner = BLOCK_OF(addr);
+
+  for (Block *block = manager->first_block; block != NULL;
+       block = block->next) {
+    if (block == owner) {
+      return block->large ? NULL : block;
+    }
+  }
+
+  return NULL;
+}
+
+// pins the page of each word on the stack, below this call, that points into
+// a regular block. a word might just be a number that looks like a pointer,
+// which only keeps a few more chunks where they are. nothing is kept alive by
+// the stack, whatever C code holds on to still has to be reachable from the
+// roots
+__attribute__((noinline, no_sanitize_address)) static void
+pin_stack_words(MemoryManager *manager) {
+  char **word = (char **)ROUND_UP((uintptr_t)__builtin_frame_address(0),
+                                  sizeof(char *));
+
+  for (; (char *)word < manager->stack_base; ++word) {
+    char *addr = *word;
+    Block *block = regular_block_of(manager, addr);
+    if (block == NULL || addr < (char *)FIRST_CHUNK(block)) {
+      continue;
+    }
+
+    uint32_t page = (addr - (char *)block) / PAGE_SIZE;
+    block->pinned_pages[page / 32] |= (uint32_t)1 << (page % 32);
+  }
+}
+
+__attribute__((noinline)) static void pin_stack(MemoryManager *manager) {
+  // spill the callee saved registers into this frame, so that pointers only
+  // held in registers are on the stack too
+  __builtin_unwind_init();
+  pin_stack_words(manager);
+  // keep the call from being turned into a jump, which would pop the frame
+  __asm__ volatile("" ::: "memory");
+}
+
+static void unpin_pages(MemoryManager *manager) {
+  for (Block *block = manager->first_block; block != NULL;
+       block = block->next) {
+    memset(block->pinned_pages, 0, sizeof(block->pinned_pages));
+  }
+}
+
+static int chunk_pinned(MarkingInfo *chunk) {
+  if (chunk->pinned) {
+    return 1;
+  }
+
+  Block *block = BLOCK_OF(chunk);
+  uint32_t first = ((char *)chunk - (char *)block) / PAGE_SIZE;
+  uint32_t last =
+      ((char *)chunk + chunk->size - 1 - (char *)block) / PAGE_SIZE;
+
+  for (uint32_t page = first; page <= last; ++page) {
+    if (block->pinned_pages[page / 32] & ((uint32_t)1 << (page % 32))) {
+      return 1;
+    }
+  }
 
-#include "runtime/memory_manager.h"
+  return 0;
+}
 
-#define MEGABYTES(n) ((n) << 20)
-#define BLOCK_SIZE MEGABYTES(4)
+// lists the live chunks that can't move, in the order compaction walks the
+// heap. returns -1 if they couldn't all be listed
+static int find_stays(MemoryManager *manager) {
+  for (Block *block = next_regular_block(manager->first_block); block != NULL;
+       block = next_regular_block(block->next)) {
+    char *end = (char *)block + block->mapped_size;
 
-#define INITIAL_GC_CHECK 1024
-#define NEXT_GC_CHECK(cur) (2 * (cur))
+    MarkingInfo *cur = FIRST_CHUNK(block);
+    while ((char *)cur < end) {
+      if (cur->allocated && is_marked(cur) && chunk_pinned(cur) &&
+          list_push(&manager->stays, sizeof(MarkingInfo *), &cur) < 0) {
+        return -1;
+      }
 
-#define CHECK_FOR_GARBAGE
+      cur = (MarkingInfo *)((char *)cur + cur->size);
+    }
+  }
 
-typedef enum {
-  kMarkWhite,
-  kMarkGrey,
-  kMarkBlack,
-} Marking;
+  return 0;
+}
 
-typedef struct marking_info {
-  uint32_t size;
-  Marking mark;
-  int allocated;
-  struct marking_info *next;
-} MarkingInfo;
+static void cursor_set_limit(MemoryManager *manager, CompactCursor *cursor) {
+  cursor->limit = (char *)cursor->block + cursor->block->mapped_size;
 
-typedef struct {
-  char *bytes;
-  MarkingInfo *first_free;
-  MarkingInfo *first_allocated;
-} Block;
+  if (cursor->stay_ind < manager->stays.size) {
+    MarkingInfo *stay =
+        ((MarkingInfo **)manager->stays.items)[cursor->stay_ind];
+    if (BLOCK_OF(stay) == cursor->block) {
+      cursor->limit = (char *)stay;
+    }
+  }
+}
 
-struct manager {
-  Block block;
-  uint32_t next_gc_size;
-  uint32_t allocated_bytes;
-  uint32_t freed_bytes;
-  RuntimeMarker runtime_marker;
-  struct runtime *rt;
-};
+static void cursor_start(MemoryManager *manager, CompactCursor *cursor,
+                         Block *block) {
+  cursor->block = block;
+  if (block != NULL) {
+    cursor->top = (char *)FIRST_CHUNK(block);
+    cursor_set_limit(manager, cursor);
+  }
+}
 
-int initialize_manager(MemoryManager **pmanager, RuntimeMarker runtime_marker,
-                       struct runtime *rt) {
+// leaves whatever is left before the limit empty, and moves past the chunk
+// that stays there or on to the next block. returns 0 once there are no more
+// blocks
+static int cursor_skip(MemoryManager *manager, CompactCursor *cursor) {
+  if (cursor->limit > cursor->top) {
+    Gap gap = {.start = cursor->top, .end = cursor->limit};
+    if (list_push(&manager->gaps, sizeof(Gap), &gap) < 0) {
+      // some chunks may already be planned to move over the gap, so there
+      // is no backing out
+      fprintf(stderr, "[memory]: Out of memory while compacting\n");
+      abort();
+    }
+  }
 
-  char *block_bytes = calloc(1, BLOCK_SIZE);
-  if (block_bytes == NULL) {
-    return -1;
+  if (cursor->limit < (char *)cursor->block + cursor->block->mapped_size) {
+    cursor->top = cursor->limit + ((MarkingInfo *)cursor->limit)->size;
+    ++cursor->stay_ind;
+    cursor_set_limit(manager, cursor);
+    return 1;
   }
 
-  MarkingInfo *first_free = (MarkingInfo *)block_bytes;
-  first_free->allocated = 0;
-  first_free->mark = kMarkWhite;
-  first_free->next = NULL;
-  first_free->size = BLOCK_SIZE;
+  cursor_start(manager, cursor, next_regular_block(cursor->block->next));
+  return cursor->block != NULL;
+}
 
-  MemoryManager *manager = calloc(1, sizeof(MemoryManager));
-  if (manager == NULL) {
-    free(block_bytes);
-    return -1;
+// works out where each live chunk moves to, sliding it as far towards the
+// front of the heap as it fits around the chunks that stay, and lists it in
+// forwards. dead chunks are freed on the way, since whatever moves over them
+// won't leave them intact. a chunk only ever moves to somewhere that has
+// already been walked past, so moving them all in the same order never
+// overwrites one that hasn't moved
+static void plan_moves(MemoryManager *manager) {
+  CompactCursor cursor = {.stay_ind = 0};
+  cursor_start(manager, &cursor, next_regular_block(manager->first_block));
+
+  for (Block *block = manager->first_block; block != NULL;
+       block = block->next) {
+    block->first_forward = manager->forwards.size;
+    block->forward_count = 0;
+    if (block->large) {
+      continue;
+    }
+
+    char *end = (char *)block + block->mapped_size;
+
+    MarkingInfo *cur = FIRST_CHUNK(block);
+    while ((char *)cur < end) {
+      MarkingInfo *next = (MarkingInfo *)((char *)cur + cur->size);
+
+      if (cur->allocated && !is_marked(cur)) {
+        sweep_chunk(manager, cur);
+      } else if (cur->allocated && !chunk_pinned(cur)) {
+        while ((uint64_t)(cursor.limit - cursor.top) < cur->size) {
+          cursor_skip(manager, &cursor);
+        }
+
+        // a sliver too small to be a free chunk goes along with this one
+        uint64_t rest = cursor.limit - cursor.top - cur->size;
+        Forward forward = {
+            .from = cur,
+            .to = (MarkingInfo *)cursor.top,
+            .moved_size = cur->size + (rest < MIN_CHUNK_SIZE ? rest : 0)};
+        cursor.top += forward.moved_size;
+
+        assert((BLOCK_OF(forward.to) != block || forward.to <= cur) &&
+               "Compaction moving a chunk forwards!");
+
+        if (forward.to != cur &&
+            list_push(&manager->forwards, sizeof(Forward), &forward) < 0) {
+          // the chunks before it are already planned to move
+          fprintf(stderr, "[memory]: Out of memory while compacting\n");
+          abort();
+        }
+      }
+
+      cur = next;
+    }
+
+    block->forward_count = manager->forwards.size - block->first_forward;
   }
 
-  manager->block.bytes = block_bytes;
-  manager->block.first_free = first_free;
-  manager->block.first_allocated = NULL;
-  manager->next_gc_size = INITIAL_GC_CHECK;
-  manager->allocated_bytes = 0;
-  manager->freed_bytes = 0;
-  manager->runtime_marker = runtime_marker;
-  manager->rt = rt;
+  // everything past the last chunk that was placed is empty
+  while (cursor.block != NULL && cursor_skip(manager, &cursor)) {
+  }
+}
 
-  *pmanager = manager;
+// where compaction moves a chunk to, or NULL if it stays put. the forwards
+// for a block are in address order
+static Forward *find_forward(MemoryManager *manager, MarkingInfo *chunk) {
+  Block *block = BLOCK_OF(chunk);
+  Forward *forwards = (Forward *)manager->forwards.items + block->first_forward;
+
+  uint32_t low = 0;
+  uint32_t high = block->forward_count;
+  while (low < high) {
+    uint32_t mid = low + (high - low) / 2;
+    if (forwards[mid].from < chunk) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+
+  return low < block->forward_count && forwards[low].from == chunk
+             ? &forwards[low]
+             : NULL;
+}
+
+static int update_slot_it(void *arg, void *obj) {
+  MemoryManager *manager = arg;
+  SlotEntry *entry = obj;
+
+  Forward *forward = find_forward(manager, (MarkingInfo *)entry->target - 1);
+  if (forward != NULL) {
+    *entry->slot = (char *)forward->to + sizeof(MarkingInfo);
+  }
 
   return 0;
 }
 
-static void internal_deallocate(MemoryManager *manager, MarkingInfo *freed);
+// moves the chunks to where plan_moves put them, taking their marks along,
+// and then fills in the free chunks around them
+static void move_chunks(MemoryManager *manager) {
+  for (uint32_t ind = 0; ind < manager->forwards.size; ++ind) {
+    Forward *forward = (Forward *)manager->forwards.items + ind;
+    uint32_t size = forward->from->size;
+
+    clear_mark(forward->from);
+    memmove(forward->to, forward->from, size);
+    forward->to->size = forward->moved_size;
+    set_mark(manager, forward->to);
+    manager->allocated_bytes += forward->moved_size - size;
+  }
+
+  for (uint32_t ind = 0; ind < manager->gaps.size; ++ind) {
+    Gap *gap = (Gap *)manager->gaps.items + ind;
+    MarkingInfo *chunk = (MarkingInfo *)gap->start;
+
+#ifdef DEBUG_MEMORY
+    // poison it, so that anything still pointing at a chunk that moved
+    // shows up as garbage
+    memset(gap->start, 0xDB, gap->end - gap->start);
+#endif
+
+    chunk->allocated = 0;
+    chunk->young = 0;
+    chunk->pinned = 0;
+    chunk->grey = 0;
+    chunk->size = gap->end - gap->start;
+  }
+}
 
-static void run_gc(MemoryManager *manager, MarkingInfo *trigger) {
+static void run_compacting_gc(MemoryManager *manager) {
 #ifdef CHECK_FOR_GARBAGE
-  MarkingInfo *cur;
+  if (manager->phase == kGcMarking) {
+    // none of the slots marked so far were logged
+    run_gc(manager);
+  }
+
+  uint64_t start_ns = now_ns();
+
+  finish_sweep(manager);
+  manager->compacting = 1;
+  pin_stack(manager);
+  manager->runtime_marker(manager->rt);
+  drain_grey(manager, 0);
+  manager->compacting = 0;
+  done_marking(manager);
+
+  retire_hole(manager);
+
+  // if the chunks that stay can't be listed, this is just a full collection
+  if (find_stays(manager) == 0) {
+    plan_moves(manager);
+    list_foreach(&manager->slots, sizeof(SlotEntry), update_slot_it, manager);
+    move_chunks(manager);
+    ++manager->cycles.compactions;
+  }
+
+  unpin_pages(manager);
+  list_clear(&manager->slots);
+  list_clear(&manager->stays);
+  list_clear(&manager->gaps);
+  list_clear(&manager->forwards);
+
+  // the point is to give blocks back, so this sweeps right away
+  end_full_gc(manager);
+  finish_sweep(manager);
+  manager->compacted_at = manager->cycles.full_collections;
+
+  record_pause(manager, start_ns);
+#endif
+}
+
+static void start_incremental_gc(MemoryManager *manager) {
+  uint64_t start_ns = now_ns();
 
-  // mark all allocated as gray
-  cur = manager->block.first_allocated;
-  while (cur != NULL) {
-    cur->mark = kMarkGrey;
-    cur = cur->next;
+  finish_sweep(manager);
+  manager->runtime_marker(manager->rt);
+  manager->phase = kGcMarking;
+  manager->allocated_at_last_slice = manager->allocated_bytes;
+
+  record_pause(manager, start_ns);
+}
+
+static void mark_slice(MemoryManager *manager) {
+  uint64_t start_ns = now_ns();
+
+  manager->allocated_at_last_slice = manager->allocated_bytes;
+  if (drain_grey(manager, start_ns + manager->mark_slice_ns)) {
+    // nothing grey is left, so this can be the final pause
+    finish_gc(manager);
   }
 
-  // mark the trigger as used, and then mark everything reachable from the
-  // runtime as used
-  if (trigger != NULL) {
-    trigger->mark = kMarkBlack;
+  record_pause(manager, start_ns);
+}
+
+static void run_minor_gc(MemoryManager *manager) {
+#ifdef CHECK_FOR_GARBAGE
+  retire_hole(manager);
+
+  if (manager->young_overflowed) {
+    // some young chunks can't be found, only a full collection gets them all
+    run_gc(manager);
+    return;
   }
+
+  uint64_t start_ns = now_ns();
+  uint64_t freed_before = manager->freed_bytes;
+
+  // mark from the roots and remembered allocations, stopping at anything old
+  manager->minor_gc = 1;
   manager->runtime_marker(manager->rt);
+  list_foreach(&manager->remembered, sizeof(GreyEntry), remembered_shade_it,
+               manager);
+  drain_grey(manager, 0);
+  manager->minor_gc = 0;
+  done_marking(manager);
 
-  // remove all the allocations that are still marked grey (not used)
-  cur = manager->block.first_allocated;
-  while (cur != NULL) {
-    if (cur->mark == kMarkGrey) {
-      internal_deallocate(manager, cur);
-    }
-    cur = cur->next;
+  sweep_young(manager);
+  forget_young(manager);
+  forget_remembered(manager);
+
+  ++manager->cycles.minor_collections;
+  manager->cycles.minor_reclaimed_bytes = manager->freed_bytes - freed_before;
+
+  record_pause(manager, start_ns);
+#endif
+}
+
+static int minor_gc_due(MemoryManager *manager) {
+  if (manager->nursery_size == 0 || manager->phase != kGcIdle) {
+    // the nursery keeps growing until an incremental collection is done
+    return 0;
+  }
+
+#ifdef DEBUG_MEMORY
+  return manager->nursery_allocated > 0 || manager->young_large.size > 0;
+#else
+  return manager->nursery_allocated >= manager->nursery_size;
+#endif
+}
+
+static int gc_due(MemoryManager *manager) {
+  if (manager->phase != kGcIdle) {
+    return 0;
   }
 
-  // recalculate the time to do a garbage collection
-  manager->next_gc_size = NEXT_GC_CHECK(manager->next_gc_size);
+#ifdef DEBUG_MEMORY
+  if (manager->nursery_size == 0) {
+    return 1;
+  }
 #endif
+
+  if (manager->unswept_blocks > 0) {
+    // the heap can't grow until the sweep is done, and the live bytes aren't
+    // known until then either
+    return 0;
+  }
+
+  // everything promoted since the last full collection is assumed to still
+  // be live, since only a full collection can tell
+  uint64_t old_size = manager->cycles.live_bytes + manager->promoted_bytes -
+                      manager->promoted_at_last_gc;
+  return old_size >= manager->cycles.next_gc_bytes;
 }
 
 int cleanup_manager(MemoryManager **pmanager, uint32_t *final_allocated) {
   MemoryManager *manager = *pmanager;
 
-  run_gc(manager, NULL);
+  if (manager->phase == kGcMarking) {
+    // whatever was marked before the roots went away is still black
+    run_gc(manager);
+  }
+  run_gc(manager);
+  finish_sweep(manager);
   if (final_allocated != NULL) {
     *final_allocated = inspect_allocation(manager);
   }
 
-  char *block_bytes = manager->block.bytes;
+  Block *block = manager->first_block;
+  while (block != NULL) {
+    Block *next = block->next;
+    unmap_block(block);
+    block = next;
+  }
+
+  stop_workers(manager);
+  pthread_mutex_destroy(&manager->mark_lock);
+  pthread_cond_destroy(&manager->mark_start);
+  pthread_cond_destroy(&manager->mark_ready);
+  pthread_cond_destroy(&manager->mark_finished);
 
+  list_clear(&manager->young_ranges);
+  list_clear(&manager->young_large);
+  list_clear(&manager->remembered);
+  list_clear(&manager->grey);
+  list_clear(&manager->slots);
+  list_clear(&manager->stays);
+  list_clear(&manager->gaps);
+  list_clear(&manager->forwards);
+  list_clear(&manager->shared_grey);
   free(manager);
-  free(block_bytes);
 
   return 0;
 }
 
-void *allocate(MemoryManager *manager, uint32_t size) {
-  MarkingInfo **ptr = &manager->block.first_free;
+// takes the first chunk off of the general free list that can hold at least
+// chunk_size bytes, without splitting it
+static MarkingInfo *take_general(MemoryManager *manager, uint32_t chunk_size) {
+  MarkingInfo **ptr = &manager->first_free;
+
+  while ((*ptr != NULL) && ((*ptr)->size < chunk_size)) {
+    ptr = &NEXT_FREE(*ptr);
+  }
+
+  MarkingInfo *result = *ptr;
+  if (result != NULL) {
+    *ptr = NEXT_FREE(result);
+  }
+
+  return result;
+}
+
+static MarkingInfo *allocate_general(MemoryManager *manager,
+                                     uint32_t chunk_size) {
+  MarkingInfo **ptr = &manager->first_free;
 
 look_for_match:
-  while ((*ptr != NULL) && ((*ptr)->size < sizeof(MarkingInfo) + size)) {
-    ptr = &(*ptr)->next;
+  while ((*ptr != NULL) && ((*ptr)->size < chunk_size)) {
+    ptr = &NEXT_FREE(*ptr);
   }
 
   if (*ptr == NULL) {
@@ -138,87 +1724,458 @@ look_for_match:
 
   MarkingInfo *result = *ptr;
 
-  if (result->size == sizeof(MarkingInfo) + size) {
+  if (result->size == chunk_size) {
     // a perfect match, just remove this from the free list, don't split
-    *ptr = result->next;
+    *ptr = NEXT_FREE(result);
   } else {
     // this block is larger than necessary
-    if (result->size < 2 * sizeof(MarkingInfo) + size) {
+    if (result->size < MIN_CHUNK_SIZE + chunk_size) {
       // we don't have enough extra space to allocate a new header, so keep
       // looking for a match
-      ptr = &(*ptr)->next;
+      ptr = &NEXT_FREE(*ptr);
       goto look_for_match;
     }
 
     // we have enough extra space to split off a new entry in the free list
 
-    MarkingInfo *right_half =
-        (MarkingInfo *)((char *)*ptr + sizeof(MarkingInfo) + size);
+    MarkingInfo *right_half = (MarkingInfo *)((char *)*ptr + chunk_size);
 
     right_half->allocated = 0;
-    right_half->mark = kMarkWhite;
-    right_half->next = (*ptr)->next;
-    right_half->size = (*ptr)->size - (sizeof(MarkingInfo) + size);
+    right_half->young = 0;
+    right_half->pinned = 0;
+    right_half->grey = 0;
+    NEXT_FREE(right_half) = NEXT_FREE(*ptr);
+    right_half->size = (*ptr)->size - chunk_size;
 
     *ptr = right_half;
   }
 
+  return result;
+}
+
+static MarkingInfo *pop_bin(MemoryManager *manager, uint32_t payload) {
+  if (payload > SMALL_SIZE_LIMIT) {
+    return NULL;
+  }
+
+  MarkingInfo **bin = &manager->bins[SIZE_CLASS(payload)];
+  MarkingInfo *result = *bin;
+  if (result != NULL) {
+    *bin = NEXT_FREE(result);
+  }
+
+  return result;
+}
+
+// finds free space for a chunk. a hole for the nursery takes a whole free
+// chunk, preferring the big ones on the general list, while anything else is
+// carved to size
+static MarkingInfo *find_chunk(MemoryManager *manager, uint32_t payload,
+                               uint32_t chunk_size, int hole) {
+  if (hole) {
+    MarkingInfo *result = take_general(manager, chunk_size);
+    return result != NULL ? result : pop_bin(manager, payload);
+  }
+
+  // hot path: pop an exact fit off of the size class bin
+  MarkingInfo *result = pop_bin(manager, payload);
+  if (result != NULL) {
+    return result;
+  }
+
+  return allocate_general(manager, chunk_size);
+}
+
+// like find_chunk, but collects or grows the heap when there is no space
+static MarkingInfo *make_room(MemoryManager *manager, uint32_t payload,
+                              uint32_t chunk_size, int hole) {
+  MarkingInfo *result = find_chunk(manager, payload, chunk_size, hole);
+  int collected = 0;
+
+  while (result == NULL && sweep_next_block(manager)) {
+    result = find_chunk(manager, payload, chunk_size, hole);
+  }
+
+  if (result == NULL && !manager->gc_paused &&
+      manager->phase == kGcIdle && manager->nursery_allocated > 0) {
+    // the garbage in the nursery is cheap to get back
+    run_minor_gc(manager);
+    result = find_chunk(manager, payload, chunk_size, hole);
+  }
+
+  if (result == NULL && !manager->gc_paused && manager->phase == kGcIdle &&
+      manager->promoted_bytes - manager->promoted_at_last_gc >=
+          manager->heap_size / 2) {
+    // out of space, and enough has been promoted since the last collection
+    // that there is probably garbage to reclaim before growing the heap. an
+    // incremental collection in progress grows the heap instead, so that it
+    // can finish in slices
+    run_gc(manager);
+    collected = 1;
+    result = find_chunk(manager, payload, chunk_size, hole);
+  }
+
+  if (result == NULL && grow_heap(manager) != NULL) {
+    result = find_chunk(manager, payload, chunk_size, hole);
+  }
+
+  if (result == NULL && !collected && !manager->gc_paused) {
+    // the heap is as big as it is allowed to get, so collecting is the only
+    // option left
+    run_gc(manager);
+    result = find_chunk(manager, payload, chunk_size, hole);
+  }
+
+  return result;
+}
+
+// maps a large block for the chunk of an allocation of size bytes, collecting
+// first if the heap is as big as it is allowed to get. the sweep has to finish
+// for dead large allocations to be unmapped, so that is done right away
+static MarkingInfo *allocate_large(MemoryManager *manager, uint64_t size,
+                                   uint64_t chunk_size) {
+  assert(chunk_size >= sizeof(MarkingInfo) + size &&
+         chunk_size <= UINT32_MAX && "Large chunk too small for its size!");
+
+  Block *block = map_large(manager, chunk_size);
+
+  if (block == NULL && !manager->gc_paused) {
+    run_gc(manager);
+    finish_sweep(manager);
+    block = map_large(manager, chunk_size);
+  }
+
+  return block != NULL ? LARGE_CHUNK(block) : NULL;
+}
+
+// bump allocates out of the current hole, moving on to a new hole when it
+// runs out. chunk_size may grow, so that no sliver too small for a header is
+// left at the end of the hole
+static MarkingInfo *allocate_young(MemoryManager *manager, uint32_t payload,
+                                   uint64_t *chunk_size) {
+  if (manager->hole_top == NULL ||
+      (uint64_t)(manager->hole_limit - manager->hole_top) < *chunk_size) {
+    retire_hole(manager);
+
+    MarkingInfo *hole = make_room(manager, payload, *chunk_size, 1);
+    if (hole == NULL) {
+      return NULL;
+    }
+
+    manager->hole_start = (char *)hole;
+    manager->hole_top = (char *)hole;
+    manager->hole_limit = (char *)hole + hole->size;
+  }
+
+  MarkingInfo *result = (MarkingInfo *)manager->hole_top;
+
+  uint64_t rest = manager->hole_limit - manager->hole_top - *chunk_size;
+  if (rest < MIN_CHUNK_SIZE) {
+    *chunk_size += rest;
+  }
+
+  manager->hole_top += *chunk_size;
+  manager->nursery_allocated += *chunk_size;
+
+  return result;
+}
+
+void *allocate(MemoryManager *manager, uint32_t size) {
+  // checked before anything else, so that none of the sizes below can wrap
+  // around and pick a chunk smaller than what was asked for
+  if (size > MAX_ALLOCATION_SIZE) {
+    return NULL;
+  }
+
+  uint64_t payload = ALIGN_UP((uint64_t)(size == 0 ? 1 : size));
+  uint64_t chunk_size = sizeof(MarkingInfo) + payload;
+
+  // collect before allocating, so that the new chunk is always young when it
+  // is handed out, and the caller can fill it in without a write barrier
+  if (!manager->gc_paused && minor_gc_due(manager)) {
+    run_minor_gc(manager);
+  }
+  if (!manager->gc_paused && gc_due(manager)) {
+    if (manager->mark_slice_ns != 0) {
+      start_incremental_gc(manager);
+    } else {
+      run_gc(manager);
+    }
+  } else if (!manager->gc_paused && manager->phase == kGcMarking &&
+             manager->allocated_bytes - manager->allocated_at_last_slice >=
+                 MARK_SLICE_BYTES) {
+    mark_slice(manager);
+  }
+
+  int young = manager->nursery_size != 0;
+
+  MarkingInfo *result;
+  if (young && payload <= NURSERY_SIZE_LIMIT && payload <= LARGE_OBJECT_SIZE) {
+    result = allocate_young(manager, payload, &chunk_size);
+  } else {
+    result = payload > LARGE_OBJECT_SIZE
+                 ? allocate_large(manager, size, chunk_size)
+                 : make_room(manager, payload, chunk_size, 0);
+
+    if (result != NULL && young &&
+        list_push(&manager->young_large, sizeof(MarkingInfo *), &result) < 0) {
+      manager->young_overflowed = 1;
+    }
+  }
+
+  if (result == NULL) {
+    return NULL;
+  }
+
   result->allocated = 1;
-  result->mark = kMarkWhite;
-  result->next = manager->block.first_allocated;
-  result->size = sizeof(MarkingInfo) + size;
+  result->young = young;
+  result->pinned = 0;
+  result->grey = 0;
+  result->size = chunk_size;
 
-  manager->block.first_allocated = result;
-  manager->allocated_bytes += size;
+#ifdef DEBUG_MEMORY
+  assert(!is_marked(result) && "Allocating a marked chunk!");
+#endif
 
-  if (manager->allocated_bytes >= manager->next_gc_size) {
-    run_gc(manager, result);
+  ++BLOCK_OF(result)->live_chunks;
+  manager->allocated_bytes += chunk_size - sizeof(MarkingInfo);
+  if (!young) {
+    manager->promoted_bytes += chunk_size - sizeof(MarkingInfo);
   }
 
   return (char *)result + sizeof(MarkingInfo);
 }
 
-static void internal_deallocate(MemoryManager *manager, MarkingInfo *freed) {
-  assert(freed->allocated && "Double free!");
+static void free_list_push(MemoryManager *manager, MarkingInfo *chunk) {
+  uint32_t payload = chunk->size - sizeof(MarkingInfo);
 
-  MarkingInfo **allocated = &manager->block.first_allocated;
-  while ((*allocated != NULL) && (*allocated != freed)) {
-    allocated = &(*allocated)->next;
+  MarkingInfo **free_list = &manager->first_free;
+  if (payload <= SMALL_SIZE_LIMIT) {
+    free_list = &manager->bins[SIZE_CLASS(payload)];
   }
 
-  if (*allocated == NULL) {
-    assert(0 && "Could not find allocation!");
-  }
+  NEXT_FREE(chunk) = *free_list;
+  *free_list = chunk;
+}
 
-  // remove the allocation from the allocated linked list and add it to the
-  // freed list
+static void release_chunk(MemoryManager *manager, MarkingInfo *freed) {
+  uint32_t payload = freed->size - sizeof(MarkingInfo);
+  Block *block = BLOCK_OF(freed);
 
-  *allocated = (*allocated)->next;
+#ifdef DEBUG_MEMORY
+  // poison the payload so that use-after-free shows up as garbage
+  memset((char *)freed + sizeof(MarkingInfo), 0xDB, payload);
+#endif
 
-  freed->next = manager->block.first_free;
   freed->allocated = 0;
-  freed->mark = kMarkWhite;
 
-  manager->block.first_free = freed;
-  manager->freed_bytes += freed->size - sizeof(MarkingInfo);
+  // a large block is never reused, it just waits to be unmapped. a young
+  // chunk is still in the nursery's records, while marking the chunk may
+  // still be on the worklist, and an unswept block is going to be coalesced,
+  // so those are left for the next sweep to pick up rather than being handed
+  // out again before then
+  if (!block->large && !freed->young && !block->unswept &&
+      manager->phase == kGcIdle) {
+    free_list_push(manager, freed);
+  }
+
+  --block->live_chunks;
+  manager->freed_bytes += payload;
+}
+
+static void internal_deallocate(MemoryManager *manager, MarkingInfo *freed) {
+  assert(freed->allocated && "Double free!");
+
+  // the chunk goes straight back on a free list, and gets merged with its
+  // neighbours by the next sweep
+  release_chunk(manager, freed);
 }
 
 void deallocate(MemoryManager *manager, void *ptr, uint32_t size) {
   MarkingInfo *freed = (MarkingInfo *)ptr - 1;
+  uint64_t chunk_size =
+      ALIGN_UP((uint64_t)(size == 0 ? 1 : size)) + sizeof(MarkingInfo);
 
-  assert(freed->size == size + sizeof(MarkingInfo) &&
+  // the nursery and compaction can hand out a little more than was asked for,
+  // each tacking on a sliver too small to be a chunk
+  assert(freed->size >= chunk_size &&
+         freed->size < chunk_size + 2 * MIN_CHUNK_SIZE &&
          "Not freeing the same size as allocated!");
 
   internal_deallocate(manager, freed);
 }
 
-void mark_used(MemoryManager *manager, void *ptr) {
+void collect_garbage(MemoryManager *manager) {
+  if (!manager->gc_paused) {
+    run_gc(manager);
+    finish_sweep(manager);
+  }
+}
+
+void compact_garbage(MemoryManager *manager) {
+  if (manager->gc_paused) {
+    return;
+  }
+
+  if (manager->stack_base == NULL) {
+    run_gc(manager);
+    return;
+  }
+
+  run_compacting_gc(manager);
+}
+
+static int compaction_due(MemoryManager *manager) {
+  if (!manager->compact) {
+    return 0;
+  }
+
+#ifdef DEBUG_MEMORY
+  // move everything that can be moved as often as possible, so that stale
+  // pointers show up quickly
+  return 1;
+#else
+  // only compact once there has been a full collection since the last one,
+  // and it has been swept, so that fragmented_bytes is up to date
+  return manager->cycles.full_collections > manager->compacted_at &&
+         manager->unswept_blocks == 0 &&
+         manager->fragmented_bytes >=
+             MAX(manager->cycles.live_bytes, MIN_GC_GROWTH);
+#endif
+}
+
+void compact_if_fragmented(MemoryManager *manager) {
+  if (compaction_due(manager)) {
+    compact_garbage(manager);
+  }
+}
+
+void pause_gc(MemoryManager *manager) { ++manager->gc_paused; }
+
+void resume_gc(MemoryManager *manager) {
+  assert(manager->gc_paused > 0 && "Resuming GC that was not paused!");
+  --manager->gc_paused;
+}
+
+void mark_used(MemoryManager *manager, void *ptr, Tracer tracer) {
   // TODO: should I check that this pointer corresponds to this manager somehow?
-  MarkingInfo *header = (MarkingInfo *)ptr - 1;
-  header->mark = kMarkBlack;
+  shade(manager, ptr, tracer);
+
+  if (manager->compacting) {
+    // there is no telling where the reference is, so it can't be updated
+    ((MarkingInfo *)ptr - 1)->pinned = 1;
+  }
 }
 
-uint32_t inspect_allocation(MemoryManager *manager) {
+void mark_slot(MemoryManager *manager, void **slot, Tracer tracer) {
+  void *ptr = *slot;
+  shade(manager, ptr, tracer);
+
+  if (manager->compacting) {
+    SlotEntry entry = {.slot = slot, .target = ptr};
+    if (list_push(&manager->slots, sizeof(SlotEntry), &entry) < 0) {
+      // the slot won't be updated, so the allocation can't move
+      ((MarkingInfo *)ptr - 1)->pinned = 1;
+    }
+  }
+}
+
+void write_barrier(MemoryManager *manager, void *container, void *value,
+                   Tracer tracer) {
+  MarkingInfo *container_header = (MarkingInfo *)container - 1;
+  MarkingInfo *value_header = (MarkingInfo *)value - 1;
+
+  if (manager->phase == kGcMarking && is_marked(container_header) &&
+      !container_header->grey) {
+    // the container won't be traced again in this collection
+    shade(manager, value, tracer);
+  }
+
+  // a survivor of the last full collection is still flagged young until its
+  // block is swept, but is already old
+  int container_young =
+      container_header->young && !BLOCK_OF(container_header)->unswept;
+  if (!container_young && value_header->young) {
+    // a minor collection won't look inside of the container
+    GreyEntry entry = {.ptr = value, .tracer = tracer};
+    if (list_push(&manager->remembered, sizeof(GreyEntry), &entry) < 0) {
+      // no way to remember it, so promote everything right away
+      manager->young_overflowed = 1;
+    }
+  }
+}
+
+void set_collection_hook(MemoryManager *manager, CollectionHook hook) {
+  manager->collection_hook = hook;
+}
+
+int inspect_marked(MemoryManager *manager, void *ptr) {
   (void)manager;
-  return manager->allocated_bytes - manager->freed_bytes;
+
+  MarkingInfo *chunk = (MarkingInfo *)((char *)ptr - sizeof(MarkingInfo));
+  return chunk->allocated && is_marked(chunk);
+}
+
+uint32_t inspect_allocation(MemoryManager *manager) {
+  // garbage in a block that hasn't been swept yet hasn't been freed
+  finish_sweep(manager);
+  return (uint32_t)(manager->allocated_bytes - manager->freed_bytes);
+}
+
+uint64_t inspect_heap_size(MemoryManager *manager) {
+  return manager->heap_size;
+}
+
+uint64_t inspect_compactions(MemoryManager *manager) {
+  return manager->cycles.compactions;
+}
+
+static void add_free_chunk(GcStats *stats, uint64_t size) {
+  stats->free_bytes += size;
+  ++stats->free_chunks;
+  if (size > stats->largest_free_chunk) {
+    stats->largest_free_chunk = size;
+  }
+}
+
+GcStats inspect_gc_stats(MemoryManager *manager) {
+  // the free space, and what the last collection left live, are only known
+  // once everything has been swept
+  finish_sweep(manager);
+
+  GcStats stats = {.cycles = manager->cycles,
+                   .pauses = manager->pauses,
+                   .allocated_bytes = manager->allocated_bytes,
+                   .reclaimed_bytes = manager->freed_bytes,
+                   .heap_size = manager->heap_size,
+                   .large_objects = 0,
+                   .large_bytes = 0,
+                   .free_bytes = 0,
+                   .free_chunks = 0,
+                   .largest_free_chunk = 0};
+
+  for (Block *block = manager->first_block; block != NULL;
+       block = block->next) {
+    if (block->large) {
+      ++stats.large_objects;
+      stats.large_bytes += block->mapped_size;
+    }
+  }
+
+  for (MarkingInfo *chunk = manager->first_free; chunk != NULL;
+       chunk = NEXT_FREE(chunk)) {
+    add_free_chunk(&stats, chunk->size);
+  }
+  for (uint32_t bin = 0; bin < SIZE_CLASS_COUNT; ++bin) {
+    for (MarkingInfo *chunk = manager->bins[bin]; chunk != NULL;
+         chunk = NEXT_FREE(chunk)) {
+      add_free_chunk(&stats, chunk->size);
+    }
+  }
+
+  if (manager->hole_top < manager->hole_limit) {
+    add_free_chunk(&stats, manager->hole_limit - manager->hole_top);
+  }
+
+  return stats;
 }
@@ -0,0 +1,880 @@
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "runtime.h"
+#include "runtime/numbers.h"
+#include "runtime/types.h"
+
+// products where both sides are at least this many limbs are split in half
+// and done with three smaller products instead of four
+#define KARATSUBA_THRESHOLD 32
+
+// the largest power of ten that fits in a limb, for reading and printing a
+// limb's worth of digits at a time
+#define DECIMAL_CHUNK 10000000000000000000ull
+#define DECIMAL_CHUNK_DIGITS 19
+
+// an immediate double-float is the double's bits rotated left by one, which
+// puts the sign at the bottom, with the exponent rebased so that the 256
+// exponents around zero fit in 8 bits rather than 11. both zeros rotate to
+// less than two, and are kept as they are
+#define FLOAT_EXPONENT_OFFSET ((uint64_t)(1023 - 127) << 53)
+#define FLOAT_PAYLOAD_BITS 61
+
+typedef unsigned __int128 uint128_t;
+
+// scratch space lives outside of the heap, so running out of it is as fatal
+// as running out of heap
+static void scratch_exhausted(uint64_t size) {
+  fprintf(stderr, "[runtime]: Out of memory allocating %lu bytes of scratch\n",
+          (unsigned long)size);
+  abort();
+}
+
+static uint64_t *allocate_limbs(uint64_t count) {
+  uint64_t *limbs = malloc(count * sizeof(uint64_t));
+  if (limbs == NULL && count != 0) {
+    scratch_exhausted(count * sizeof(uint64_t));
+  }
+  return limbs;
+}
+
+static uint64_t *allocate_zeroed_limbs(uint64_t count) {
+  uint64_t *limbs = calloc(count, sizeof(uint64_t));
+  if (limbs == NULL && count != 0) {
+    scratch_exhausted(count * sizeof(uint64_t));
+  }
+  return limbs;
+}
+
+// the built-ins turn a zero divisor away before it gets this far
+static void division_by_zero() {
+  fprintf(stderr, "[runtime]: Division by zero\n");
+  abort();
+}
+
+// either kind of integer as a sign and magnitude. a fixnum's magnitude lives
+// in small, so an Integer mustn't be copied once it is read
+typedef struct {
+  int negative;
+  uint32_t length;
+  const uint64_t *limbs;
+  uint64_t small;
+} Integer;
+
+static void read_integer(LishpForm form, Integer *out) {
+  if (FIXNUM_P(form)) {
+    int64_t value = AS_FIXNUM(form);
+    out->negative = value < 0;
+    out->small = value < 0 ? -(uint64_t)value : (uint64_t)value;
+    out->limbs = &out->small;
+    out->length = out->small != 0;
+    return;
+  }
+
+  assert(IS_OBJECT_TYPE(form, kBignum) && "Expected an integer!");
+
+  LishpBignum *big = AS_OBJECT(LishpBignum, form);
+  out->negative = big->negative;
+  out->length = big->length;
+  out->limbs = big->limbs;
+}
+
+static uint32_t trim(const uint64_t *limbs, uint32_t length) {
+  while (length > 0 && limbs[length - 1] == 0) {
+    --length;
+  }
+  return length;
+}
+
+// the limbs are copied, so they can be scratch space
+static LishpForm make_integer(Runtime *rt, int negative, const uint64_t *limbs,
+                              uint32_t length) {
+  length = trim(limbs, length);
+
+  if (length == 0) {
+    return FROM_FIXNUM(0);
+  }
+  if (length == 1) {
+    if (!negative && limbs[0] <= (uint64_t)MOST_POSITIVE_FIXNUM) {
+      return FROM_FIXNUM(limbs[0]);
+    }
+    if (negative && limbs[0] <= -(uint64_t)MOST_NEGATIVE_FIXNUM) {
+      return FROM_FIXNUM(-limbs[0]);
+    }
+  }
+
+  LishpBignum *big = _allocate_obj(
+      rt, sizeof(LishpBignum) + length * sizeof(uint64_t), kBignum);
+  big->obj.type = kBignum;
+  big->negative = negative;
+  big->length = length;
+  memcpy(big->limbs, limbs, length * sizeof(uint64_t));
+
+  return FROM_OBJ(big);
+}
+
+LishpForm integer_from_int64(Runtime *rt, int64_t value) {
+  if (MOST_NEGATIVE_FIXNUM <= value && value <= MOST_POSITIVE_FIXNUM) {
+    return FROM_FIXNUM(value);
+  }
+
+  uint64_t magnitude = value < 0 ? -(uint64_t)value : (uint64_t)value;
+  return make_integer(rt, value < 0, &magnitude, 1);
+}
+
+LishpForm integer_from_int128(Runtime *rt, __int128 value) {
+  if (MOST_NEGATIVE_FIXNUM <= value && value <= MOST_POSITIVE_FIXNUM) {
+    return FROM_FIXNUM((int64_t)value);
+  }
+
+  unsigned __int128 magnitude =
+      value < 0 ? -(unsigned __int128)value : (unsigned __int128)value;
+  uint64_t limbs[2] = {(uint64_t)magnitude, (uint64_t)(magnitude >> 64)};
+  return make_integer(rt, value < 0, limbs, 2);
+}
+
+static int compare_magnitudes(const uint64_t *l, uint32_t l_length,
+                              const uint64_t *r, uint32_t r_length) {
+  if (l_length != r_length) {
+    return l_length < r_length ? -1 : 1;
+  }
+
+  for (uint32_t ind = l_length; ind > 0; --ind) {
+    if (l[ind - 1] != r[ind - 1]) {
+      return l[ind - 1] < r[ind - 1] ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+// adds r into the acc_length limbs at acc, which have to be able to hold the
+// sum
+static void add_into(uint64_t *acc, uint32_t acc_length, const uint64_t *r,
+                     uint32_t r_length) {
+  uint64_t carry = 0;
+  uint32_t ind = 0;
+
+  for (; ind < r_length; ++ind) {
+    uint128_t sum = (uint128_t)acc[ind] + r[ind] + carry;
+    acc[ind] = (uint64_t)sum;
+    carry = (uint64_t)(sum >> 64);
+  }
+  for (; carry != 0 && ind < acc_length; ++ind) {
+    carry = ++acc[ind] == 0;
+  }
+
+  assert(carry == 0 && "Sum overflowed its limbs");
+}
+
+// subtracts r from the acc_length limbs at acc, which have to be at least r
+static void subtract_into(uint64_t *acc, uint32_t acc_length, const uint64_t *r,
+                          uint32_t r_length) {
+  uint64_t borrow = 0;
+  uint32_t ind = 0;
+
+  for (; ind < r_length; ++ind) {
+    uint64_t limb = acc[ind];
+    uint64_t difference = limb - r[ind];
+    uint64_t next_borrow = limb < r[ind];
+    next_borrow |= difference < borrow;
+    acc[ind] = difference - borrow;
+    borrow = next_borrow;
+  }
+  for (; borrow != 0 && ind < acc_length; ++ind) {
+    borrow = acc[ind]-- == 0;
+  }
+
+  assert(borrow == 0 && "Difference went negative");
+}
+
+// out has room for l_length + r_length limbs
+static void multiply_schoolbook(const uint64_t *l, uint32_t l_length,
+                                const uint64_t *r, uint32_t r_length,
+                                uint64_t *out) {
+  memset(out, 0, (l_length + r_length) * sizeof(uint64_t));
+
+  for (uint32_t r_ind = 0; r_ind < r_length; ++r_ind) {
+    uint64_t carry = 0;
+    for (uint32_t l_ind = 0; l_ind < l_length; ++l_ind) {
+      uint128_t product =
+          (uint128_t)l[l_ind] * r[r_ind] + out[r_ind + l_ind] + carry;
+      out[r_ind + l_ind] = (uint64_t)product;
+      carry = (uint64_t)(product >> 64);
+    }
+    out[r_ind + l_length] = carry;
+  }
+}
+
+static void multiply_magnitudes(const uint64_t *l, uint32_t l_length,
+                                const uint64_t *r, uint32_t r_length,
+                                uint64_t *out);
+
+// l = l1 B + l0 and r = r1 B + r0, where B is half of l's limbs, so
+// l r = l1 r1 B^2 + ((l0 + l1)(r0 + r1) - l0 r0 - l1 r1) B + l0 r0. r has to
+// be longer than that half, so that r1 isn't empty
+static void multiply_karatsuba(const uint64_t *l, uint32_t l_length,
+                               const uint64_t *r, uint32_t r_length,
+                               uint64_t *out) {
+  uint32_t half = l_length / 2;
+  uint32_t l1_length = l_length - half;
+  uint32_t r1_length = r_length - half;
+  uint32_t out_length = l_length + r_length;
+
+  // l0 r0 and l1 r1 don't overlap, so they go straight into out
+  multiply_magnitudes(l, half, r, half, out);
+  multiply_magnitudes(l + half, l1_length, r + half, r1_length, out + 2 * half);
+
+  // l1 is the longest of the halves, so every sum fits in one more limb
+  uint32_t sum_length = l1_length + 1;
+  uint64_t *scratch = allocate_zeroed_limbs(4 * sum_length);
+  uint64_t *l_sum = scratch;
+  uint64_t *r_sum = scratch + sum_length;
+  uint64_t *middle = scratch + 2 * sum_length;
+
+  memcpy(l_sum, l + half, l1_length * sizeof(uint64_t));
+  add_into(l_sum, sum_length, l, half);
+  memcpy(r_sum, r + half, r1_length * sizeof(uint64_t));
+  add_into(r_sum, sum_length, r, half);
+
+  uint32_t l_sum_length = trim(l_sum, sum_length);
+  uint32_t r_sum_length = trim(r_sum, sum_length);
+  multiply_magnitudes(l_sum, l_sum_length, r_sum, r_sum_length, middle);
+
+  uint32_t middle_length = 2 * sum_length;
+  subtract_into(middle, middle_length, out, 2 * half);
+  subtract_into(middle, middle_length, out + 2 * half, l1_length + r1_length);
+
+  add_into(out + half, out_length - half, middle, trim(middle, middle_length));
+
+  free(scratch);
+}
+
+// out has room for l_length + r_length limbs
+static void multiply_magnitudes(const uint64_t *l, uint32_t l_length,
+                                const uint64_t *r, uint32_t r_length,
+                                uint64_t *out) {
+  if (l_length < r_length) {
+    const uint64_t *swap = l;
+    l = r;
+    r = swap;
+
+    uint32_t swap_length = l_length;
+    l_length = r_length;
+    r_length = swap_length;
+  }
+
+  if (r_length < KARATSUBA_THRESHOLD) {
+    multiply_schoolbook(l, l_length, r, r_length, out);
+    return;
+  }
+
+  if (l_length < 2 * r_length) {
+    multiply_karatsuba(l, l_length, r, r_length, out);
+    return;
+  }
+
+  // too lopsided to split down the middle, so l is multiplied a piece the
+  // size of r at a time, and the pieces are even
+  memset(out, 0, (l_length + r_length) * sizeof(uint64_t));
+  uint64_t *piece = allocate_limbs(2 * r_length);
+
+  for (uint32_t offset = 0; offset < l_length; offset += r_length) {
+    uint32_t piece_length =
+        l_length - offset < r_length ? l_length - offset : r_length;
+
+    multiply_magnitudes(l + offset, piece_length, r, r_length, piece);
+    add_into(out + offset, l_length + r_length - offset, piece,
+             piece_length + r_length);
+  }
+
+  free(piece);
+}
+
+// divides in place when q is n, and returns the remainder
+static uint64_t divide_small(const uint64_t *n, uint32_t length, uint64_t d,
+                             uint64_t *q) {
+  uint64_t remainder = 0;
+
+  for (uint32_t ind = length; ind > 0; --ind) {
+    uint128_t cur = ((uint128_t)remainder << 64) | n[ind - 1];
+    q[ind - 1] = (uint64_t)(cur / d);
+    remainder = (uint64_t)(cur % d);
+  }
+
+  return remainder;
+}
+
+// Knuth's algorithm D, from TAOCP volume 2, 4.3.1. n has to be at least as
+// long as d, which can't have leading zeros. q gets n_length - d_length + 1
+// limbs and r gets d_length
+static void divide_magnitudes(const uint64_t *n, uint32_t n_length,
+                              const uint64_t *d, uint32_t d_length, uint64_t *q,
+                              uint64_t *r) {
+  if (d_length == 1) {
+    r[0] = divide_small(n, n_length, d[0], q);
+    return;
+  }
+
+  // shifting both so the top bit of d is set keeps each guessed quotient limb
+  // within two of the real one
+  int shift = __builtin_clzll(d[d_length - 1]);
+  uint64_t *scratch = allocate_limbs(n_length + 1 + d_length);
+  uint64_t *u = scratch;
+  uint64_t *v = scratch + n_length + 1;
+
+  for (uint32_t ind = d_length - 1; ind > 0; --ind) {
+    v[ind] = shift == 0 ? d[ind]
+                        : (d[ind] << shift) | (d[ind - 1] >> (64 - shift));
+  }
+  v[0] = d[0] << shift;
+
+  u[n_length] = shift == 0 ? 0 : n[n_length - 1] >> (64 - shift);
+  for (uint32_t ind = n_length - 1; ind > 0; --ind) {
+    u[ind] = shift == 0 ? n[ind]
+                        : (n[ind] << shift) | (n[ind - 1] >> (64 - shift));
+  }
+  u[0] = n[0] << shift;
+
+  uint64_t v_top = v[d_length - 1];
+  uint64_t v_next = v[d_length - 2];
+
+  for (uint32_t j = n_length - d_length + 1; j > 0; --j) {
+    uint64_t *window = u + j - 1;
+
+    uint128_t top = ((uint128_t)window[d_length] << 64) | window[d_length - 1];
+    uint128_t q_hat = top / v_top;
+    uint128_t r_hat = top % v_top;
+
+    while ((q_hat >> 64) != 0 ||
+           q_hat * v_next > ((r_hat << 64) | window[d_length - 2])) {
+      --q_hat;
+      r_hat += v_top;
+      if ((r_hat >> 64) != 0) {
+        break;
+      }
+    }
+
+    // window -= q_hat * v
+    uint64_t carry = 0;
+    uint64_t borrow = 0;
+    for (uint32_t ind = 0; ind <= d_length; ++ind) {
+      uint64_t product_limb = carry;
+      if (ind < d_length) {
+        uint128_t product = q_hat * v[ind] + carry;
+        product_limb = (uint64_t)product;
+        carry = (uint64_t)(product >> 64);
+      }
+
+      uint64_t limb = window[ind];
+      uint64_t difference = limb - product_limb;
+      uint64_t next_borrow = limb < product_limb;
+      next_borrow |= difference < borrow;
+      window[ind] = difference - borrow;
+      borrow = next_borrow;
+    }
+
+    // the guess was one too big, which is rare, so add v back
+    if (borrow != 0) {
+      --q_hat;
+      uint64_t add_carry = 0;
+      for (uint32_t ind = 0; ind < d_length; ++ind) {
+        uint128_t sum = (uint128_t)window[ind] + v[ind] + add_carry;
+        window[ind] = (uint64_t)sum;
+        add_carry = (uint64_t)(sum >> 64);
+      }
+      window[d_length] += add_carry;
+    }
+
+    q[j - 1] = (uint64_t)q_hat;
+  }
+
+  for (uint32_t ind = 0; ind < d_length; ++ind) {
+    r[ind] = shift == 0 ? u[ind]
+                        : (u[ind] >> shift) | (u[ind + 1] << (64 - shift));
+  }
+
+  free(scratch);
+}
+
+static LishpForm add_slow(Runtime *rt, LishpForm l_form, LishpForm r_form,
+                          int subtract) {
+  Integer l, r;
+  read_integer(l_form, &l);
+  read_integer(r_form, &r);
+  if (subtract) {
+    r.negative = !r.negative;
+  }
+
+  // the result takes the sign of whichever is bigger
+  Integer *big = &l;
+  Integer *small = &r;
+  if (compare_magnitudes(l.limbs, l.length, r.limbs, r.length) < 0) {
+    big = &r;
+    small = &l;
+  }
+
+  uint64_t *sum = allocate_limbs(big->length + 1);
+  memcpy(sum, big->limbs, big->length * sizeof(uint64_t));
+  sum[big->length] = 0;
+
+  if (big->negative == small->negative) {
+    add_into(sum, big->length + 1, small->limbs, small->length);
+  } else {
+    subtract_into(sum, big->length + 1, small->limbs, small->length);
+  }
+
+  LishpForm result = make_integer(rt, big->negative, sum, big->length + 1);
+  free(sum);
+  return result;
+}
+
+LishpForm integer_add(Runtime *rt, LishpForm l, LishpForm r) {
+  if (FIXNUM_P(l) && FIXNUM_P(r)) {
+    // with the tags off, both are their values shifted up by two, so the sum
+    // overflows exactly when the result isn't a fixnum
+    int64_t sum;
+    if (!__builtin_add_overflow((int64_t)(l.bits - FIXNUM_TAG),
+                                (int64_t)(r.bits - FIXNUM_TAG), &sum)) {
+      return (LishpForm){.bits = (uintptr_t)sum | FIXNUM_TAG};
+    }
+  }
+
+  return add_slow(rt, l, r, 0);
+}
+
+LishpForm integer_subtract(Runtime *rt, LishpForm l, LishpForm r) {
+  if (FIXNUM_P(l) && FIXNUM_P(r)) {
+    int64_t difference;
+    if (!__builtin_sub_overflow((int64_t)(l.bits - FIXNUM_TAG),
+                                (int64_t)(r.bits - FIXNUM_TAG), &difference)) {
+      return (LishpForm){.bits = (uintptr_t)difference | FIXNUM_TAG};
+    }
+  }
+
+  return add_slow(rt, l, r, 1);
+}
+
+LishpForm integer_negate(Runtime *rt, LishpForm f) {
+  return integer_subtract(rt, FROM_FIXNUM(0), f);
+}
+
+LishpForm integer_multiply(Runtime *rt, LishpForm l_form, LishpForm r_form) {
+  if (FIXNUM_P(l_form) && FIXNUM_P(r_form)) {
+    // only one side is shifted up by two, so the product is too
+    int64_t product;
+    if (!__builtin_mul_overflow((int64_t)(l_form.bits - FIXNUM_TAG),
+                                AS_FIXNUM(r_form), &product)) {
+      return (LishpForm){.bits = (uintptr_t)product | FIXNUM_TAG};
+    }
+  }
+
+  Integer l, r;
+  read_integer(l_form, &l);
+  read_integer(r_form, &r);
+
+  uint32_t length = l.length + r.length;
+  if (length == 0) {
+    return FROM_FIXNUM(0);
+  }
+
+  uint64_t *product = allocate_limbs(length);
+  multiply_magnitudes(l.limbs, l.length, r.limbs, r.length, product);
+
+  LishpForm result =
+      make_integer(rt, l.negative != r.negative, product, length);
+  free(product);
+  return result;
+}
+
+static LishpForm divide_slow(Runtime *rt, LishpForm n_form, LishpForm d_form,
+                             int want_remainder) {
+  Integer n, d;
+  read_integer(n_form, &n);
+  read_integer(d_form, &d);
+
+  if (d.length == 0) {
+    division_by_zero();
+  }
+
+  // one spare limb in the quotient, for rounding its magnitude up
+  uint32_t q_length = n.length < d.length ? 1 : n.length - d.length + 2;
+  uint64_t *scratch = allocate_zeroed_limbs(q_length + d.length);
+  uint64_t *q = scratch;
+  uint64_t *r = scratch + q_length;
+
+  if (n.length < d.length) {
+    memcpy(r, n.limbs, n.length * sizeof(uint64_t));
+  } else {
+    divide_magnitudes(n.limbs, n.length, d.limbs, d.length, q, r);
+  }
+
+  // that rounded towards zero, so when the signs differ and it wasn't exact,
+  // the quotient goes down by one and the remainder becomes d - r
+  int round_down = n.negative != d.negative && trim(r, d.length) != 0;
+
+  LishpForm result;
+  if (want_remainder) {
+    if (round_down) {
+      uint64_t *flipped = allocate_limbs(d.length);
+      memcpy(flipped, d.limbs, d.length * sizeof(uint64_t));
+      subtract_into(flipped, d.length, r, d.length);
+      result = make_integer(rt, d.negative, flipped, d.length);
+      free(flipped);
+    } else {
+      result = make_integer(rt, n.negative, r, d.length);
+    }
+  } else {
+    if (round_down) {
+      uint64_t one = 1;
+      add_into(q, q_length, &one, 1);
+    }
+    result = make_integer(rt, n.negative != d.negative, q, q_length);
+  }
+
+  free(scratch);
+  return result;
+}
+
+LishpForm integer_floor(Runtime *rt, LishpForm n, LishpForm d) {
+  if (FIXNUM_P(n) && FIXNUM_P(d) && AS_FIXNUM(d) != 0) {
+    int64_t n_value = AS_FIXNUM(n);
+    int64_t d_value = AS_FIXNUM(d);
+
+    int64_t q = n_value / d_value;
+    int64_t r = n_value % d_value;
+    if (r != 0 && (r < 0) != (d_value < 0)) {
+      --q;
+    }
+
+    // the most negative fixnum divided by -1 is the one quotient that doesn't
+    // fit
+    return integer_from_int64(rt, q);
+  }
+
+  return divide_slow(rt, n, d, 0);
+}
+
+LishpForm integer_mod(Runtime *rt, LishpForm n, LishpForm d) {
+  if (FIXNUM_P(n) && FIXNUM_P(d) && AS_FIXNUM(d) != 0) {
+    int64_t d_value = AS_FIXNUM(d);
+
+    int64_t r = AS_FIXNUM(n) % d_value;
+    if (r != 0 && (r < 0) != (d_value < 0)) {
+      r += d_value;
+    }
+
+    return FROM_FIXNUM(r);
+  }
+
+  return divide_slow(rt, n, d, 1);
+}
+
+LishpForm integer_divide(Runtime *rt, LishpForm n, LishpForm d) {
+  LishpForm remainder = integer_mod(rt, n, d);
+  assert(FIXNUM_P(remainder) && AS_FIXNUM(remainder) == 0 &&
+         "Unimplemented: ratios");
+
+  return integer_floor(rt, n, d);
+}
+
+LishpForm integer_from_double(Runtime *rt, double value) {
+  assert(isfinite(value) && "Expected a finite float!");
+
+  if (-0x1p63 <= value && value < 0x1p63) {
+    return integer_from_int64(rt, (int64_t)value);
+  }
+
+  // anything this big is a whole number of its 53 bits of mantissa shifted
+  // up by at least 11
+  int exponent;
+  double fraction = frexp(fabs(value), &exponent);
+  uint64_t mantissa = (uint64_t)ldexp(fraction, 53);
+  uint32_t shift = exponent - 53;
+
+  uint32_t length = shift / 64 + 2;
+  uint64_t *limbs = allocate_zeroed_limbs(length);
+  limbs[shift / 64] = mantissa << (shift % 64);
+  if (shift % 64 != 0) {
+    limbs[shift / 64 + 1] = mantissa >> (64 - shift % 64);
+  }
+
+  LishpForm result = make_integer(rt, value < 0, limbs, length);
+  free(limbs);
+  return result;
+}
+
+LishpForm make_double(Runtime *rt, double value) {
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(double));
+  uint64_t rotated = (bits << 1) | (bits >> 63);
+
+  if (rotated <= 1) {
+    return (LishpForm){.bits = (rotated << FORM_TAG_BITS) | FLOAT_TAG};
+  }
+
+  // exponents below the range wrap around to the top, so anything out of it
+  // on either side leaves high bits set
+  uint64_t rebased = rotated - FLOAT_EXPONENT_OFFSET;
+  if (rebased > 1 && (rebased >> FLOAT_PAYLOAD_BITS) == 0) {
+    return (LishpForm){.bits = (rebased << FORM_TAG_BITS) | FLOAT_TAG};
+  }
+
+  LishpDoubleFloat *boxed = ALLOCATE_OBJ(LishpDoubleFloat, rt);
+  boxed->obj.type = kDoubleFloat;
+  boxed->value = value;
+  return FROM_OBJ(boxed);
+}
+
+static double immediate_double(LishpForm f) {
+  uint64_t rotated = f.bits >> FORM_TAG_BITS;
+  if (rotated > 1) {
+    rotated += FLOAT_EXPONENT_OFFSET;
+  }
+
+  uint64_t bits = (rotated >> 1) | (rotated << 63);
+  double value;
+  memcpy(&value, &bits, sizeof(double));
+  return value;
+}
+
+static double bignum_double(LishpBignum *big) {
+  double value = 0;
+  for (uint32_t ind = big->length; ind > 0; --ind) {
+    value = value * 0x1p64 + (double)big->limbs[ind - 1];
+  }
+  return big->negative ? -value : value;
+}
+
+double as_double(LishpForm f) {
+  if (IMMEDIATE_FLOAT_P(f)) {
+    return immediate_double(f);
+  }
+  if (FIXNUM_P(f)) {
+    return (double)AS_FIXNUM(f);
+  }
+  if (IS_OBJECT_TYPE(f, kDoubleFloat)) {
+    return AS_OBJECT(LishpDoubleFloat, f)->value;
+  }
+
+  assert(IS_OBJECT_TYPE(f, kBignum) && "Expected a number!");
+  return bignum_double(AS_OBJECT(LishpBignum, f));
+}
+
+static int both_integers(LishpForm l, LishpForm r) {
+  return INTEGER_P(l) && INTEGER_P(r);
+}
+
+LishpForm number_add(Runtime *rt, LishpForm l, LishpForm r) {
+  if (both_integers(l, r)) {
+    return integer_add(rt, l, r);
+  }
+  return make_double(rt, as_double(l) + as_double(r));
+}
+
+LishpForm number_subtract(Runtime *rt, LishpForm l, LishpForm r) {
+  if (both_integers(l, r)) {
+    return integer_subtract(rt, l, r);
+  }
+  return make_double(rt, as_double(l) - as_double(r));
+}
+
+LishpForm number_multiply(Runtime *rt, LishpForm l, LishpForm r) {
+  if (both_integers(l, r)) {
+    return integer_multiply(rt, l, r);
+  }
+  return make_double(rt, as_double(l) * as_double(r));
+}
+
+LishpForm number_divide(Runtime *rt, LishpForm l, LishpForm r) {
+  if (both_integers(l, r)) {
+    return integer_divide(rt, l, r);
+  }
+  return make_double(rt, as_double(l) / as_double(r));
+}
+
+int number_zerop(LishpForm f) {
+  // bignums are never zero, since they shrink back into fixnums
+  if (INTEGER_P(f)) {
+    return FIXNUM_P(f) && AS_FIXNUM(f) == 0;
+  }
+  return as_double(f) == 0;
+}
+
+LishpForm number_negate(Runtime *rt, LishpForm f) {
+  if (INTEGER_P(f)) {
+    return integer_negate(rt, f);
+  }
+  return make_double(rt, -as_double(f));
+}
+
+LishpForm number_floor(Runtime *rt, LishpForm n, LishpForm d) {
+  if (both_integers(n, d)) {
+    return integer_floor(rt, n, d);
+  }
+
+  double d_value = as_double(d);
+  if (d_value == 0) {
+    division_by_zero();
+  }
+
+  return integer_from_double(rt, floor(as_double(n) / d_value));
+}
+
+LishpForm number_mod(Runtime *rt, LishpForm n, LishpForm d) {
+  if (both_integers(n, d)) {
+    return integer_mod(rt, n, d);
+  }
+
+  double d_value = as_double(d);
+  if (d_value == 0) {
+    division_by_zero();
+  }
+
+  double r = fmod(as_double(n), d_value);
+  if (r != 0 && (r < 0) != (d_value < 0)) {
+    r += d_value;
+  }
+  return make_double(rt, r);
+}
+
+LishpForm parse_integer(Runtime *rt, const char *text, uint32_t length) {
+  int negative = 0;
+  if (length > 0 && (text[0] == '+' || text[0] == '-')) {
+    negative = text[0] == '-';
+    ++text;
+    --length;
+  }
+  if (length > 0 && text[length - 1] == '.') {
+    --length;
+  }
+
+  // eighteen digits always fit in a fixnum
+  if (length <= 18) {
+    int64_t value = 0;
+    for (uint32_t ind = 0; ind < length; ++ind) {
+      value = value * 10 + (text[ind] - '0');
+    }
+    return FROM_FIXNUM(negative ? -value : value);
+  }
+
+  uint32_t capacity = length / DECIMAL_CHUNK_DIGITS + 2;
+  uint64_t *limbs = allocate_zeroed_limbs(capacity);
+  uint32_t limb_count = 0;
+
+  // the first chunk takes whatever is left over, so the rest are whole
+  uint32_t chunk_length = length % DECIMAL_CHUNK_DIGITS;
+  if (chunk_length == 0) {
+    chunk_length = DECIMAL_CHUNK_DIGITS;
+  }
+
+  for (uint32_t ind = 0; ind < length; ind += chunk_length,
+                chunk_length = DECIMAL_CHUNK_DIGITS) {
+    uint64_t chunk = 0;
+    uint64_t scale = 1;
+    for (uint32_t digit = 0; digit < chunk_length; ++digit) {
+      chunk = chunk * 10 + (text[ind + digit] - '0');
+      scale *= 10;
+    }
+
+    // limbs = limbs * scale + chunk
+    uint64_t carry = chunk;
+    for (uint32_t limb = 0; limb < limb_count; ++limb) {
+      uint128_t cur = (uint128_t)limbs[limb] * scale + carry;
+      limbs[limb] = (uint64_t)cur;
+      carry = (uint64_t)(cur >> 64);
+    }
+    if (carry != 0) {
+      limbs[limb_count++] = carry;
+    }
+  }
+
+  LishpForm result = make_integer(rt, negative, limbs, limb_count);
+  free(limbs);
+  return result;
+}
+
+LishpForm parse_double(Runtime *rt, const char *text, uint32_t length) {
+  char *copy = malloc(length + 1);
+  if (copy == NULL) {
+    scratch_exhausted(length + 1);
+  }
+  for (uint32_t ind = 0; ind < length; ++ind) {
+    switch (text[ind]) {
+    case 's':
+    case 'S':
+    case 'f':
+    case 'F':
+    case 'd':
+    case 'D':
+    case 'l':
+    case 'L': {
+      // there is only the one float format, so every marker means the same
+      copy[ind] = 'e';
+    } break;
+    default: {
+      copy[ind] = text[ind];
+    } break;
+    }
+  }
+  copy[length] = '\0';
+
+  double value = strtod(copy, NULL);
+  free(copy);
+
+  return make_double(rt, value);
+}
+
+void print_bignum(LishpBignum *big, FILE *out) {
+  uint32_t length = big->length;
+  uint64_t *magnitude = allocate_limbs(length);
+  memcpy(magnitude, big->limbs, length * sizeof(uint64_t));
+
+  // each limb is less than two chunks
+  uint64_t *chunks = allocate_limbs(2 * length);
+  uint32_t chunk_count = 0;
+
+  while (length > 0) {
+    chunks[chunk_count++] =
+        divide_small(magnitude, length, DECIMAL_CHUNK, magnitude);
+    length = trim(magnitude, length);
+  }
+
+  fprintf(out, "%s%lu", big->negative ? "-" : "",
+          (unsigned long)chunks[chunk_count - 1]);
+  for (uint32_t ind = chunk_count - 1; ind > 0; --ind) {
+    fprintf(out, "%019lu", (unsigned long)chunks[ind - 1]);
+  }
+
+  free(chunks);
+  free(magnitude);
+}
+
+void print_double(double value, FILE *out) {
+  if (isnan(value)) {
+    fprintf(out, "NAN");
+    return;
+  }
+  if (isinf(value)) {
+    fprintf(out, value < 0 ? "-INFINITY" : "INFINITY");
+    return;
+  }
+
+  // the fewest digits that read back as the same double
+  char buffer[32];
+  for (int precision = 15; precision <= 17; ++precision) {
+    snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+    if (strtod(buffer, NULL) == value) {
+      break;
+    }
+  }
+
+  // so that it can't be read back as an integer
+  if (strpbrk(buffer, ".e") == NULL) {
+    strcat(buffer, ".0");
+  }
+
+  fprintf(out, "%s", buffer);
+}
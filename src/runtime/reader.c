@@ -2,11 +2,13 @@
 #include <stdlib.h>
 
 #include "runtime/interpreter.h"
+#include "runtime/numbers.h"
 #include "runtime/reader.h"
 #include "util.h"
 
 typedef enum {
-  kTokenNumber,
+  kTokenInteger,
+  kTokenFloat,
   kTokenSymbol,
   kTokenInvalid,
 } TokenType;
@@ -35,7 +37,7 @@ static ReadtableCase char_case(char c) {
 }
 
 static int cased_char(const char c) {
-  return (c >= 'a' && c < 'z') || (c >= 'A' && c <= 'Z');
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
 }
 
 static char to_upper(char c) {
@@ -83,19 +85,85 @@ static void add_character(LishpReadtable *readtable, Token *token, char c) {
 
 static int is_digit(const char c) { return '0' <= c && c <= '9'; }
 
-static int is_potential_number(Token token) {
-  // FIXME; this is a completely broken implementation that is just here for
-  // testing at the moment.
+static int is_sign(const char c) { return c == '+' || c == '-'; }
 
+static int is_exponent_marker(const char c) {
+  switch (to_upper(c)) {
+  case 'E':
+  case 'S':
+  case 'F':
+  case 'D':
+  case 'L':
+    return 1;
+  }
+  return 0;
+}
+
+static uint32_t skip_digits(const char *c, uint32_t *ind, uint32_t end) {
+  uint32_t start = *ind;
+  while (*ind < end && is_digit(c[*ind])) {
+    ++*ind;
+  }
+  return *ind - start;
+}
+
+// FIXME: only decimal integers and floats are recognized, not ratios or
+// anything in another base
+
+// an optional sign, digits and an optional trailing decimal point
+static int is_integer_token(Token token) {
   uint32_t ind = 0;
+  uint32_t end = token.characters.size;
   const char *c = token.characters.items;
-  while (ind < token.characters.size) {
-    if (!is_digit(*(c + ind))) {
+
+  if (ind < end && is_sign(c[ind])) {
+    ++ind;
+  }
+  if (ind < end && c[end - 1] == '.') {
+    --end;
+  }
+
+  return skip_digits(c, &ind, end) > 0 && ind == end;
+}
+
+// an optional sign, then either digits with a fraction and an optional
+// exponent, or digits with an optional decimal point and fraction and an
+// exponent
+static int is_float_token(Token token) {
+  uint32_t ind = 0;
+  uint32_t end = token.characters.size;
+  const char *c = token.characters.items;
+
+  if (ind < end && is_sign(c[ind])) {
+    ++ind;
+  }
+
+  uint32_t whole_digits = skip_digits(c, &ind, end);
+  uint32_t fraction_digits = 0;
+  if (ind < end && c[ind] == '.') {
+    ++ind;
+    fraction_digits = skip_digits(c, &ind, end);
+  }
+
+  int has_exponent = 0;
+  if (ind < end && is_exponent_marker(c[ind])) {
+    ++ind;
+    if (ind < end && is_sign(c[ind])) {
+      ++ind;
+    }
+    if (skip_digits(c, &ind, end) == 0) {
       return 0;
     }
-    ++ind;
+    has_exponent = 1;
   }
-  return 1;
+
+  if (ind != end) {
+    return 0;
+  }
+  if (has_exponent) {
+    return whole_digits + fraction_digits > 0;
+  }
+  return fraction_digits > 0;
 }
 
 static TokenType get_type(Token token, int had_escape) {
@@ -103,9 +171,11 @@ static TokenType get_type(Token token, int had_escape) {
     return kTokenSymbol;
   }
 
-  if (is_potential_number(token)) {
-    // TODO: figure out what the actual thing to do here is.
-    return kTokenNumber;
+  if (is_integer_token(token)) {
+    return kTokenInteger;
+  }
+  if (is_float_token(token)) {
+    return kTokenFloat;
   }
 
   // There should be a way to have an invalid token, but I forget what that is
@@ -120,8 +190,8 @@ int check_macro_char(LishpReadtable *readtable, char c, CharTraits *type) {
     return 1;
   }
 
-  if (map_ref(&readtable->reader_macros, sizeof(char), sizeof(LishpFunction *),
-              &c, NULL) < 0) {
+  if (hash_map_ref(&readtable->reader_macros, sizeof(char),
+                   sizeof(LishpFunction *), &c, NULL) < 0) {
 
     return 0;
   }
@@ -243,8 +313,8 @@ step_1:
     Interpreter *interpreter = reader->interpreter;
 
     LishpFunction *macro_fn = NULL;
-    map_get(&readtable->reader_macros, sizeof(char), sizeof(LishpFunction *),
-            &x, &macro_fn);
+    hash_map_get(&readtable->reader_macros, sizeof(char),
+                 sizeof(LishpFunction *), &x, &macro_fn);
 
     int push_result0 = push_function(interpreter, macro_fn);
     int push_result1 = push_argument(interpreter, FROM_OBJ(stream_obj));
@@ -353,22 +423,24 @@ step_10:
     // qualified symbols either... tbf, I'm not handling really anything
     // correctly yet :P
 
-    // zero-terminate so that the interning and copying and stuff goes correctly
-    add_character(readtable, &cur_token, '\0');
-
+    // looked up straight from the token, which is only copied if the symbol
+    // is new
     Environment *cur_env = get_current_environment(reader->interpreter);
-    Package *cur_package = find_package(rt, cur_env->package);
     LishpSymbol *new_symbol =
-        intern_symbol(rt, cur_package, cur_token.characters.items);
+        intern_chars(rt, cur_env->package, cur_token.characters.items,
+                     cur_token.characters.size);
 
     result = FROM_OBJ(new_symbol);
     goto cleanup;
   }
-  case kTokenNumber: {
-    // TODO: double check, right now just assuming we have integers
-    // TODO: get the number from the token string (but better!)
-    long parsed = strtol(cur_token.characters.items, NULL, 10);
-    result = FROM_FIXNUM(parsed);
+  case kTokenInteger: {
+    result = parse_integer(rt, cur_token.characters.items,
+                           cur_token.characters.size);
+    goto cleanup;
+  }
+  case kTokenFloat: {
+    result = parse_double(rt, cur_token.characters.items,
+                          cur_token.characters.size);
     goto cleanup;
   }
   default:
@@ -1,22 +1,17 @@
 #include <assert.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "common.h"
 #include "runtime.h"
+#include "runtime/allocation_profile.h"
 #include "runtime/functions.h"
 #include "runtime/interpreter.h"
 #include "runtime/memory_manager.h"
 #include "runtime/types.h"
 #include "util.h"
 
-static int symbol_cmp(void *l, void *r) {
-  LishpSymbol **l_sym = l;
-  LishpSymbol **r_sym = r;
-
-  return *l_sym < *r_sym ? -1 : *l_sym > *r_sym ? 1 : 0;
-}
-
 static int char_cmp(void *l, void *r) {
   char *lptr = l;
   char *rptr = r;
@@ -24,9 +19,11 @@ static int char_cmp(void *l, void *r) {
   return *lptr - *rptr;
 }
 
+static uint32_t char_hash(void *key) { return hash_word(*(char *)key); }
+
 static int names_equal(void *arg, void *item) {
   const char *name = arg;
-  Package *p = item;
+  Package *p = *(Package **)item;
 
   if (strcmp(name, p->name) == 0) {
     return 1;
@@ -39,36 +36,17 @@ static int initialize_environment(Environment *env, Environment *parent,
                                   Package *p) {
 
   env->parent = parent;
-  env->package = p->name;
+  env->package = p;
 
-  map_init(&env->symbol_values, symbol_cmp);
-  map_init(&env->symbol_functions, symbol_cmp);
+  symbol_values_init(&env->symbol_values);
+  symbol_functions_init(&env->symbol_functions);
 
   return 0;
 }
 
 static void cleanup_environment(Environment *env) {
-  map_clear(&env->symbol_functions);
-  map_clear(&env->symbol_values);
-}
-
-static int empty_name_cmp(void *l, void *r) {
-  const char **l_strp = l;
-  const char **r_strp = r;
-
-  if (*l_strp == NULL) {
-    if (*r_strp == NULL) {
-      return 0;
-    }
-    return -1;
-  }
-  if (*r_strp == NULL) {
-    return 1;
-  }
-
-  int cmp = strcmp(*l_strp, *r_strp);
-
-  return cmp;
+  symbol_functions_clear(&env->symbol_functions);
+  symbol_values_clear(&env->symbol_values);
 }
 
 static int initialize_package(Package *p, Runtime *rt, const char *name) {
@@ -80,83 +58,105 @@ static int initialize_package(Package *p, Runtime *rt, const char *name) {
     return -1;
   }
 
+  // every symbol interned from here on points at p, so it has to be where it
+  // stays for good before anything is interned
+  TEST_CALL(list_push(&rt->packages, sizeof(Package *), &p));
+
   TEST_CALL(initialize_environment(p->global, NULL, p));
-  TEST_CALL(map_init(&p->interned_symbols, empty_name_cmp));
+  TEST_CALL(interned_symbols_init(&p->interned_symbols));
   TEST_CALL(list_init(&p->exported_symbols));
 
   LishpSymbol *nil_sym = intern_symbol(rt, p, "NIL");
   LishpSymbol *t_sym = intern_symbol(rt, p, "T");
 
-  bind_value(p->global, nil_sym, NIL);
-  bind_value(p->global, t_sym, T);
+  bind_value(rt, p->global, nil_sym, NIL);
+  bind_value(rt, p->global, t_sym, T);
 
   return 0;
 }
 
 static void cleanup_package(Package *p) {
   list_clear(&p->exported_symbols);
-  map_clear(&p->interned_symbols);
+  interned_symbols_clear(&p->interned_symbols);
   cleanup_environment(p->global);
+  free(p);
 }
 
 LishpSymbol *intern_symbol(Runtime *rt, Package *p, const char *lexeme) {
-  LishpSymbol *sym = NULL;
-  int err = map_get(&p->interned_symbols, sizeof(const char *),
-                    sizeof(LishpSymbol *), &lexeme, &sym);
+  return intern_chars(rt, p, lexeme, strlen(lexeme));
+}
+
+LishpSymbol *intern_chars(Runtime *rt, Package *p, const char *chars,
+                          uint32_t length) {
+  SymbolName name = {.chars = chars,
+                     .length = length,
+                     .hash = symbol_name_hash(chars, length)};
 
-  if (err == 0) {
+  LishpSymbol *sym = NULL;
+  if (interned_symbols_get(&p->interned_symbols, name, &sym) == 0) {
     return sym;
   }
 
   // not found, so allocate a new one and insert it
 
-  uint32_t len = strlen(lexeme);
+  // neither allocation is reachable until the symbol has been interned
+  pause_gc(rt->memory_manager);
+
   sym = ALLOCATE_OBJ(LishpSymbol, rt);
-  char *copied_lexeme = allocate(rt->memory_manager, 1 + len);
+  char *copied_lexeme = _allocate_obj(rt, 1 + length, kAllocText);
   if (sym == NULL) {
+    resume_gc(rt->memory_manager);
     return NULL;
   }
   if (copied_lexeme == NULL) {
     DEALLOCATE_OBJ(LishpSymbol, sym, rt);
+    resume_gc(rt->memory_manager);
     return NULL;
   }
-  *sym = SYMBOL(copied_lexeme, p->name);
+  *sym = SYMBOL(copied_lexeme, p, name.hash);
 
   // to make sure the string lasts
-  copied_lexeme[len] = '\0';
-  strncpy(copied_lexeme, lexeme, len);
+  memcpy(copied_lexeme, chars, length);
+  copied_lexeme[length] = '\0';
+
+  name.chars = copied_lexeme;
+  interned_symbols_insert(&p->interned_symbols, name, sym);
 
-  map_insert(&p->interned_symbols, sizeof(const char *), sizeof(LishpSymbol *),
-             &copied_lexeme, &sym);
+  resume_gc(rt->memory_manager);
 
   return sym;
 }
 
 LishpSymbol *gensym(Runtime *rt, Package *p, const char *lexeme) {
-  LishpSymbol *sym = NULL;
-  int err = map_get(&p->interned_symbols, sizeof(const char *),
-                    sizeof(LishpSymbol *), &lexeme, &sym);
+  uint32_t len = lexeme != NULL ? strlen(lexeme) : 0;
+  SymbolName name = {.chars = lexeme,
+                     .length = len,
+                     .hash = symbol_name_hash(lexeme, len)};
 
+  LishpSymbol *sym = NULL;
   uint32_t next_id = 1;
-  if (err == 0) {
+  if (interned_symbols_get(&p->interned_symbols, name, &sym) == 0) {
     next_id = sym->id + 1;
     // not returning, since we always want a unique symbol
   }
 
   // allocate a new symbol and insert it
 
+  pause_gc(rt->memory_manager);
+
   sym = ALLOCATE_OBJ(LishpSymbol, rt);
   if (sym == NULL) {
+    resume_gc(rt->memory_manager);
     return NULL;
   }
 
   char *new_str = NULL;
   if (lexeme != NULL) {
-    uint32_t len = strlen(lexeme);
-    new_str = allocate(rt->memory_manager, 1 + len);
+    new_str = _allocate_obj(rt, 1 + len, kAllocText);
 
     if (new_str == NULL) {
       DEALLOCATE_OBJ(LishpSymbol, sym, rt);
+      resume_gc(rt->memory_manager);
       return NULL;
     }
 
@@ -164,17 +164,21 @@ LishpSymbol *gensym(Runtime *rt, Package *p, const char *lexeme) {
     new_str[len] = '\0';
     strncpy(new_str, lexeme, len);
   }
-  *sym = GENSYM(new_str, p->name, next_id);
+  *sym = GENSYM(new_str, p, next_id, name.hash);
 
-  map_insert(&p->interned_symbols, sizeof(const char *), sizeof(LishpSymbol *),
-             &new_str, &sym);
+  name.chars = new_str;
+  interned_symbols_insert(&p->interned_symbols, name, sym);
+
+  resume_gc(rt->memory_manager);
 
   return sym;
 }
 
 static int intern_symbol_from(Package *target, LishpSymbol *sym) {
-  return map_insert(&target->interned_symbols, sizeof(const char *),
-                    sizeof(LishpSymbol *), &sym->lexeme, &sym);
+  SymbolName name = {.chars = sym->lexeme,
+                     .length = sym->lexeme != NULL ? strlen(sym->lexeme) : 0,
+                     .hash = sym->hash};
+  return interned_symbols_insert(&target->interned_symbols, name, sym);
 }
 
 static int import_package(Package *target, Package *source) {
@@ -199,11 +203,11 @@ static int initialize_packages(Runtime *rt) {
     }                                                                          \
     *name##_fn = FUNCTION_INHERENT(name);                                      \
                                                                                \
-    LishpSymbol *name##_sym = intern_symbol(rt, &package, lexeme);             \
-    bind_function(package.global, name##_sym, name##_fn);                      \
+    LishpSymbol *name##_sym = intern_symbol(rt, package, lexeme);              \
+    bind_function(rt, package->global, name##_sym, name##_fn);                 \
                                                                                \
     if (export) {                                                              \
-      TEST_CALL(list_push(&package.exported_symbols, sizeof(LishpSymbol *),    \
+      TEST_CALL(list_push(&package->exported_symbols, sizeof(LishpSymbol *),   \
                           &name##_sym));                                       \
     }                                                                          \
   } while (0)
@@ -212,13 +216,20 @@ static int initialize_packages(Runtime *rt) {
   const char *common_lisp_name = "COMMON-LISP";
   const char *user_name = "USER";
 
-  Package system;
-  Package common_lisp;
-  Package user;
+  Package *system = malloc(sizeof(Package));
+  Package *common_lisp = malloc(sizeof(Package));
+  Package *user = malloc(sizeof(Package));
+
+  if (system == NULL || common_lisp == NULL || user == NULL) {
+    free(system);
+    free(common_lisp);
+    free(user);
+    return -1;
+  }
 
-  TEST_CALL(initialize_package(&system, rt, system_name));
-  TEST_CALL(initialize_package(&common_lisp, rt, common_lisp_name));
-  TEST_CALL(initialize_package(&user, rt, user_name));
+  TEST_CALL(initialize_package(system, rt, system_name));
+  TEST_CALL(initialize_package(common_lisp, rt, common_lisp_name));
+  TEST_CALL(initialize_package(user, rt, user_name));
 
   int no_export = 0;
   int export = 1;
@@ -233,25 +244,53 @@ static int initialize_packages(Runtime *rt) {
   INSTALL_INHERENT(system_read_single_quote, system, "READ-SINGLE-QUOTE",
                    no_export);
 
+  INSTALL_INHERENT(system_gc_stats, system, "GC-STATS", export);
+  INSTALL_INHERENT(system_alloc_profile, system, "ALLOC-PROFILE", export);
+  INSTALL_INHERENT(system_aset, system, "ASET", export);
+  INSTALL_INHERENT(system_puthash, system, "PUTHASH", export);
+  INSTALL_INHERENT(system_vector_sum, system, "VECTOR-SUM", export);
+  INSTALL_INHERENT(system_vector_dot, system, "VECTOR-DOT", export);
+  INSTALL_INHERENT(system_vector_min, system, "VECTOR-MIN", export);
+  INSTALL_INHERENT(system_vector_max, system, "VECTOR-MAX", export);
+  INSTALL_INHERENT(system_vector_add, system, "VECTOR-ADD", export);
+  INSTALL_INHERENT(system_vector_multiply, system, "VECTOR-MULTIPLY", export);
+
   INSTALL_INHERENT(common_lisp_read, common_lisp, "READ", export);
   INSTALL_INHERENT(common_lisp_format, common_lisp, "FORMAT", export);
-
-  TEST_CALL(import_package(&user, &common_lisp));
-
-  TEST_CALL(list_push(&rt->packages, sizeof(Package), &system));
-  TEST_CALL(list_push(&rt->packages, sizeof(Package), &common_lisp));
-  TEST_CALL(list_push(&rt->packages, sizeof(Package), &user));
+  INSTALL_INHERENT(common_lisp_room, common_lisp, "ROOM", export);
+  INSTALL_INHERENT(common_lisp_plus, common_lisp, "+", export);
+  INSTALL_INHERENT(common_lisp_minus, common_lisp, "-", export);
+  INSTALL_INHERENT(common_lisp_times, common_lisp, "*", export);
+  INSTALL_INHERENT(common_lisp_divide, common_lisp, "/", export);
+  INSTALL_INHERENT(common_lisp_floor, common_lisp, "FLOOR", export);
+  INSTALL_INHERENT(common_lisp_mod, common_lisp, "MOD", export);
+  INSTALL_INHERENT(common_lisp_float, common_lisp, "FLOAT", export);
+  INSTALL_INHERENT(common_lisp_make_array, common_lisp, "MAKE-ARRAY", export);
+  INSTALL_INHERENT(common_lisp_aref, common_lisp, "AREF", export);
+  INSTALL_INHERENT(common_lisp_length, common_lisp, "LENGTH", export);
+  INSTALL_INHERENT(common_lisp_fill, common_lisp, "FILL", export);
+  INSTALL_INHERENT(common_lisp_replace, common_lisp, "REPLACE", export);
+  INSTALL_INHERENT(common_lisp_make_hash_table, common_lisp, "MAKE-HASH-TABLE",
+                   export);
+  INSTALL_INHERENT(common_lisp_gethash, common_lisp, "GETHASH", export);
+  INSTALL_INHERENT(common_lisp_remhash, common_lisp, "REMHASH", export);
+  INSTALL_INHERENT(common_lisp_maphash, common_lisp, "MAPHASH", export);
+  INSTALL_INHERENT(common_lisp_hash_table_count, common_lisp,
+                   "HASH-TABLE-COUNT", export);
+
+  TEST_CALL(import_package(user, common_lisp));
+  TEST_CALL(import_package(user, system));
 
   return 0;
 }
 
 Package *find_package(Runtime *rt, const char *name) {
-  Package *ptr = NULL;
+  Package **ptr = NULL;
 
-  list_find(&rt->packages, sizeof(Package), names_equal, (void *)name,
+  list_find(&rt->packages, sizeof(Package *), names_equal, (void *)name,
             (void **)&ptr);
 
-  return ptr;
+  return ptr == NULL ? NULL : *ptr;
 }
 
 static int initialize_system_readtable(Runtime *rt, LishpReadtable *readtable) {
@@ -260,14 +299,14 @@ static int initialize_system_readtable(Runtime *rt, LishpReadtable *readtable) {
     char c = ch;                                                               \
     LishpSymbol *fn_sym = intern_symbol(rt, system_package, name);             \
     LishpFunction *fn = symbol_function(rt, system_package->global, fn_sym);   \
-    map_insert(&readtable->reader_macros, sizeof(char),                        \
-               sizeof(LishpFunction *), &c, &fn);                              \
+    hash_map_insert(&readtable->reader_macros, sizeof(char),                   \
+                    sizeof(LishpFunction *), &c, &fn);                         \
   } while (0)
 
   Package *system_package = find_package(rt, "SYSTEM");
 
   *readtable = READTABLE(kUpcase);
-  TEST_CALL(map_init(&readtable->reader_macros, char_cmp));
+  TEST_CALL(hash_map_init(&readtable->reader_macros, char_hash, char_cmp));
 
   INSTALL_READER_MACRO('(', "READ-OPEN-PAREN");
   INSTALL_READER_MACRO(')', "READ-CLOSE-PAREN");
@@ -290,24 +329,38 @@ static void repl(Runtime *rt) {
   interpret_function_call(rt->interpreter, 0);
 }
 
-void _obj_mark_used(Runtime *rt, LishpObject *obj) {
-  mark_used(rt->memory_manager, obj);
+static void trace_obj(Runtime *rt, void *ptr) {
+  LishpObject *obj = ptr;
+
+  if (rt->live_counts != NULL) {
+    // tracers can run on several marking threads at once
+    __atomic_add_fetch(&rt->live_counts->objects[obj->type], 1,
+                       __ATOMIC_RELAXED);
+  }
 
   switch (obj->type) {
   case kCons: {
-    FORM_MARK_USED(rt, AS(LishpCons, obj)->car);
-    FORM_MARK_USED(rt, AS(LishpCons, obj)->cdr);
+    // the mark stack is last in first out, so pushing the cdr first means
+    // the car is traced first and the stack stays short on long lists
+    FORM_MARK_SLOT(rt, AS(LishpCons, obj)->cdr);
+    FORM_MARK_SLOT(rt, AS(LishpCons, obj)->car);
   } break;
   case kString: {
-    const char *lexeme = AS(LishpString, obj)->lexeme;
-    if (lexeme != NULL) {
-      other_mark_used(rt, (void *)lexeme);
+    if (AS(LishpString, obj)->lexeme != NULL) {
+      other_mark_slot(rt, (void **)&AS(LishpString, obj)->lexeme);
     }
   } break;
   case kSymbol: {
-    const char *lexeme = AS(LishpSymbol, obj)->lexeme;
-    if (lexeme != NULL) {
-      other_mark_used(rt, (void *)lexeme);
+    // the lexeme is also the key the symbol is interned under, so it has to
+    // stay put
+    LishpSymbol *sym = AS(LishpSymbol, obj);
+    if (sym->lexeme != NULL) {
+      other_mark_used(rt, (void *)sym->lexeme);
+    }
+
+    FORM_MARK_SLOT(rt, sym->value);
+    if (sym->function != NULL) {
+      OBJ_MARK_USED(rt, sym->function);
     }
   } break;
   case kStream: {
@@ -316,28 +369,73 @@ void _obj_mark_used(Runtime *rt, LishpObject *obj) {
   } break;
   case kReadtable: {
   } break;
+  case kBignum: {
+  } break;
+  case kSimpleVector: {
+    LishpSimpleVector *vector = AS(LishpSimpleVector, obj);
+    for (uint32_t ind = 0; ind < vector->length; ++ind) {
+      FORM_MARK_SLOT(rt, vector->elements[ind]);
+    }
+  } break;
+  case kHashTable: {
+    LishpHashTable *table = AS(LishpHashTable, obj);
+    for (uint32_t ind = 0; ind < table->capacity; ++ind) {
+      HashTableEntry *entry = &table->entries[ind];
+      if (HASH_ENTRY_LIVE_P(entry)) {
+        FORM_MARK_SLOT(rt, entry->key);
+        FORM_MARK_SLOT(rt, entry->value);
+      }
+    }
+    other_mark_slot(rt, (void **)&table->entries);
+  } break;
+  case kDoubleFloat:
+  case kFixnumVector:
+  case kDoubleFloatVector:
+  case kCharacterVector:
+  case kBitVector: {
+    // nothing in these can refer to anything
+  } break;
   }
 }
 
+void _obj_mark_used(Runtime *rt, LishpObject *obj) {
+  mark_used(rt->memory_manager, obj, trace_obj);
+}
+
 void other_mark_used(Runtime *rt, void *obj) {
-  mark_used(rt->memory_manager, obj);
+  mark_used(rt->memory_manager, obj, NULL);
+}
+
+void _obj_mark_slot(Runtime *rt, LishpObject **slot) {
+  mark_slot(rt->memory_manager, (void **)slot, trace_obj);
 }
 
-static int sym_val_mark_used_it(void *arg, void *key, void *val) {
+void other_mark_slot(Runtime *rt, void **slot) {
+  mark_slot(rt->memory_manager, slot, NULL);
+}
+
+void _obj_write_barrier(Runtime *rt, void *container, LishpObject *obj) {
+  write_barrier(rt->memory_manager, container, obj, trace_obj);
+}
+
+void other_write_barrier(Runtime *rt, void *container, void *obj) {
+  write_barrier(rt->memory_manager, container, obj, NULL);
+}
+
+static int sym_val_mark_used_it(void *arg, LishpSymbol **sym,
+                                LishpForm *form) {
   Runtime *rt = arg;
-  LishpSymbol **sym = key;
-  LishpForm *form = val;
 
+  // symbols are the keys the map is hashed by, so they can't move
   OBJ_MARK_USED(rt, *sym);
-  FORM_MARK_USED(rt, *form);
+  FORM_MARK_SLOT(rt, *form);
 
   return 0;
 }
 
-static int sym_func_mark_used_it(void *arg, void *key, void *val) {
+static int sym_func_mark_used_it(void *arg, LishpSymbol **sym,
+                                 LishpFunction **fn) {
   Runtime *rt = arg;
-  LishpSymbol **sym = key;
-  LishpFunction **fn = val;
 
   OBJ_MARK_USED(rt, *sym);
   OBJ_MARK_USED(rt, *fn);
@@ -345,23 +443,30 @@ static int sym_func_mark_used_it(void *arg, void *key, void *val) {
   return 0;
 }
 
-void environment_mark_used(Runtime *rt, Environment *env) {
-  mark_used(rt->memory_manager, env);
+static void trace_environment(Runtime *rt, void *ptr) {
+  Environment *env = ptr;
+
+  if (rt->live_counts != NULL) {
+    __atomic_add_fetch(&rt->live_counts->environments, 1, __ATOMIC_RELAXED);
+  }
+
   if (env->parent != NULL) {
     environment_mark_used(rt, env->parent);
   }
 
-  map_foreach(&env->symbol_values, sizeof(LishpSymbol *), sizeof(LishpForm),
-              sym_val_mark_used_it, rt);
-  map_foreach(&env->symbol_functions, sizeof(LishpSymbol *),
-              sizeof(LishpFunction *), sym_func_mark_used_it, rt);
+  symbol_values_foreach(&env->symbol_values, sym_val_mark_used_it, rt);
+  symbol_functions_foreach(&env->symbol_functions, sym_func_mark_used_it, rt);
+}
+
+void environment_mark_used(Runtime *rt, Environment *env) {
+  mark_used(rt->memory_manager, env, trace_environment);
 }
 
-static int interned_syms_mark_used_it(void *arg, void *key, void *val) {
-  (void)key;
+static int interned_syms_mark_used_it(void *arg, SymbolName *name,
+                                      LishpSymbol **sym) {
+  (void)name;
 
   Runtime *rt = arg;
-  LishpSymbol **sym = val;
 
   OBJ_MARK_USED(rt, *sym);
 
@@ -379,12 +484,12 @@ static int exported_syms_mark_used_it(void *arg, void *obj) {
 
 static int package_mark_used_it(void *arg, void *obj) {
   Runtime *rt = arg;
-  Package *p = obj;
+  Package *p = *(Package **)obj;
 
   environment_mark_used(rt, p->global);
   OBJ_MARK_USED(rt, p->current_readtable);
-  map_foreach(&p->interned_symbols, sizeof(const char *), sizeof(LishpSymbol *),
-              interned_syms_mark_used_it, rt);
+  interned_symbols_foreach(&p->interned_symbols, interned_syms_mark_used_it,
+                           rt);
   list_foreach(&p->exported_symbols, sizeof(LishpSymbol *),
                exported_syms_mark_used_it, rt);
 
@@ -400,13 +505,83 @@ static void objs_mark_used(Runtime *rt) {
     interpreter_mark_used_objs(rt->interpreter);
   }
 
-  list_foreach(&rt->packages, sizeof(Package), package_mark_used_it, rt);
+  list_foreach(&rt->packages, sizeof(Package *), package_mark_used_it, rt);
+}
+
+void count_live_objects(Runtime *rt, LiveObjectCounts *counts) {
+  *counts = (LiveObjectCounts){.objects = {0}, .environments = 0};
+
+  // anything already traced by an incremental collection in progress
+  // wouldn't be traced again, so finish that one off first
+  collect_garbage(rt->memory_manager);
+
+  rt->live_counts = counts;
+  collect_garbage(rt->memory_manager);
+  rt->live_counts = NULL;
+}
+
+static void read_byte_size_setting(const char *name, uint64_t *setting) {
+  const char *value = getenv(name);
+  if (value != NULL && parse_byte_size(value, setting) < 0) {
+    fprintf(stderr, "[runtime]: Ignoring invalid %s \"%s\"\n", name, value);
+  }
+}
+
+static void read_number_setting(const char *name, uint64_t *setting) {
+  const char *value = getenv(name);
+  if (value == NULL) {
+    return;
+  }
+
+  char *end;
+  unsigned long long parsed = strtoull(value, &end, 10);
+  if (end == value || *end != '\0') {
+    fprintf(stderr, "[runtime]: Ignoring invalid %s \"%s\"\n", name, value);
+    return;
+  }
+
+  *setting = parsed;
+}
+
+static ManagerSettings read_manager_settings() {
+  ManagerSettings settings = DEFAULT_MANAGER_SETTINGS;
+
+  read_byte_size_setting("LISHP_MAX_HEAP", &settings.max_heap_size);
+  read_byte_size_setting("LISHP_NURSERY_SIZE", &settings.nursery_size);
+  read_number_setting("LISHP_GC_SLICE_US", &settings.mark_slice_us);
+  read_number_setting("LISHP_GC_GROWTH", &settings.gc_growth_percent);
+  read_number_setting("LISHP_GC_COMPACT", &settings.compact);
+  read_number_setting("LISHP_GC_THREADS", &settings.mark_threads);
+
+  return settings;
 }
 
 int initialize_runtime(Runtime *rt) {
   rt->repl = repl;
 
-  TEST_CALL(initialize_manager(&rt->memory_manager, objs_mark_used, rt));
+  rt->system_readtable = NULL;
+  rt->interpreter = NULL;
+  rt->live_counts = NULL;
+  rt->profile = NULL;
+  rt->lexical_functions = 0;
+
+  TEST_CALL(initialize_manager(&rt->memory_manager, objs_mark_used, rt,
+                               read_manager_settings()));
+
+  uint64_t profile_allocations = 0;
+  read_number_setting("LISHP_ALLOC_PROFILE", &profile_allocations);
+  if (profile_allocations) {
+    TEST_CALL(initialize_profile(&rt->profile, rt));
+  }
+
+  uint64_t widest_isa = VECTOR_ISA_COUNT - 1;
+  read_number_setting("LISHP_SIMD", &widest_isa);
+  rt->kernels = select_vector_kernels(
+      widest_isa < VECTOR_ISA_COUNT ? widest_isa : VECTOR_ISA_COUNT - 1);
+
+  // the packages, readtable and interpreter aren't reachable from the runtime
+  // until they have been fully built, so don't collect while bootstrapping
+  pause_gc(rt->memory_manager);
 
   rt->system_readtable = ALLOCATE_OBJ(LishpReadtable, rt);
 
@@ -423,12 +598,14 @@ int initialize_runtime(Runtime *rt) {
   Environment *initial_env = user_package->global;
   TEST_CALL(initialize_interpreter(&rt->interpreter, rt, initial_env));
 
+  resume_gc(rt->memory_manager);
+
   return 0;
 }
 
 static int cleanup_package_it(void *arg, void *obj) {
   (void)arg;
-  cleanup_package((Package *)obj);
+  cleanup_package(*(Package **)obj);
   return 0;
 }
 
@@ -438,27 +615,67 @@ int cleanup_runtime(Runtime *rt) {
 
   // TODO: cleanup system readtable?
 
-  list_foreach(&rt->packages, sizeof(Package), cleanup_package_it, NULL);
+  list_foreach(&rt->packages, sizeof(Package *), cleanup_package_it, NULL);
   list_clear(&rt->packages);
 
+  if (rt->profile != NULL) {
+    print_profile(rt->profile, stdout);
+  }
+
+  GcStats stats = inspect_gc_stats(rt->memory_manager);
+  GcCycleStats cycles = stats.cycles;
+  GcPauseTimes pauses = stats.pauses;
+
   uint32_t remaining_bytes;
   int cleanup_manager_result =
       cleanup_manager(&rt->memory_manager, &remaining_bytes);
 
+  fprintf(stdout,
+          "[runtime]: %lu full (%lu compacting) and %lu minor collections, "
+          "the last full one reclaimed %lu bytes and left %lu live\n",
+          (unsigned long)cycles.full_collections,
+          (unsigned long)cycles.compactions,
+          (unsigned long)cycles.minor_collections,
+          (unsigned long)cycles.reclaimed_bytes,
+          (unsigned long)cycles.live_bytes);
+  fprintf(stdout,
+          "[runtime]: %lu GC pauses, longest %.3fms, %.3fms in total\n",
+          (unsigned long)pauses.count, pauses.max_ns / 1e6,
+          pauses.total_ns / 1e6);
   fprintf(stdout, "[runtime]: Cleanup with %u bytes still allocated\n",
           remaining_bytes);
 
+  if (rt->profile != NULL) {
+    cleanup_profile(&rt->profile);
+  }
+
   return 0;
 }
 
-void *_allocate_obj(Runtime *rt, uint32_t size) {
-  return allocate(rt->memory_manager, size);
+static void heap_exhausted(uint32_t size) {
+  // there's no way to signal a condition yet, so this is fatal
+  fprintf(stderr,
+          "[runtime]: Heap exhausted allocating %u bytes, try raising "
+          "LISHP_MAX_HEAP\n",
+          size);
+  abort();
+}
+
+void *_allocate_obj(Runtime *rt, uint32_t size, uint32_t kind) {
+  void *obj = allocate(rt->memory_manager, size);
+  if (obj == NULL) {
+    heap_exhausted(size);
+  }
+  if (rt->profile != NULL) {
+    profile_allocation(rt->profile, obj, size, kind);
+  }
+  return obj;
 }
 
 const char *allocate_str(Runtime *rt, const char *to_copy) {
   uint32_t len = strlen(to_copy);
 
-  char *dest = allocate(rt->memory_manager, 1 + len);
+  char *dest = _allocate_obj(rt, 1 + len, kAllocText);
   strncpy(dest, to_copy, len);
   dest[len] = '\0';
 
@@ -466,11 +683,14 @@ const char *allocate_str(Runtime *rt, const char *to_copy) {
 }
 
 void _deallocate_obj(Runtime *rt, void *ptr, uint32_t size) {
+  if (rt->profile != NULL) {
+    profile_deallocation(rt->profile, ptr);
+  }
   deallocate(rt->memory_manager, ptr, size);
 }
 
 Environment *allocate_env(Runtime *rt, Environment *parent) {
-  Package *p = find_package(rt, parent->package);
+  Package *p = parent->package;
 
   Environment *new_env = ALLOCATE_OBJ(Environment, rt);
   if (new_env == NULL) {
@@ -4,7 +4,10 @@
 #include <string.h>
 
 #include "runtime.h"
+#include "runtime/allocation_profile.h"
+#include "runtime/arrays.h"
 #include "runtime/functions.h"
+#include "runtime/hash_tables.h"
 #include "runtime/interpreter.h"
 #include "runtime/types.h"
 
@@ -32,8 +35,13 @@ LishpFunctionReturn system_repl(Interpreter *interpreter, LishpList args) {
 
   const char *copied_format_str = allocate_str(rt, "~A~%");
   *output_str = STRING(copied_format_str);
+  other_write_barrier(rt, output_str, (void *)copied_format_str);
 
   while (1) {
+    // nothing but the roots and this stack refers to the heap in between top
+    // level forms, so it's safe to move objects around here
+    compact_if_fragmented(rt->memory_manager);
+
     int push_result0 = push_function(interpreter, read_fn);
 
     LishpFunctionReturn read_ret = interpret_function_call(interpreter, 0);
@@ -120,8 +128,10 @@ LishpFunctionReturn system_read_open_paren(Interpreter *interpreter,
     add_character(&string_buf, c);
   }
 
-  // pointer to the address of the last cons that was added
-  LishpCons **last_cons_ptr = NULL;
+  // the last cons that was added. the head of the list lives on the form
+  // stack, which can be reallocated while reading, so never hold a pointer into
+  // it across calls
+  LishpCons *last_cons = NULL;
   LishpForm res_form = NIL;
 
   FILE *temp_file_stream = tmpfile();
@@ -153,23 +163,22 @@ LishpFunctionReturn system_read_open_paren(Interpreter *interpreter,
 
     LishpForm form = read_res.first_return;
 
-    LishpForm *cur_return_val;
-    if (last_cons_ptr == NULL) {
+    LishpCons *next_cons = ALLOCATE_OBJ(LishpCons, rt);
+    *next_cons = CONS(form, NIL);
+
+    if (last_cons == NULL) {
+      LishpForm *cur_return_val;
       int push_result0 = push_form_return(interpreter, &cur_return_val);
-      last_cons_ptr = (LishpCons **)&cur_return_val->object;
+      *cur_return_val = FROM_OBJ(next_cons);
     } else {
-      cur_return_val = &(*last_cons_ptr)->cdr;
+      last_cons->cdr = FROM_OBJ(next_cons);
+      OBJ_WRITE_BARRIER(rt, last_cons, next_cons);
     }
 
-    LishpCons *next_cons = ALLOCATE_OBJ(LishpCons, rt);
-    *cur_return_val = FROM_OBJ(NULL);
-
-    last_cons_ptr = (LishpCons **)&cur_return_val->object;
-    *last_cons_ptr = next_cons;
-    **last_cons_ptr = CONS(form, NIL);
+    last_cons = next_cons;
   }
 
-  if (last_cons_ptr != NULL) {
+  if (last_cons != NULL) {
     int pop_result = pop_form_return(interpreter, &res_form);
   }
 
@@ -282,6 +291,7 @@ LishpFunctionReturn system_read_double_quote(Interpreter *interpreter,
 
   const char *copied = allocate_str(rt, builder.items);
   *str_obj = STRING(copied);
+  other_write_barrier(rt, str_obj, (void *)copied);
 
   list_clear(&builder);
 
@@ -325,9 +335,218 @@ LishpFunctionReturn system_read_single_quote(Interpreter *interpreter,
   LishpCons *form_nil = ALLOCATE_OBJ(LishpCons, rt);
   *form_nil = CONS(read_form, NIL);
   quote_rest->cdr = FROM_OBJ(form_nil);
+  OBJ_WRITE_BARRIER(rt, quote_rest, form_nil);
 
   LishpForm ret_form;
   int pop_result = pop_form_return(interpreter, &ret_form);
 
   return SINGLE_RETURN(ret_form);
 }
+
+typedef struct {
+  const char *name;
+  uint64_t value;
+} GcStat;
+
+// conses (name . value) onto the front of the list at plist
+static void push_gc_stat(Runtime *rt, Package *system, LishpForm *plist,
+                         GcStat stat) {
+  LishpSymbol *sym = intern_symbol(rt, system, stat.name);
+
+  LishpCons *cell = ALLOCATE_OBJ(LishpCons, rt);
+  *cell = CONS(NIL, *plist);
+  *plist = FROM_OBJ(cell);
+
+  // a count that big would take a bignum, which could be collected while the
+  // pair is allocated, and nothing gets near it anyway
+  int64_t value = stat.value > (uint64_t)MOST_POSITIVE_FIXNUM
+                      ? MOST_POSITIVE_FIXNUM
+                      : (int64_t)stat.value;
+
+  LishpCons *pair = ALLOCATE_OBJ(LishpCons, rt);
+  *pair = CONS(FROM_OBJ(sym), FROM_FIXNUM(value));
+  cell->car = FROM_OBJ(pair);
+  OBJ_WRITE_BARRIER(rt, cell, pair);
+}
+
+LishpFunctionReturn system_gc_stats(Interpreter *interpreter, LishpList args) {
+  (void)args;
+
+  Runtime *rt = get_runtime(interpreter);
+  Package *system = find_package(rt, "SYSTEM");
+
+  GcStats stats = inspect_gc_stats(rt->memory_manager);
+
+  // byte counts are in kilobytes and times in microseconds, so that they fit
+  // in a fixnum
+  GcStat gc_stats[] = {
+      {"FULL-COLLECTIONS", stats.cycles.full_collections},
+      {"MINOR-COLLECTIONS", stats.cycles.minor_collections},
+      {"COMPACTIONS", stats.cycles.compactions},
+      {"PAUSES", stats.pauses.count},
+      {"PAUSE-TOTAL-US", stats.pauses.total_ns / 1000},
+      {"PAUSE-MAX-US", stats.pauses.max_ns / 1000},
+      {"PAUSES-UNDER-10US", stats.pauses.histogram[0]},
+      {"PAUSES-UNDER-100US", stats.pauses.histogram[1]},
+      {"PAUSES-UNDER-1MS", stats.pauses.histogram[2]},
+      {"PAUSES-UNDER-10MS", stats.pauses.histogram[3]},
+      {"PAUSES-UNDER-100MS", stats.pauses.histogram[4]},
+      {"PAUSES-OVER-100MS", stats.pauses.histogram[5]},
+      {"ALLOCATED-KB", stats.allocated_bytes >> 10},
+      {"RECLAIMED-KB", stats.reclaimed_bytes >> 10},
+      {"LIVE-KB", (stats.allocated_bytes - stats.reclaimed_bytes) >> 10},
+      {"HEAP-KB", stats.heap_size >> 10},
+      {"LARGE-OBJECTS", stats.large_objects},
+      {"LARGE-KB", stats.large_bytes >> 10},
+      {"FREE-KB", stats.free_bytes >> 10},
+      {"FREE-CHUNKS", stats.free_chunks},
+      {"LARGEST-FREE-KB", stats.largest_free_chunk >> 10},
+  };
+  uint32_t stat_count = sizeof(gc_stats) / sizeof(gc_stats[0]);
+
+  LishpForm *plist;
+  int push_result = push_form_return(interpreter, &plist);
+  assert(push_result == 0 && "Couldn't push the stats list!");
+  *plist = NIL;
+
+  // built back to front, so the list comes out in the same order
+  for (uint32_t ind = stat_count; ind > 0; --ind) {
+    push_gc_stat(rt, system, plist, gc_stats[ind - 1]);
+  }
+
+  LishpForm ret_form;
+  int pop_result = pop_form_return(interpreter, &ret_form);
+  assert(pop_result == 0 && "Couldn't pop the stats list!");
+
+  return SINGLE_RETURN(ret_form);
+}
+
+LishpFunctionReturn system_alloc_profile(Interpreter *interpreter,
+                                         LishpList args) {
+  (void)args;
+
+  Runtime *rt = get_runtime(interpreter);
+
+  if (rt->profile == NULL) {
+    printf("\nAllocations aren't being profiled, set LISHP_ALLOC_PROFILE=1 "
+           "to turn it on\n");
+  } else {
+    printf("\n");
+    print_profile(rt->profile, stdout);
+  }
+
+  return EMPTY_RETURN;
+}
+
+// stands in for (setf (aref vector index) value) until there is a setf
+LishpFunctionReturn system_aset(Interpreter *interpreter, LishpList args) {
+  assert(!args.nil && "Arguments expected!");
+
+  LishpCons *index_cons = NULL;
+  LishpCons *value_cons = NULL;
+  if (IS_OBJECT_TYPE(args.cons->cdr, kCons)) {
+    index_cons = AS_OBJECT(LishpCons, args.cons->cdr);
+    if (IS_OBJECT_TYPE(index_cons->cdr, kCons)) {
+      value_cons = AS_OBJECT(LishpCons, index_cons->cdr);
+    }
+  }
+  assert(value_cons != NULL && "Index and value expected!");
+
+  LishpForm vector = args.cons->car;
+  LishpForm index = index_cons->car;
+  LishpForm value = value_cons->car;
+
+  assert(VECTOR_P(vector) && "Expected a vector!");
+  assert(FIXNUM_P(index) && AS_FIXNUM(index) >= 0 && "Expected an index!");
+
+  vector_set(get_runtime(interpreter), vector.object, AS_FIXNUM(index), value);
+
+  return SINGLE_RETURN(value);
+}
+
+// stands in for (setf (gethash key table) value)
+LishpFunctionReturn system_puthash(Interpreter *interpreter, LishpList args) {
+  assert(!args.nil && "Arguments expected!");
+
+  LishpCons *table_cons = NULL;
+  LishpCons *value_cons = NULL;
+  if (IS_OBJECT_TYPE(args.cons->cdr, kCons)) {
+    table_cons = AS_OBJECT(LishpCons, args.cons->cdr);
+    if (IS_OBJECT_TYPE(table_cons->cdr, kCons)) {
+      value_cons = AS_OBJECT(LishpCons, table_cons->cdr);
+    }
+  }
+  assert(value_cons != NULL && "Hash table and value expected!");
+
+  LishpForm key = args.cons->car;
+  LishpForm table = table_cons->car;
+  LishpForm value = value_cons->car;
+
+  assert(HASH_TABLE_P(table) && "Expected a hash table!");
+
+  hash_table_put(get_runtime(interpreter), AS_OBJECT(LishpHashTable, table),
+                 key, value);
+
+  return SINGLE_RETURN(value);
+}
+
+static LishpObject *vector_arg(LishpForm form) {
+  assert(VECTOR_P(form) && "Expected a vector!");
+  return form.object;
+}
+
+static LishpObject *second_vector_arg(LishpList args) {
+  assert(IS_OBJECT_TYPE(args.cons->cdr, kCons) && "Two vectors expected!");
+  return vector_arg(AS_OBJECT(LishpCons, args.cons->cdr)->car);
+}
+
+LishpFunctionReturn system_vector_sum(Interpreter *interpreter,
+                                      LishpList args) {
+  assert(!args.nil && "Arguments expected!");
+
+  return SINGLE_RETURN(
+      vector_sum(get_runtime(interpreter), vector_arg(args.cons->car)));
+}
+
+LishpFunctionReturn system_vector_dot(Interpreter *interpreter,
+                                      LishpList args) {
+  assert(!args.nil && "Arguments expected!");
+
+  return SINGLE_RETURN(vector_dot(get_runtime(interpreter),
+                                  vector_arg(args.cons->car),
+                                  second_vector_arg(args)));
+}
+
+LishpFunctionReturn system_vector_min(Interpreter *interpreter,
+                                      LishpList args) {
+  assert(!args.nil && "Arguments expected!");
+
+  return SINGLE_RETURN(
+      vector_min(get_runtime(interpreter), vector_arg(args.cons->car)));
+}
+
+LishpFunctionReturn system_vector_max(Interpreter *interpreter,
+                                      LishpList args) {
+  assert(!args.nil && "Arguments expected!");
+
+  return SINGLE_RETURN(
+      vector_max(get_runtime(interpreter), vector_arg(args.cons->car)));
+}
+
+LishpFunctionReturn system_vector_add(Interpreter *interpreter,
+                                      LishpList args) {
+  assert(!args.nil && "Arguments expected!");
+
+  return SINGLE_RETURN(FROM_OBJ(vector_add(get_runtime(interpreter),
+                                           vector_arg(args.cons->car),
+                                           second_vector_arg(args))));
+}
+
+LishpFunctionReturn system_vector_multiply(Interpreter *interpreter,
+                                           LishpList args) {
+  assert(!args.nil && "Arguments expected!");
+
+  return SINGLE_RETURN(FROM_OBJ(vector_multiply(get_runtime(interpreter),
+                                                vector_arg(args.cons->car),
+                                                second_vector_arg(args))));
+}
@@ -1,30 +1,48 @@
 #include <stdio.h>
 
+#include "runtime/arrays.h"
+#include "runtime/numbers.h"
 #include "runtime/types.h"
 
 int form_cmp(LishpForm l, LishpForm r) {
-  if (l.type != r.type) {
-    return l.type - r.type;
-  }
+  // forms are eq only if they are the same word, which for objects means the
+  // _same_ object
+  return l.bits < r.bits ? -1 : l.bits > r.bits ? 1 : 0;
+}
 
-  switch (l.type) {
-  case kT: {
-    return 0;
-  } break;
-  case kNil: {
-    return 0;
-  } break;
-  case kChar: {
-    return l.ch - r.ch;
-  } break;
-  case kFixnum: {
-    return l.fixnum - r.fixnum;
-  } break;
-  case kObject: {
-    // objects are eq only if they are the _same_ object
-    return l.object - r.object;
-  } break;
+const char *object_type_name(ObjectType type) {
+  switch (type) {
+  case kCons:
+    return "CONS";
+  case kString:
+    return "STRING";
+  case kSymbol:
+    return "SYMBOL";
+  case kFunction:
+    return "FUNCTION";
+  case kReadtable:
+    return "READTABLE";
+  case kStream:
+    return "STREAM";
+  case kBignum:
+    return "BIGNUM";
+  case kDoubleFloat:
+    return "DOUBLE-FLOAT";
+  case kSimpleVector:
+    return "SIMPLE-VECTOR";
+  case kFixnumVector:
+    return "FIXNUM-VECTOR";
+  case kDoubleFloatVector:
+    return "DOUBLE-FLOAT-VECTOR";
+  case kCharacterVector:
+    return "CHARACTER-VECTOR";
+  case kBitVector:
+    return "BIT-VECTOR";
+  case kHashTable:
+    return "HASH-TABLE";
   }
+
+  return "UNKNOWN";
 }
 
 static void print_cons_rec(LishpCons *cons, int first) {
@@ -91,6 +109,51 @@ static void print_function(LishpFunction *func) {
   }
 }
 
+static void print_double_form(double value) {
+  printf("DOUBLE-FLOAT(");
+  print_double(value, stdout);
+  printf(")");
+}
+
+static void print_vector(LishpObject *obj) {
+  if (obj->type == kBitVector) {
+    LishpBitVector *bits = AS(LishpBitVector, obj);
+    printf("#*");
+    for (uint32_t ind = 0; ind < bits->length; ++ind) {
+      printf("%d", (int)((bits->words[ind / 64] >> (ind % 64)) & 1));
+    }
+    return;
+  }
+
+  printf("#(");
+  uint32_t length = vector_length(obj);
+  for (uint32_t ind = 0; ind < length; ++ind) {
+    if (ind > 0) {
+      printf(" ");
+    }
+
+    // the elements are printed the way print_form would if they were forms,
+    // without boxing any double-floats to get there
+    switch (obj->type) {
+    case kSimpleVector: {
+      print_form(AS(LishpSimpleVector, obj)->elements[ind]);
+    } break;
+    case kFixnumVector: {
+      printf("FIXNUM(%ld)", (long)AS(LishpFixnumVector, obj)->elements[ind]);
+    } break;
+    case kDoubleFloatVector: {
+      print_double_form(AS(LishpDoubleFloatVector, obj)->elements[ind]);
+    } break;
+    case kCharacterVector: {
+      printf("CHAR(%c)", AS(LishpCharacterVector, obj)->elements[ind]);
+    } break;
+    default:
+      break;
+    }
+  }
+  printf(")");
+}
+
 static void print_object(LishpObject *obj) {
   switch (obj->type) {
   case kCons: {
@@ -111,11 +174,32 @@ static void print_object(LishpObject *obj) {
   case kReadtable: {
     printf("<READTABLE>");
   } break;
+  case kBignum: {
+    printf("BIGNUM(");
+    print_bignum(AS(LishpBignum, obj), stdout);
+    printf(")");
+  } break;
+  case kDoubleFloat: {
+    print_double_form(AS(LishpDoubleFloat, obj)->value);
+  } break;
+  case kSimpleVector:
+  case kFixnumVector:
+  case kDoubleFloatVector:
+  case kCharacterVector:
+  case kBitVector: {
+    print_vector(obj);
+  } break;
+  case kHashTable: {
+    LishpHashTable *table = AS(LishpHashTable, obj);
+    const char *tests[] = {"EQ", "EQL", "EQUAL"};
+    printf("#<HASH-TABLE :TEST %s :COUNT %u>", tests[table->test],
+           table->count);
+  } break;
   }
 }
 
 void print_form(LishpForm f) {
-  switch (f.type) {
+  switch (FORM_TYPE(f)) {
   case kT: {
     printf("T");
   } break;
@@ -123,10 +207,13 @@ void print_form(LishpForm f) {
     printf("NIL");
   } break;
   case kChar: {
-    printf("CHAR(%c)", f.ch);
+    printf("CHAR(%c)", AS_CHAR(f));
   } break;
   case kFixnum: {
-    printf("FIXNUM(%u)", f.fixnum);
+    printf("FIXNUM(%ld)", (long)AS_FIXNUM(f));
+  } break;
+  case kImmediateFloat: {
+    print_double_form(as_double(f));
   } break;
   case kObject: {
     print_object(f.object);
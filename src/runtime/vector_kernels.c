@@ -0,0 +1,504 @@
+#include <stddef.h>
+
+#include "runtime/types.h"
+#include "runtime/vector_kernels.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define HAVE_X86_KERNELS
+#endif
+
+// a fixnum plus this is in [0, 2^62) exactly when it is in range, so a
+// shift by 62 is all it takes to check a whole register of them
+#define FIXNUM_BIAS ((int64_t)1 << 61)
+
+static int fits_fixnum(int64_t value) {
+  return MOST_NEGATIVE_FIXNUM <= value && value <= MOST_POSITIVE_FIXNUM;
+}
+
+// scalar
+
+static double sum_doubles_scalar(const double *x, uint32_t n) {
+  double sum = 0;
+  for (uint32_t ind = 0; ind < n; ++ind) {
+    sum += x[ind];
+  }
+  return sum;
+}
+
+static double dot_doubles_scalar(const double *x, const double *y,
+                                 uint32_t n) {
+  double sum = 0;
+  for (uint32_t ind = 0; ind < n; ++ind) {
+    sum += x[ind] * y[ind];
+  }
+  return sum;
+}
+
+static void min_max_doubles_scalar(const double *x, uint32_t n, double *min,
+                                   double *max) {
+  double lo = x[0];
+  double hi = x[0];
+  for (uint32_t ind = 1; ind < n; ++ind) {
+    lo = x[ind] < lo ? x[ind] : lo;
+    hi = x[ind] > hi ? x[ind] : hi;
+  }
+  *min = lo;
+  *max = hi;
+}
+
+static void add_doubles_scalar(double *out, const double *x, const double *y,
+                               uint32_t n) {
+  for (uint32_t ind = 0; ind < n; ++ind) {
+    out[ind] = x[ind] + y[ind];
+  }
+}
+
+static void multiply_doubles_scalar(double *out, const double *x,
+                                    const double *y, uint32_t n) {
+  for (uint32_t ind = 0; ind < n; ++ind) {
+    out[ind] = x[ind] * y[ind];
+  }
+}
+
+static __int128 sum_fixnums_scalar(const int64_t *x, uint32_t n) {
+  __int128 sum = 0;
+  for (uint32_t ind = 0; ind < n; ++ind) {
+    sum += x[ind];
+  }
+  return sum;
+}
+
+static void min_max_fixnums_scalar(const int64_t *x, uint32_t n, int64_t *min,
+                                   int64_t *max) {
+  int64_t lo = x[0];
+  int64_t hi = x[0];
+  for (uint32_t ind = 1; ind < n; ++ind) {
+    lo = x[ind] < lo ? x[ind] : lo;
+    hi = x[ind] > hi ? x[ind] : hi;
+  }
+  *min = lo;
+  *max = hi;
+}
+
+static int add_fixnums_scalar(int64_t *out, const int64_t *x, const int64_t *y,
+                              uint32_t n) {
+  int overflowed = 0;
+  for (uint32_t ind = 0; ind < n; ++ind) {
+    // two fixnums can't overflow 64 bits
+    out[ind] = x[ind] + y[ind];
+    overflowed |= !fits_fixnum(out[ind]);
+  }
+  return overflowed ? -1 : 0;
+}
+
+// there is no 64 bit multiply before AVX-512, so every set uses this one
+static int multiply_fixnums_scalar(int64_t *out, const int64_t *x,
+                                   const int64_t *y, uint32_t n) {
+  int overflowed = 0;
+  for (uint32_t ind = 0; ind < n; ++ind) {
+    overflowed |= __builtin_mul_overflow(x[ind], y[ind], &out[ind]);
+    overflowed |= !fits_fixnum(out[ind]);
+  }
+  return overflowed ? -1 : 0;
+}
+
+static void fill_words_scalar(uint64_t *out, uint32_t n, uint64_t value) {
+  for (uint32_t ind = 0; ind < n; ++ind) {
+    out[ind] = value;
+  }
+}
+
+static const VectorKernels scalar_kernels = {
+    .name = "scalar",
+    .sum_doubles = sum_doubles_scalar,
+    .dot_doubles = dot_doubles_scalar,
+    .min_max_doubles = min_max_doubles_scalar,
+    .add_doubles = add_doubles_scalar,
+    .multiply_doubles = multiply_doubles_scalar,
+    .sum_fixnums = sum_fixnums_scalar,
+    .min_max_fixnums = min_max_fixnums_scalar,
+    .add_fixnums = add_fixnums_scalar,
+    .multiply_fixnums = multiply_fixnums_scalar,
+    .fill_words = fill_words_scalar,
+};
+
+#ifdef HAVE_X86_KERNELS
+
+// SSE2, which every x86-64 CPU has
+
+static double horizontal_sum_sse2(__m128d v) {
+  return _mm_cvtsd_f64(v) + _mm_cvtsd_f64(_mm_unpackhi_pd(v, v));
+}
+
+static double sum_doubles_sse2(const double *x, uint32_t n) {
+  // two accumulators, so each add doesn't wait on the last
+  __m128d acc0 = _mm_setzero_pd();
+  __m128d acc1 = _mm_setzero_pd();
+
+  uint32_t ind = 0;
+  for (; ind + 4 <= n; ind += 4) {
+    acc0 = _mm_add_pd(acc0, _mm_loadu_pd(x + ind));
+    acc1 = _mm_add_pd(acc1, _mm_loadu_pd(x + ind + 2));
+  }
+
+  double sum = horizontal_sum_sse2(_mm_add_pd(acc0, acc1));
+  return sum + sum_doubles_scalar(x + ind, n - ind);
+}
+
+static double dot_doubles_sse2(const double *x, const double *y, uint32_t n) {
+  __m128d acc0 = _mm_setzero_pd();
+  __m128d acc1 = _mm_setzero_pd();
+
+  uint32_t ind = 0;
+  for (; ind + 4 <= n; ind += 4) {
+    acc0 = _mm_add_pd(acc0,
+                      _mm_mul_pd(_mm_loadu_pd(x + ind), _mm_loadu_pd(y + ind)));
+    acc1 = _mm_add_pd(acc1, _mm_mul_pd(_mm_loadu_pd(x + ind + 2),
+                                       _mm_loadu_pd(y + ind + 2)));
+  }
+
+  double sum = horizontal_sum_sse2(_mm_add_pd(acc0, acc1));
+  return sum + dot_doubles_scalar(x + ind, y + ind, n - ind);
+}
+
+static void min_max_doubles_sse2(const double *x, uint32_t n, double *min,
+                                 double *max) {
+  __m128d lo = _mm_set1_pd(x[0]);
+  __m128d hi = lo;
+
+  uint32_t ind = 0;
+  for (; ind + 2 <= n; ind += 2) {
+    __m128d v = _mm_loadu_pd(x + ind);
+    lo = _mm_min_pd(lo, v);
+    hi = _mm_max_pd(hi, v);
+  }
+
+  lo = _mm_min_sd(lo, _mm_unpackhi_pd(lo, lo));
+  hi = _mm_max_sd(hi, _mm_unpackhi_pd(hi, hi));
+
+  // the one left over, if n is odd, along with what the lanes found
+  double tail[2] = {_mm_cvtsd_f64(lo), _mm_cvtsd_f64(hi)};
+  if (ind < n) {
+    tail[0] = x[ind] < tail[0] ? x[ind] : tail[0];
+    tail[1] = x[ind] > tail[1] ? x[ind] : tail[1];
+  }
+  *min = tail[0];
+  *max = tail[1];
+}
+
+static void add_doubles_sse2(double *out, const double *x, const double *y,
+                             uint32_t n) {
+  uint32_t ind = 0;
+  for (; ind + 2 <= n; ind += 2) {
+    _mm_storeu_pd(out + ind,
+                  _mm_add_pd(_mm_loadu_pd(x + ind), _mm_loadu_pd(y + ind)));
+  }
+  add_doubles_scalar(out + ind, x + ind, y + ind, n - ind);
+}
+
+static void multiply_doubles_sse2(double *out, const double *x,
+                                  const double *y, uint32_t n) {
+  uint32_t ind = 0;
+  for (; ind + 2 <= n; ind += 2) {
+    _mm_storeu_pd(out + ind,
+                  _mm_mul_pd(_mm_loadu_pd(x + ind), _mm_loadu_pd(y + ind)));
+  }
+  multiply_doubles_scalar(out + ind, x + ind, y + ind, n - ind);
+}
+
+static __m128i load_fixnums_sse2(const int64_t *x) {
+  return _mm_loadu_si128((const __m128i *)x);
+}
+
+static __int128 sum_fixnums_sse2(const int64_t *x, uint32_t n) {
+  __int128 sum = 0;
+
+  // four fixnums always fit in 64 bits, so each lane adds up four before it
+  // is moved over into the 128 bit sum
+  uint32_t ind = 0;
+  for (; ind + 8 <= n; ind += 8) {
+    __m128i acc = _mm_add_epi64(load_fixnums_sse2(x + ind),
+                                load_fixnums_sse2(x + ind + 2));
+    acc = _mm_add_epi64(acc, load_fixnums_sse2(x + ind + 4));
+    acc = _mm_add_epi64(acc, load_fixnums_sse2(x + ind + 6));
+
+    sum += _mm_cvtsi128_si64(acc);
+    sum += _mm_cvtsi128_si64(_mm_unpackhi_epi64(acc, acc));
+  }
+
+  return sum + sum_fixnums_scalar(x + ind, n - ind);
+}
+
+static int add_fixnums_sse2(int64_t *out, const int64_t *x, const int64_t *y,
+                            uint32_t n) {
+  __m128i bias = _mm_set1_epi64x(FIXNUM_BIAS);
+  __m128i out_of_range = _mm_setzero_si128();
+
+  uint32_t ind = 0;
+  for (; ind + 2 <= n; ind += 2) {
+    __m128i sum =
+        _mm_add_epi64(load_fixnums_sse2(x + ind), load_fixnums_sse2(y + ind));
+    _mm_storeu_si128((__m128i *)(out + ind), sum);
+
+    out_of_range = _mm_or_si128(
+        out_of_range, _mm_srli_epi64(_mm_add_epi64(sum, bias), 62));
+  }
+
+  int overflowed = _mm_movemask_epi8(_mm_cmpeq_epi32(
+                       out_of_range, _mm_setzero_si128())) != 0xffff;
+  int tail = add_fixnums_scalar(out + ind, x + ind, y + ind, n - ind);
+
+  return overflowed || tail < 0 ? -1 : 0;
+}
+
+static void fill_words_sse2(uint64_t *out, uint32_t n, uint64_t value) {
+  __m128i v = _mm_set1_epi64x(value);
+
+  uint32_t ind = 0;
+  for (; ind + 2 <= n; ind += 2) {
+    _mm_storeu_si128((__m128i *)(out + ind), v);
+  }
+  fill_words_scalar(out + ind, n - ind, value);
+}
+
+static const VectorKernels sse2_kernels = {
+    .name = "sse2",
+    .sum_doubles = sum_doubles_sse2,
+    .dot_doubles = dot_doubles_sse2,
+    .min_max_doubles = min_max_doubles_sse2,
+    .add_doubles = add_doubles_sse2,
+    .multiply_doubles = multiply_doubles_sse2,
+    .sum_fixnums = sum_fixnums_sse2,
+    // comparing 64 bit integers takes SSE4.2
+    .min_max_fixnums = min_max_fixnums_scalar,
+    .add_fixnums = add_fixnums_sse2,
+    .multiply_fixnums = multiply_fixnums_scalar,
+    .fill_words = fill_words_sse2,
+};
+
+// AVX2, only called once the CPU has been checked for it
+
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 static double horizontal_sum_avx2(__m256d v) {
+  __m128d halves = _mm_add_pd(_mm256_castpd256_pd128(v),
+                              _mm256_extractf128_pd(v, 1));
+  return _mm_cvtsd_f64(halves) +
+         _mm_cvtsd_f64(_mm_unpackhi_pd(halves, halves));
+}
+
+AVX2 static double sum_doubles_avx2(const double *x, uint32_t n) {
+  __m256d acc0 = _mm256_setzero_pd();
+  __m256d acc1 = _mm256_setzero_pd();
+
+  uint32_t ind = 0;
+  for (; ind + 8 <= n; ind += 8) {
+    acc0 = _mm256_add_pd(acc0, _mm256_loadu_pd(x + ind));
+    acc1 = _mm256_add_pd(acc1, _mm256_loadu_pd(x + ind + 4));
+  }
+
+  double sum = horizontal_sum_avx2(_mm256_add_pd(acc0, acc1));
+  return sum + sum_doubles_scalar(x + ind, n - ind);
+}
+
+AVX2 static double dot_doubles_avx2(const double *x, const double *y,
+                                    uint32_t n) {
+  __m256d acc0 = _mm256_setzero_pd();
+  __m256d acc1 = _mm256_setzero_pd();
+
+  uint32_t ind = 0;
+  for (; ind + 8 <= n; ind += 8) {
+    acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(x + ind),
+                                             _mm256_loadu_pd(y + ind)));
+    acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(_mm256_loadu_pd(x + ind + 4),
+                                             _mm256_loadu_pd(y + ind + 4)));
+  }
+
+  double sum = horizontal_sum_avx2(_mm256_add_pd(acc0, acc1));
+  return sum + dot_doubles_scalar(x + ind, y + ind, n - ind);
+}
+
+AVX2 static void min_max_doubles_avx2(const double *x, uint32_t n,
+                                      double *min, double *max) {
+  __m256d lo = _mm256_set1_pd(x[0]);
+  __m256d hi = lo;
+
+  uint32_t ind = 0;
+  for (; ind + 4 <= n; ind += 4) {
+    __m256d v = _mm256_loadu_pd(x + ind);
+    lo = _mm256_min_pd(lo, v);
+    hi = _mm256_max_pd(hi, v);
+  }
+
+  double lanes[8];
+  _mm256_storeu_pd(lanes, lo);
+  _mm256_storeu_pd(lanes + 4, hi);
+
+  double lanes_min, lanes_max, tail_min, tail_max;
+  min_max_doubles_scalar(lanes, 4, &lanes_min, &tail_max);
+  min_max_doubles_scalar(lanes + 4, 4, &tail_min, &lanes_max);
+
+  if (ind < n) {
+    min_max_doubles_scalar(x + ind, n - ind, &tail_min, &tail_max);
+    lanes_min = tail_min < lanes_min ? tail_min : lanes_min;
+    lanes_max = tail_max > lanes_max ? tail_max : lanes_max;
+  }
+  *min = lanes_min;
+  *max = lanes_max;
+}
+
+AVX2 static void add_doubles_avx2(double *out, const double *x,
+                                  const double *y, uint32_t n) {
+  uint32_t ind = 0;
+  for (; ind + 4 <= n; ind += 4) {
+    _mm256_storeu_pd(out + ind, _mm256_add_pd(_mm256_loadu_pd(x + ind),
+                                              _mm256_loadu_pd(y + ind)));
+  }
+  add_doubles_scalar(out + ind, x + ind, y + ind, n - ind);
+}
+
+AVX2 static void multiply_doubles_avx2(double *out, const double *x,
+                                       const double *y, uint32_t n) {
+  uint32_t ind = 0;
+  for (; ind + 4 <= n; ind += 4) {
+    _mm256_storeu_pd(out + ind, _mm256_mul_pd(_mm256_loadu_pd(x + ind),
+                                              _mm256_loadu_pd(y + ind)));
+  }
+  multiply_doubles_scalar(out + ind, x + ind, y + ind, n - ind);
+}
+
+AVX2 static __m256i load_fixnums_avx2(const int64_t *x) {
+  return _mm256_loadu_si256((const __m256i *)x);
+}
+
+AVX2 static __int128 sum_fixnums_avx2(const int64_t *x, uint32_t n) {
+  __int128 sum = 0;
+
+  uint32_t ind = 0;
+  for (; ind + 16 <= n; ind += 16) {
+    __m256i acc = _mm256_add_epi64(load_fixnums_avx2(x + ind),
+                                   load_fixnums_avx2(x + ind + 4));
+    acc = _mm256_add_epi64(acc, load_fixnums_avx2(x + ind + 8));
+    acc = _mm256_add_epi64(acc, load_fixnums_avx2(x + ind + 12));
+
+    int64_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, acc);
+    sum += (__int128)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+  }
+
+  return sum + sum_fixnums_scalar(x + ind, n - ind);
+}
+
+AVX2 static void min_max_fixnums_avx2(const int64_t *x, uint32_t n,
+                                      int64_t *min, int64_t *max) {
+  __m256i lo = _mm256_set1_epi64x(x[0]);
+  __m256i hi = lo;
+
+  uint32_t ind = 0;
+  for (; ind + 4 <= n; ind += 4) {
+    __m256i v = load_fixnums_avx2(x + ind);
+    lo = _mm256_blendv_epi8(lo, v, _mm256_cmpgt_epi64(lo, v));
+    hi = _mm256_blendv_epi8(hi, v, _mm256_cmpgt_epi64(v, hi));
+  }
+
+  int64_t lanes[8];
+  _mm256_storeu_si256((__m256i *)lanes, lo);
+  _mm256_storeu_si256((__m256i *)(lanes + 4), hi);
+
+  int64_t lanes_min, lanes_max, tail_min, tail_max;
+  min_max_fixnums_scalar(lanes, 4, &lanes_min, &tail_max);
+  min_max_fixnums_scalar(lanes + 4, 4, &tail_min, &lanes_max);
+
+  if (ind < n) {
+    min_max_fixnums_scalar(x + ind, n - ind, &tail_min, &tail_max);
+    lanes_min = tail_min < lanes_min ? tail_min : lanes_min;
+    lanes_max = tail_max > lanes_max ? tail_max : lanes_max;
+  }
+  *min = lanes_min;
+  *max = lanes_max;
+}
+
+AVX2 static int add_fixnums_avx2(int64_t *out, const int64_t *x,
+                                 const int64_t *y, uint32_t n) {
+  __m256i bias = _mm256_set1_epi64x(FIXNUM_BIAS);
+  __m256i out_of_range = _mm256_setzero_si256();
+
+  uint32_t ind = 0;
+  for (; ind + 4 <= n; ind += 4) {
+    __m256i sum = _mm256_add_epi64(load_fixnums_avx2(x + ind),
+                                   load_fixnums_avx2(y + ind));
+    _mm256_storeu_si256((__m256i *)(out + ind), sum);
+
+    out_of_range = _mm256_or_si256(
+        out_of_range, _mm256_srli_epi64(_mm256_add_epi64(sum, bias), 62));
+  }
+
+  int overflowed = !_mm256_testz_si256(out_of_range, out_of_range);
+  int tail = add_fixnums_scalar(out + ind, x + ind, y + ind, n - ind);
+
+  return overflowed || tail < 0 ? -1 : 0;
+}
+
+AVX2 static void fill_words_avx2(uint64_t *out, uint32_t n, uint64_t value) {
+  __m256i v = _mm256_set1_epi64x(value);
+
+  uint32_t ind = 0;
+  for (; ind + 4 <= n; ind += 4) {
+    _mm256_storeu_si256((__m256i *)(out + ind), v);
+  }
+  fill_words_scalar(out + ind, n - ind, value);
+}
+
+static const VectorKernels avx2_kernels = {
+    .name = "avx2",
+    .sum_doubles = sum_doubles_avx2,
+    .dot_doubles = dot_doubles_avx2,
+    .min_max_doubles = min_max_doubles_avx2,
+    .add_doubles = add_doubles_avx2,
+    .multiply_doubles = multiply_doubles_avx2,
+    .sum_fixnums = sum_fixnums_avx2,
+    .min_max_fixnums = min_max_fixnums_avx2,
+    .add_fixnums = add_fixnums_avx2,
+    .multiply_fixnums = multiply_fixnums_scalar,
+    .fill_words = fill_words_avx2,
+};
+
+#endif
+
+const VectorKernels *vector_kernels(VectorIsa isa) {
+  switch (isa) {
+  case kIsaScalar:
+    return &scalar_kernels;
+  case kIsaSse2:
+#ifdef HAVE_X86_KERNELS
+    return &sse2_kernels;
+#else
+    return NULL;
+#endif
+  case kIsaAvx2:
+#ifdef HAVE_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+      return &avx2_kernels;
+    }
+#endif
+    return NULL;
+  }
+
+  return NULL;
+}
+
+const VectorKernels *select_vector_kernels(VectorIsa widest) {
+  if (widest >= VECTOR_ISA_COUNT) {
+    widest = VECTOR_ISA_COUNT - 1;
+  }
+
+  for (int isa = widest; isa > kIsaScalar; --isa) {
+    const VectorKernels *kernels = vector_kernels(isa);
+    if (kernels != NULL) {
+      return kernels;
+    }
+  }
+  return &scalar_kernels;
+}
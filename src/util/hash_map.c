@@ -0,0 +1,230 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "util.h"
+
+static int find_slot(HashMap *m, uint32_t item_size, void *key, uint32_t hash,
+                     uint32_t *ind);
+static int resize(HashMap *m, uint32_t item_size, uint32_t cap);
+
+// the hash a slot keeps, kept clear of the empty and removed markers
+static uint32_t slot_hash(HashMap *m, void *key) {
+  uint32_t hash = m->hash_fn(key);
+  return hash <= HASH_MAP_DELETED ? hash + 2 : hash;
+}
+
+static void *slot_item(HashMap *m, uint32_t item_size, uint32_t ind) {
+  return (char *)m->items + ((uint64_t)ind * item_size);
+}
+
+int hash_map_init(HashMap *m, Hasher hash_fn, Comparator cmp_fn) {
+  *m = (HashMap){.hash_fn = hash_fn,
+                 .cmp_fn = cmp_fn,
+                 .size = 0,
+                 .deleted = 0,
+                 .cap = 0,
+                 .hashes = NULL,
+                 .items = NULL};
+  return 0;
+}
+
+int hash_map_clear(HashMap *m) {
+  if (m->hashes != NULL) {
+    free(m->hashes);
+  }
+  return hash_map_init(m, m->hash_fn, m->cmp_fn);
+}
+
+int hash_map_insert(HashMap *m, uint32_t key_size, uint32_t val_size,
+                    void *key, void *value) {
+
+  uint32_t item_size = key_size + val_size;
+  uint32_t hash = slot_hash(m, key);
+
+  uint32_t cur_ind;
+  if (m->cap > 0 && find_slot(m, item_size, key, hash, &cur_ind)) {
+    // replacing a value, don't rewrite the key
+    memmove((char *)slot_item(m, item_size, cur_ind) + key_size, value,
+            val_size);
+    return 0;
+  }
+
+  if (m->cap == 0 || HASH_MAP_OVER_LOAD(m->size + m->deleted + 1, m->cap)) {
+    // only grow if the live entries need it, otherwise just drop the removed
+    uint32_t next_cap = HASH_MAP_OVER_LOAD(m->size + 1, m->cap)
+                            ? NEXT_CAPACITY(m->cap)
+                            : m->cap;
+    if (resize(m, item_size, next_cap) < 0) {
+      return -1;
+    }
+  }
+  find_slot(m, item_size, key, hash, &cur_ind);
+
+  if (m->hashes[cur_ind] == HASH_MAP_DELETED) {
+    --m->deleted;
+  }
+  m->hashes[cur_ind] = hash;
+
+  void *key_target = slot_item(m, item_size, cur_ind);
+  memmove(key_target, key, key_size);
+  memmove((char *)key_target + key_size, value, val_size);
+
+  ++m->size;
+
+  return 0;
+}
+
+int hash_map_remove(HashMap *m, uint32_t key_size, uint32_t val_size,
+                    void *key, void *value) {
+
+  uint32_t item_size = key_size + val_size;
+  uint32_t cur_ind;
+  if (m->cap == 0 ||
+      !find_slot(m, item_size, key, slot_hash(m, key), &cur_ind)) {
+    return -1;
+  }
+
+  if (value != NULL) {
+    memmove(value, (char *)slot_item(m, item_size, cur_ind) + key_size,
+            val_size);
+  }
+
+  // the slot has to stay taken, or anything that probed past it is lost
+  m->hashes[cur_ind] = HASH_MAP_DELETED;
+  --m->size;
+  ++m->deleted;
+
+  return 0;
+}
+
+int hash_map_get(HashMap *m, uint32_t key_size, uint32_t val_size, void *key,
+                 void *value) {
+
+  void *val_target;
+  if (hash_map_ref(m, key_size, val_size, key, &val_target) < 0) {
+    return -1;
+  }
+
+  memmove(value, val_target, val_size);
+
+  return 0;
+}
+
+int hash_map_ref(HashMap *m, uint32_t key_size, uint32_t val_size, void *key,
+                 void **pvalue) {
+
+  uint32_t item_size = key_size + val_size;
+  uint32_t cur_ind;
+  if (m->cap == 0 ||
+      !find_slot(m, item_size, key, slot_hash(m, key), &cur_ind)) {
+    return -1;
+  }
+
+  if (pvalue != NULL) {
+    *pvalue = (char *)slot_item(m, item_size, cur_ind) + key_size;
+  }
+
+  return 0;
+}
+
+int hash_map_foreach(HashMap *m, uint32_t key_size, uint32_t val_size,
+                     MapIterator it_fn, void *arg) {
+
+  uint32_t item_size = key_size + val_size;
+  for (uint32_t ind = 0; ind < m->cap; ++ind) {
+    if (m->hashes[ind] <= HASH_MAP_DELETED) {
+      continue;
+    }
+
+    void *key_target = slot_item(m, item_size, ind);
+    void *val_target = (char *)key_target + key_size;
+
+    int it_res = it_fn(arg, key_target, val_target);
+    if (it_res != 0) {
+      return it_res;
+    }
+  }
+  return 0;
+}
+
+// FNV-1a
+uint64_t hash_bytes(const void *bytes, uint64_t len) {
+  const unsigned char *cur = bytes;
+
+  uint64_t hash = 0xcbf29ce484222325;
+  for (uint64_t ind = 0; ind < len; ++ind) {
+    hash = (hash ^ cur[ind]) * 0x100000001b3;
+  }
+
+  return hash;
+}
+
+// leaves *ind on the key if it's there, otherwise on the first removed or
+// empty slot that it could go in
+static int find_slot(HashMap *m, uint32_t item_size, void *key, uint32_t hash,
+                     uint32_t *ind) {
+
+  uint32_t mask = m->cap - 1;
+  uint32_t cur_ind = hash & mask;
+  int have_deleted = 0;
+
+  while (m->hashes[cur_ind] != HASH_MAP_EMPTY) {
+    if (m->hashes[cur_ind] == HASH_MAP_DELETED) {
+      if (!have_deleted) {
+        have_deleted = 1;
+        *ind = cur_ind;
+      }
+    } else if (m->hashes[cur_ind] == hash &&
+               m->cmp_fn(key, slot_item(m, item_size, cur_ind)) == 0) {
+      *ind = cur_ind;
+      return 1;
+    }
+
+    cur_ind = (cur_ind + 1) & mask;
+  }
+
+  if (!have_deleted) {
+    *ind = cur_ind;
+  }
+  return 0;
+}
+
+// the capacity is always a power of two, so probing can wrap with a mask
+static int resize(HashMap *m, uint32_t item_size, uint32_t cap) {
+  uint64_t bytes = (uint64_t)cap * (sizeof(uint32_t) + item_size);
+  uint32_t *hashes = calloc(1, bytes);
+  if (hashes == NULL) {
+    return -1;
+  }
+
+  HashMap old = *m;
+  m->hashes = hashes;
+  m->items = hashes + cap;
+  m->cap = cap;
+  m->deleted = 0;
+
+  uint32_t mask = cap - 1;
+  for (uint32_t ind = 0; ind < old.cap; ++ind) {
+    if (old.hashes[ind] <= HASH_MAP_DELETED) {
+      continue;
+    }
+
+    // every key is already known to be different, so only an empty slot will
+    // do
+    uint32_t new_ind = old.hashes[ind] & mask;
+    while (hashes[new_ind] != HASH_MAP_EMPTY) {
+      new_ind = (new_ind + 1) & mask;
+    }
+
+    hashes[new_ind] = old.hashes[ind];
+    memmove(slot_item(m, item_size, new_ind),
+            slot_item(&old, item_size, ind), item_size);
+  }
+
+  if (old.hashes != NULL) {
+    free(old.hashes);
+  }
+
+  return 0;
+}
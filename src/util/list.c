@@ -18,17 +18,30 @@ int list_clear(List *l) {
   return 0;
 }
 
-int list_push(List *l, uint32_t size, void *item) {
-  if (l->size + 1 > l->cap) {
-    uint32_t next_cap = NEXT_CAPACITY(l->cap);
-    void *res = realloc(l->items, (size * next_cap));
-    if (res == NULL) {
-      // realloc failed
-      return -1;
-    }
+int grow_items(void **items, uint32_t *cap, uint32_t size, uint32_t needed) {
+  if (needed <= *cap) {
+    return 0;
+  }
+
+  uint32_t next_cap = *cap;
+  do {
+    next_cap = NEXT_CAPACITY(next_cap);
+  } while (needed > next_cap);
 
-    l->items = res;
-    l->cap = next_cap;
+  void *res = realloc(*items, ((uint64_t)size * next_cap));
+  if (res == NULL) {
+    // realloc failed
+    return -1;
+  }
+
+  *items = res;
+  *cap = next_cap;
+  return 0;
+}
+
+int list_push(List *l, uint32_t size, void *item) {
+  if (grow_items(&l->items, &l->cap, size, l->size + 1) < 0) {
+    return -1;
   }
 
   void *target = (char *)l->items + (l->size * size);
@@ -44,19 +57,8 @@ int list_append(List *l, uint32_t size, List *other) {
     return 0;
   }
 
-  if (l->size + other->size > l->cap) {
-    uint32_t next_cap = l->cap;
-    do {
-      next_cap = NEXT_CAPACITY(next_cap);
-    } while (l->size + other->size > next_cap);
-
-    void *res = realloc(l->items, (size * next_cap));
-    if (res == NULL) {
-      return -1;
-    }
-
-    l->items = res;
-    l->cap = next_cap;
+  if (grow_items(&l->items, &l->cap, size, l->size + other->size) < 0) {
+    return -1;
   }
 
   void *target = (char *)l->items + (l->size * size);
@@ -4,8 +4,6 @@
 
 #include "util.h"
 
-uint32_t n;
-
 static int find_item(OrderedMap *m, uint32_t item_size, void *key,
                      uint32_t *ind);
 
@@ -141,25 +139,27 @@ int map_foreach(OrderedMap *m, uint32_t key_size, uint32_t val_size,
   return 0;
 }
 
+// binary search, leaving *ind where the key is, or where it would go
 static int find_item(OrderedMap *m, uint32_t item_size, void *key,
                      uint32_t *ind) {
 
-  int found_item = 0;
-  uint32_t cur_ind = 0;
-  while (cur_ind < m->size) {
-    void *item = (char *)m->items + (cur_ind * item_size);
+  uint32_t low = 0;
+  uint32_t high = m->size;
+  while (low < high) {
+    uint32_t mid = low + (high - low) / 2;
+    void *item = (char *)m->items + (mid * item_size);
 
     int cmp = m->cmp_fn(key, item);
     if (cmp == 0) {
-      found_item = 1;
-      break;
+      *ind = mid;
+      return 1;
     } else if (cmp < 0) {
-      break;
+      high = mid;
+    } else {
+      low = mid + 1;
     }
-
-    ++cur_ind;
   }
 
-  *ind = cur_ind;
-  return found_item;
+  *ind = low;
+  return 0;
 }
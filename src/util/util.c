@@ -1,14 +1,57 @@
+#include <stdlib.h>
 #include <string.h>
 
 #include "util.h"
 
+// moves count items one place up, starting from the first of them, or one
+// place down, starting from the last of them
 void shift_items(void *items, uint32_t size, uint32_t count, int direction) {
-  while (count > 0) {
-    void *target = ((char *)items) + (direction * ((int)((count - 1) * size)));
-    void *dest = ((char *)target) + (direction * ((int)size));
+  if (count == 0) {
+    return;
+  }
 
-    memmove(dest, target, size);
+  char *first = items;
+  if (direction < 0) {
+    first -= (uint64_t)(count - 1) * size;
+  }
 
-    --count;
+  memmove(first + direction * (int64_t)size, first, (uint64_t)count * size);
+}
+
+// parses a size like "512", "64K", "256M" or "2G" into a number of bytes
+int parse_byte_size(const char *str, uint64_t *result) {
+  char *end;
+  unsigned long long value = strtoull(str, &end, 10);
+  if (end == str) {
+    return -1;
   }
+
+  switch (*end) {
+  case '\0':
+    break;
+  case 'k':
+  case 'K':
+    value <<= 10;
+    ++end;
+    break;
+  case 'm':
+  case 'M':
+    value <<= 20;
+    ++end;
+    break;
+  case 'g':
+  case 'G':
+    value <<= 30;
+    ++end;
+    break;
+  default:
+    return -1;
+  }
+
+  if (*end != '\0') {
+    return -1;
+  }
+
+  *result = value;
+  return 0;
 }
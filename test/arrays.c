@@ -0,0 +1,338 @@
+#include <stdint.h>
+
+#include "runtime.h"
+#include "runtime/arrays.h"
+#include "runtime/memory_manager.h"
+#include "runtime/numbers.h"
+#include "runtime/types.h"
+#include "test.h"
+
+// Vectors of every element type through make_vector, vector_ref and
+// vector_set, bit vectors at lengths either side of a word, the lengths that
+// are too big to allocate, and fill and replace over part of a vector. A
+// simple vector of forms is the only kind the collector looks inside, so it
+// gets stores through the write barrier too.
+
+// enough garbage conses to go through the nursery several times over
+#define CHURN_CONSES (1 << 18)
+#define BARRIER_LENGTH 1000
+
+static Runtime *rt;
+static LishpSymbol *root_sym;
+
+static LishpCons *cons(LishpForm car, LishpForm cdr) {
+  LishpCons *result = ALLOCATE_OBJ(LishpCons, rt);
+  *result = CONS(car, cdr);
+  return result;
+}
+
+static void churn() {
+  for (uint32_t ind = 0; ind < CHURN_CONSES; ++ind) {
+    cons(FROM_FIXNUM(-1), NIL);
+  }
+}
+
+static void set_root(LishpForm form) {
+  Package *user = find_package(rt, "USER");
+  bind_value(rt, user->global, root_sym, form);
+}
+
+// double-floats may be boxed, so they are compared by value
+static int same_element(ObjectType type, LishpForm l, LishpForm r) {
+  if (type == kDoubleFloatVector) {
+    return as_double(l) == as_double(r);
+  }
+  return l.bits == r.bits;
+}
+
+// every element starts out as initial, and setting the last one leaves the
+// rest alone
+static void check_elements(ObjectType type, LishpForm initial,
+                           LishpForm value) {
+  LishpObject *vector = make_vector(rt, type, 10, initial);
+  if (vector == NULL || vector->type != type || vector_length(vector) != 10) {
+    CHECK(0, "a %s of 10 wasn't made", object_type_name(type));
+    return;
+  }
+
+  uint32_t wrong = 0;
+  for (uint32_t ind = 0; ind < 10; ++ind) {
+    wrong += !same_element(type, vector_ref(rt, vector, ind), initial);
+  }
+  CHECK(wrong == 0, "%u elements of a %s didn't start out as initial", wrong,
+        object_type_name(type));
+
+  vector_set(rt, vector, 9, value);
+  CHECK(same_element(type, vector_ref(rt, vector, 9), value) &&
+            same_element(type, vector_ref(rt, vector, 8), initial),
+        "setting the last element of a %s didn't stick, or spilled",
+        object_type_name(type));
+}
+
+static void element_tests() {
+  check_elements(kSimpleVector, NIL, FROM_FIXNUM(-3));
+  check_elements(kFixnumVector, FROM_FIXNUM(MOST_NEGATIVE_FIXNUM),
+                 FROM_FIXNUM(MOST_POSITIVE_FIXNUM));
+  check_elements(kDoubleFloatVector, make_double(rt, 1e300),
+                 make_double(rt, -0.5));
+  check_elements(kCharacterVector, FROM_CHAR('a'), FROM_CHAR('z'));
+
+  LishpObject *empty = make_vector(rt, kFixnumVector, 0, FROM_FIXNUM(0));
+  CHECK(empty != NULL && vector_length(empty) == 0,
+        "an empty vector wasn't made");
+}
+
+// lengths that leave the last word partly used, or fill it exactly
+static void bit_vector_tests() {
+  static const uint32_t lengths[] = {1, 63, 64, 65, 127, 130};
+
+  for (uint32_t ind = 0; ind < sizeof(lengths) / sizeof(lengths[0]); ++ind) {
+    uint32_t length = lengths[ind];
+    LishpObject *bits = make_vector(rt, kBitVector, length, FROM_FIXNUM(1));
+    if (bits == NULL) {
+      CHECK(0, "a bit vector of %u wasn't made", length);
+      continue;
+    }
+
+    uint32_t wrong = 0;
+    for (uint32_t bit = 0; bit < length; ++bit) {
+      wrong += AS_FIXNUM(vector_ref(rt, bits, bit)) != 1;
+    }
+    CHECK(wrong == 0, "%u of %u bits didn't start out set", wrong, length);
+
+    // every third one cleared, which lands on both sides of each word
+    for (uint32_t bit = 0; bit < length; bit += 3) {
+      vector_set(rt, bits, bit, FROM_FIXNUM(0));
+    }
+    vector_set(rt, bits, length - 1, FROM_FIXNUM(0));
+
+    wrong = 0;
+    for (uint32_t bit = 0; bit < length; ++bit) {
+      int64_t expected = bit % 3 != 0 && bit != length - 1;
+      wrong += AS_FIXNUM(vector_ref(rt, bits, bit)) != expected;
+    }
+    CHECK(wrong == 0, "%u of %u bits were wrong after clearing some", wrong,
+          length);
+  }
+}
+
+// the header counts too, so the lengths that fit in 32 bits can still be
+// too big, which has to come back as NULL before anything is allocated
+static void too_big_tests() {
+  uint32_t header = sizeof(LishpCharacterVector);
+  CHECK(make_vector(rt, kCharacterVector, UINT32_MAX, FROM_CHAR('a')) == NULL,
+        "a character vector of UINT32_MAX was made");
+  CHECK(make_vector(rt, kCharacterVector, MAX_ALLOCATION_SIZE - header + 1,
+                    FROM_CHAR('a')) == NULL,
+        "a character vector one byte too big was made");
+  CHECK(make_vector(rt, kSimpleVector, UINT32_MAX / 8, NIL) == NULL,
+        "a simple vector of UINT32_MAX / 8 was made");
+  CHECK(make_vector(rt, kDoubleFloatVector, UINT32_MAX,
+                    make_double(rt, 0.0)) == NULL,
+        "a double-float vector of UINT32_MAX was made");
+}
+
+// fills that start and stop part way through a word of bits, and part way
+// through a register of fixnums or doubles
+static void fill_tests() {
+  static const uint32_t lengths[] = {1, 17, 64, 130};
+
+  for (uint32_t ind = 0; ind < sizeof(lengths) / sizeof(lengths[0]); ++ind) {
+    uint32_t length = lengths[ind];
+    uint32_t start = length / 3;
+    uint32_t end = length - length / 5;
+
+    LishpObject *bits = make_vector(rt, kBitVector, length, FROM_FIXNUM(0));
+    LishpObject *fixnums =
+        make_vector(rt, kFixnumVector, length, FROM_FIXNUM(-1));
+    LishpObject *doubles =
+        make_vector(rt, kDoubleFloatVector, length, make_double(rt, -1.0));
+    if (bits == NULL || fixnums == NULL || doubles == NULL) {
+      CHECK(0, "vectors of %u to fill weren't made", length);
+      continue;
+    }
+
+    vector_fill(rt, bits, FROM_FIXNUM(1), start, end);
+    vector_fill(rt, fixnums, FROM_FIXNUM(MOST_POSITIVE_FIXNUM), start, end);
+    vector_fill(rt, doubles, make_double(rt, 0.25), start, end);
+
+    uint32_t wrong = 0;
+    for (uint32_t elem = 0; elem < length; ++elem) {
+      int filled = start <= elem && elem < end;
+      wrong += AS_FIXNUM(vector_ref(rt, bits, elem)) != filled;
+      wrong += AS_FIXNUM(vector_ref(rt, fixnums, elem)) !=
+               (filled ? MOST_POSITIVE_FIXNUM : -1);
+      wrong +=
+          as_double(vector_ref(rt, doubles, elem)) != (filled ? 0.25 : -1.0);
+    }
+    CHECK(wrong == 0, "filling %u to %u of %u got %u elements wrong", start,
+          end, length, wrong);
+  }
+}
+
+// each element is its index, so a copy that reads what it already wrote
+// shows up as a run of the same value
+static LishpObject *make_counting(ObjectType type, uint32_t length) {
+  LishpObject *vector = make_vector(rt, type, length, FROM_FIXNUM(0));
+  if (vector != NULL && type != kBitVector) {
+    for (uint32_t ind = 0; ind < length; ++ind) {
+      vector_set(rt, vector, ind, FROM_FIXNUM(ind));
+    }
+  }
+  return vector;
+}
+
+// the element at ind after copying count from source_start to target_start,
+// within a vector where each element was its index
+static int64_t after_replace(uint32_t ind, uint32_t target_start,
+                             uint32_t source_start, uint32_t count) {
+  if (target_start <= ind && ind < target_start + count) {
+    return ind - target_start + source_start;
+  }
+  return ind;
+}
+
+// overlapping copies within one vector, both ways. a fixnum vector goes
+// through the memmove, and a bit vector an element at a time, which has to
+// go backwards when copying up
+static void overlapping_replace_tests() {
+  static const struct {
+    uint32_t target_start;
+    uint32_t source_start;
+  } copies[] = {{5, 2}, {2, 5}, {1, 0}, {0, 1}};
+
+  for (uint32_t ind = 0; ind < sizeof(copies) / sizeof(copies[0]); ++ind) {
+    uint32_t target_start = copies[ind].target_start;
+    uint32_t source_start = copies[ind].source_start;
+    uint32_t count = 60;
+
+    LishpObject *fixnums = make_counting(kFixnumVector, 70);
+    LishpObject *simple = make_counting(kSimpleVector, 70);
+    // alternating runs of ones and zeros, of lengths 1, 2, 3 and so on
+    LishpObject *bits = make_vector(rt, kBitVector, 70, FROM_FIXNUM(0));
+    if (fixnums == NULL || simple == NULL || bits == NULL) {
+      CHECK(0, "vectors to replace within weren't made");
+      return;
+    }
+    int64_t pattern[70];
+    for (uint32_t elem = 0, run = 1, left = 1; elem < 70; ++elem) {
+      pattern[elem] = run % 2;
+      vector_set(rt, bits, elem, FROM_FIXNUM(pattern[elem]));
+      if (--left == 0) {
+        left = ++run;
+      }
+    }
+
+    vector_replace(rt, fixnums, target_start, fixnums, source_start, count);
+    vector_replace(rt, simple, target_start, simple, source_start, count);
+    vector_replace(rt, bits, target_start, bits, source_start, count);
+
+    uint32_t wrong = 0;
+    for (uint32_t elem = 0; elem < 70; ++elem) {
+      int64_t from = after_replace(elem, target_start, source_start, count);
+      wrong += AS_FIXNUM(vector_ref(rt, fixnums, elem)) != from;
+      wrong += AS_FIXNUM(vector_ref(rt, simple, elem)) != from;
+      wrong += AS_FIXNUM(vector_ref(rt, bits, elem)) != pattern[from];
+    }
+    CHECK(wrong == 0, "replacing %u from %u within a vector got %u wrong",
+          target_start, source_start, wrong);
+  }
+
+  // between different element types, which also goes an element at a time
+  LishpObject *fixnums = make_counting(kFixnumVector, 10);
+  LishpObject *simple = make_vector(rt, kSimpleVector, 10, NIL);
+  if (fixnums == NULL || simple == NULL) {
+    CHECK(0, "vectors to replace between weren't made");
+    return;
+  }
+  vector_replace(rt, simple, 3, fixnums, 1, 5);
+  uint32_t wrong = 0;
+  for (uint32_t elem = 0; elem < 10; ++elem) {
+    LishpForm value = vector_ref(rt, simple, elem);
+    wrong += elem >= 3 && elem < 8 ? !FIXNUM_P(value) ||
+                                         AS_FIXNUM(value) != elem - 2
+                                   : !NIL_P(value);
+  }
+  CHECK(wrong == 0, "replacing fixnums into a simple vector got %u wrong",
+        wrong);
+}
+
+// young conses stored into a promoted simple vector are only reachable
+// through the remembered set once a minor collection comes around
+static void barrier_tests() {
+  LishpObject *vector = make_vector(rt, kSimpleVector, BARRIER_LENGTH, NIL);
+  if (vector == NULL) {
+    CHECK(0, "barrier: the vector wasn't made");
+    return;
+  }
+  set_root(FROM_OBJ(vector));
+
+  // which promotes the vector
+  churn();
+
+  for (uint32_t ind = 0; ind < BARRIER_LENGTH; ++ind) {
+    vector_set(rt, vector, ind, FROM_OBJ(cons(FROM_FIXNUM(ind), NIL)));
+  }
+
+  churn();
+
+  uint32_t wrong = 0;
+  for (uint32_t ind = 0; ind < BARRIER_LENGTH; ++ind) {
+    LishpForm elt = vector_ref(rt, vector, ind);
+    wrong += !IS_OBJECT_TYPE(elt, kCons) ||
+             AS_OBJECT(LishpCons, elt)->car.bits != FROM_FIXNUM(ind).bits;
+  }
+  CHECK(wrong == 0, "barrier: %u conses stored into an old vector were lost",
+        wrong);
+
+  // and again through replace, from a young vector that is dropped straight
+  // after, so that only the old one holds on to what was copied. nothing
+  // refers to the young one while it is filled, so the collector waits
+  pause_gc(rt->memory_manager);
+  LishpObject *source = make_vector(rt, kSimpleVector, BARRIER_LENGTH, NIL);
+  if (source == NULL) {
+    CHECK(0, "barrier: the vector to replace from wasn't made");
+    resume_gc(rt->memory_manager);
+    set_root(NIL);
+    return;
+  }
+  for (uint32_t ind = 0; ind < BARRIER_LENGTH; ++ind) {
+    AS(LishpSimpleVector, source)->elements[ind] =
+        FROM_OBJ(cons(FROM_FIXNUM(-(int64_t)ind), NIL));
+  }
+  vector_replace(rt, vector, 0, source, 0, BARRIER_LENGTH);
+  source = NULL;
+  resume_gc(rt->memory_manager);
+
+  churn();
+
+  wrong = 0;
+  for (uint32_t ind = 0; ind < BARRIER_LENGTH; ++ind) {
+    LishpForm elt = vector_ref(rt, vector, ind);
+    wrong += !IS_OBJECT_TYPE(elt, kCons) ||
+             AS_OBJECT(LishpCons, elt)->car.bits !=
+                 FROM_FIXNUM(-(int64_t)ind).bits;
+  }
+  CHECK(wrong == 0, "barrier: %u conses replaced into an old vector were lost",
+        wrong);
+
+  set_root(NIL);
+}
+
+void run_array_tests(Runtime *runtime) {
+  rt = runtime;
+
+  Package *user = find_package(rt, "USER");
+  root_sym = intern_symbol(rt, user, "*ARRAY-TESTS*");
+
+  // the vectors made here are only held on to by the C stack
+  pause_gc(rt->memory_manager);
+  element_tests();
+  bit_vector_tests();
+  too_big_tests();
+  fill_tests();
+  overlapping_replace_tests();
+  resume_gc(rt->memory_manager);
+
+  barrier_tests();
+}
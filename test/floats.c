@@ -0,0 +1,185 @@
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+#include "runtime.h"
+#include "runtime/memory_manager.h"
+#include "runtime/numbers.h"
+#include "runtime/types.h"
+#include "test.h"
+
+// Double-floats have to come back out of a form with exactly the bits they
+// went in with, whether they were packed into an immediate or boxed. The
+// immediates hold the exponents from 2^-127 up to 2^128, apart from 2^-127
+// itself, whose rebased bits would collide with the zeros, so these go right
+// up to the edges on both sides, and through zeros, denormals, infinities and
+// NaNs, which are always boxed. Nothing here is reachable by the collector,
+// so it is paused throughout.
+
+static Runtime *rt;
+
+static uint64_t double_bits(double value) {
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(double));
+  return bits;
+}
+
+static double bits_double(uint64_t bits) {
+  double value;
+  memcpy(&value, &bits, sizeof(double));
+  return value;
+}
+
+// makes a form of value, which has to be an immediate or not as asked, and
+// read back as the same bits
+static void check_round_trip(double value, int immediate) {
+  LishpForm form = make_double(rt, value);
+
+  CHECK(IMMEDIATE_FLOAT_P(form) == immediate, "%a should %sbe an immediate",
+        value, immediate ? "" : "not ");
+  CHECK(immediate || IS_OBJECT_TYPE(form, kDoubleFloat),
+        "%a is neither an immediate nor boxed", value);
+  CHECK(DOUBLE_FLOAT_P(form), "%a isn't a double-float", value);
+  CHECK(double_bits(as_double(form)) == double_bits(value),
+        "%a came back as %a", value, as_double(form));
+}
+
+// both signs, since the sign ends up at the bottom of an immediate
+static void check_both_signs(double value, int immediate) {
+  check_round_trip(value, immediate);
+  check_round_trip(-value, immediate);
+}
+
+static void edge_tests() {
+  check_round_trip(0.0, 1);
+  check_round_trip(-0.0, 1);
+  CHECK(signbit(as_double(make_double(rt, -0.0))), "-0.0 lost its sign");
+
+  check_both_signs(1.0, 1);
+  check_both_signs(0.1, 1);
+  check_both_signs(3.141592653589793, 1);
+  // 2^-127 is about 5.88e-39, and 2^129 about 6.81e38
+  check_both_signs(5.8e-39, 0);
+  check_both_signs(6e-39, 1);
+  check_both_signs(6.8e38, 1);
+  check_both_signs(7e38, 0);
+
+  // the bottom of the range
+  double bottom = 0x1p-127;
+  check_both_signs(bottom, 0);
+  check_both_signs(nextafter(bottom, 1), 1);
+  check_both_signs(nextafter(bottom, 0), 0);
+  check_both_signs(0x1p-126, 1);
+  check_both_signs(FLT_MIN, 1);
+
+  // and the top
+  double top = 0x1p129;
+  check_both_signs(nextafter(top, 0), 1);
+  check_both_signs(0x1p128, 1);
+  check_both_signs(FLT_MAX, 1);
+  check_both_signs(top, 0);
+  check_both_signs(nextafter(top, INFINITY), 0);
+
+  check_both_signs(DBL_MIN, 0);
+  check_both_signs(DBL_MAX, 0);
+  check_both_signs(DBL_TRUE_MIN, 0);
+  check_both_signs(1e-310, 0);
+  check_both_signs(nextafter(DBL_MIN, 0), 0);
+  check_both_signs(INFINITY, 0);
+}
+
+static void nan_tests() {
+  // a quiet NaN, one with a payload, and a signalling one
+  static const uint64_t nans[] = {0x7ff8000000000000, 0x7ff8000000012345,
+                                  0x7ff0000000000001, 0xfff8000000000000};
+
+  for (uint32_t ind = 0; ind < sizeof(nans) / sizeof(nans[0]); ++ind) {
+    double value = bits_double(nans[ind]);
+    LishpForm form = make_double(rt, value);
+
+    CHECK(!IMMEDIATE_FLOAT_P(form), "NaN %lx is an immediate",
+          (unsigned long)nans[ind]);
+    CHECK(double_bits(as_double(form)) == nans[ind],
+          "NaN %lx came back as %lx", (unsigned long)nans[ind],
+          (unsigned long)double_bits(as_double(form)));
+  }
+}
+
+// every exponent, each with a few mantissas, against where the immediates
+// should stop
+static void exponent_sweep_tests() {
+  static const uint64_t mantissas[] = {0, 1, 0x8000000000000,
+                                       0xfffffffffffff};
+
+  for (uint64_t exponent = 0; exponent < 0x7ff; ++exponent) {
+    for (uint32_t ind = 0; ind < sizeof(mantissas) / sizeof(mantissas[0]);
+         ++ind) {
+      uint64_t bits = (exponent << 52) | mantissas[ind];
+      double value = bits_double(bits);
+
+      int in_range = exponent >= 1023 - 127 && exponent <= 1023 + 128;
+      int immediate = value == 0 || (in_range && !(exponent == 1023 - 127 &&
+                                                   mantissas[ind] == 0));
+      check_both_signs(value, immediate);
+    }
+  }
+}
+
+// arithmetic that crosses from immediates to boxed doubles and back
+static void arithmetic_tests() {
+  LishpForm top = make_double(rt, 0x1p128);
+  LishpForm sum = number_add(rt, top, top);
+  CHECK(!IMMEDIATE_FLOAT_P(sum) && as_double(sum) == 0x1p129,
+        "2^128 + 2^128 is %a", as_double(sum));
+
+  LishpForm half = number_divide(rt, sum, make_double(rt, 2.0));
+  CHECK(IMMEDIATE_FLOAT_P(half) && as_double(half) == 0x1p128,
+        "2^129 / 2 is %a", as_double(half));
+
+  LishpForm tiny = number_multiply(rt, make_double(rt, 0x1p-126),
+                                   make_double(rt, 0x1p-2));
+  CHECK(!IMMEDIATE_FLOAT_P(tiny) && as_double(tiny) == 0x1p-128,
+        "2^-126 * 2^-2 is %a", as_double(tiny));
+
+  LishpForm zero = number_subtract(rt, top, top);
+  CHECK(IMMEDIATE_FLOAT_P(zero) && as_double(zero) == 0 &&
+            !signbit(as_double(zero)),
+        "2^128 - 2^128 is %a", as_double(zero));
+
+  LishpForm mixed = number_add(rt, FROM_FIXNUM(1), make_double(rt, 0.5));
+  CHECK(DOUBLE_FLOAT_P(mixed) && as_double(mixed) == 1.5, "1 + 0.5 is %a",
+        as_double(mixed));
+
+  LishpForm quotient =
+      number_floor(rt, make_double(rt, -7.5), make_double(rt, 2.0));
+  CHECK(FIXNUM_P(quotient) && AS_FIXNUM(quotient) == -4,
+        "(floor -7.5 2.0) isn't -4");
+  LishpForm remainder = number_mod(rt, make_double(rt, -7.5), FROM_FIXNUM(2));
+  CHECK(DOUBLE_FLOAT_P(remainder) && as_double(remainder) == 0.5,
+        "(mod -7.5 2) is %a", as_double(remainder));
+}
+
+// what the division built-ins turn away before dividing
+static void zero_tests() {
+  CHECK(number_zerop(FROM_FIXNUM(0)), "0 isn't zero");
+  CHECK(number_zerop(make_double(rt, 0.0)), "0.0 isn't zero");
+  CHECK(number_zerop(make_double(rt, -0.0)), "-0.0 isn't zero");
+  CHECK(!number_zerop(make_double(rt, DBL_TRUE_MIN)),
+        "the smallest denormal is zero");
+  CHECK(!number_zerop(FROM_FIXNUM(-1)), "-1 is zero");
+  CHECK(!number_zerop(integer_add(rt, FROM_FIXNUM(MOST_POSITIVE_FIXNUM),
+                                  FROM_FIXNUM(1))),
+        "a bignum is zero");
+}
+
+void run_float_tests(Runtime *runtime) {
+  rt = runtime;
+
+  pause_gc(rt->memory_manager);
+  edge_tests();
+  nan_tests();
+  exponent_sweep_tests();
+  arithmetic_tests();
+  zero_tests();
+  resume_gc(rt->memory_manager);
+}
@@ -0,0 +1,253 @@
+#include <stdlib.h>
+
+#include "runtime.h"
+#include "runtime/arrays.h"
+#include "runtime/hash_tables.h"
+#include "runtime/memory_manager.h"
+#include "runtime/numbers.h"
+#include "runtime/types.h"
+#include "test.h"
+
+// gethash, puthash and remhash under each test, with keys that are the same
+// object, keys that are only EQL or EQUAL to what was put in, and keys that
+// mustn't match. Most of it holds objects the collector can't see, so it runs
+// with the collector paused. Then a table keyed by conses, which are hashed
+// by address, is compacted out from under itself, with everything it needs
+// kept alive through a global, and every key has to be found where it moved
+// to.
+
+#define GROWN_KEYS 1000
+#define MOVED_KEYS 2000
+
+static Runtime *rt;
+
+static LishpForm cons(LishpForm car, LishpForm cdr) {
+  LishpCons *result = ALLOCATE_OBJ(LishpCons, rt);
+  *result = CONS(car, cdr);
+  return FROM_OBJ(result);
+}
+
+static LishpForm string(const char *text) {
+  LishpString *result = ALLOCATE_OBJ(LishpString, rt);
+  *result = STRING(allocate_str(rt, text));
+  return FROM_OBJ(result);
+}
+
+static LishpForm list3(LishpForm a, LishpForm b, LishpForm c) {
+  return cons(a, cons(b, cons(c, NIL)));
+}
+
+// whether key is there with the fixnum value expected
+static int has_p(LishpHashTable *table, LishpForm key, int64_t expected) {
+  LishpForm value = NIL;
+  return hash_table_get(rt, table, key, &value) && FIXNUM_P(value) &&
+         AS_FIXNUM(value) == expected;
+}
+
+static int missing_p(LishpHashTable *table, LishpForm key) {
+  LishpForm value;
+  return !hash_table_get(rt, table, key, &value);
+}
+
+static void eq_tests() {
+  LishpHashTable *table = make_hash_table(rt, kTestEq, 0);
+  LishpForm key = cons(FROM_FIXNUM(1), NIL);
+  LishpForm same_contents = cons(FROM_FIXNUM(1), NIL);
+  Package *user = find_package(rt, "USER");
+  LishpForm sym = FROM_OBJ(intern_symbol(rt, user, "HASH-TABLE-KEY"));
+
+  hash_table_put(rt, table, key, FROM_FIXNUM(10));
+  hash_table_put(rt, table, sym, FROM_FIXNUM(20));
+  hash_table_put(rt, table, FROM_FIXNUM(7), FROM_FIXNUM(30));
+
+  CHECK(has_p(table, key, 10), "EQ: the cons key isn't there");
+  CHECK(missing_p(table, same_contents), "EQ: found an EQUAL cons");
+  CHECK(has_p(table, FROM_OBJ(intern_symbol(rt, user, "HASH-TABLE-KEY")), 20),
+        "EQ: the symbol interned again isn't there");
+  CHECK(has_p(table, FROM_FIXNUM(7), 30), "EQ: the fixnum key isn't there");
+  CHECK(table->count == 3, "EQ: count is %u", table->count);
+
+  hash_table_put(rt, table, key, FROM_FIXNUM(11));
+  CHECK(has_p(table, key, 11), "EQ: replacing didn't take");
+  CHECK(table->count == 3, "EQ: replacing changed the count to %u",
+        table->count);
+
+  CHECK(hash_table_remove(rt, table, key), "EQ: removing the cons failed");
+  CHECK(!hash_table_remove(rt, table, key), "EQ: removed the cons twice");
+  CHECK(!hash_table_remove(rt, table, same_contents),
+        "EQ: removed an EQUAL cons");
+  CHECK(missing_p(table, key), "EQ: the removed cons is still there");
+  CHECK(has_p(table, sym, 20) && has_p(table, FROM_FIXNUM(7), 30),
+        "EQ: removing lost another key");
+  CHECK(table->count == 2, "EQ: count after removing is %u", table->count);
+}
+
+static void eql_tests() {
+  LishpHashTable *table = make_hash_table(rt, kTestEql, 0);
+  const char *big_text = "123456789012345678901234567890";
+  LishpForm big = parse_integer(rt, big_text, 30);
+
+  hash_table_put(rt, table, big, FROM_FIXNUM(1));
+  hash_table_put(rt, table, make_double(rt, 1.5), FROM_FIXNUM(2));
+  hash_table_put(rt, table, make_double(rt, 1e300), FROM_FIXNUM(3));
+  hash_table_put(rt, table, FROM_CHAR('a'), FROM_FIXNUM(4));
+  hash_table_put(rt, table, FROM_FIXNUM(1), FROM_FIXNUM(5));
+
+  CHECK(has_p(table, parse_integer(rt, big_text, 30), 1),
+        "EQL: an equal bignum isn't there");
+  CHECK(has_p(table, make_double(rt, 1.5), 2),
+        "EQL: an equal immediate double isn't there");
+  CHECK(has_p(table, make_double(rt, 1e300), 3),
+        "EQL: an equal boxed double isn't there");
+  CHECK(has_p(table, FROM_CHAR('a'), 4), "EQL: the character isn't there");
+  CHECK(missing_p(table, make_double(rt, 1.0)),
+        "EQL: 1.0 found the fixnum 1");
+  CHECK(missing_p(table, make_double(rt, -1.5)), "EQL: -1.5 found 1.5");
+  CHECK(missing_p(table, integer_negate(rt, big)),
+        "EQL: the negated bignum was found");
+  CHECK(missing_p(table, cons(FROM_FIXNUM(1), NIL)), "EQL: found a cons");
+
+  CHECK(hash_table_remove(rt, table, parse_integer(rt, big_text, 30)),
+        "EQL: removing an equal bignum failed");
+  CHECK(missing_p(table, big), "EQL: the removed bignum is still there");
+  CHECK(table->count == 4, "EQL: count is %u", table->count);
+}
+
+static void equal_tests() {
+  LishpHashTable *table = make_hash_table(rt, kTestEqual, 0);
+
+  hash_table_put(rt, table, string("hello"), FROM_FIXNUM(1));
+  hash_table_put(rt, table,
+                 list3(FROM_FIXNUM(1), string("two"), make_double(rt, 3.0)),
+                 FROM_FIXNUM(2));
+  hash_table_put(rt, table, cons(FROM_FIXNUM(1), FROM_FIXNUM(2)),
+                 FROM_FIXNUM(3));
+
+  CHECK(has_p(table, string("hello"), 1), "EQUAL: an equal string isn't there");
+  CHECK(missing_p(table, string("Hello")), "EQUAL: found a different string");
+  CHECK(has_p(table,
+              list3(FROM_FIXNUM(1), string("two"), make_double(rt, 3.0)), 2),
+        "EQUAL: an equal list isn't there");
+  CHECK(missing_p(table, list3(FROM_FIXNUM(1), string("two"),
+                               make_double(rt, 4.0))),
+        "EQUAL: found a list with a different element");
+  CHECK(missing_p(table, cons(FROM_FIXNUM(1), cons(string("two"), NIL))),
+        "EQUAL: found a shorter list");
+  CHECK(has_p(table, cons(FROM_FIXNUM(1), FROM_FIXNUM(2)), 3),
+        "EQUAL: an equal dotted pair isn't there");
+
+  hash_table_put(rt, table, string("hello"), FROM_FIXNUM(4));
+  CHECK(has_p(table, string("hello"), 4), "EQUAL: replacing didn't take");
+  CHECK(table->count == 3, "EQUAL: count is %u", table->count);
+
+  CHECK(hash_table_remove(rt, table, string("hello")),
+        "EQUAL: removing an equal string failed");
+  CHECK(missing_p(table, string("hello")),
+        "EQUAL: the removed string is still there");
+  CHECK(table->count == 2, "EQUAL: count after removing is %u",
+        table->count);
+}
+
+// enough keys to grow a table from nothing several times, with half of them
+// removed, which leaves markers the keys after them have to probe past
+static void grow_tests() {
+  LishpHashTable *table = make_hash_table(rt, kTestEql, 0);
+
+  for (int64_t ind = 0; ind < GROWN_KEYS; ++ind) {
+    hash_table_put(rt, table, FROM_FIXNUM(ind * 7), FROM_FIXNUM(ind));
+  }
+  for (int64_t ind = 0; ind < GROWN_KEYS; ind += 2) {
+    hash_table_remove(rt, table, FROM_FIXNUM(ind * 7));
+  }
+
+  uint32_t wrong = 0;
+  for (int64_t ind = 0; ind < GROWN_KEYS; ++ind) {
+    LishpForm key = FROM_FIXNUM(ind * 7);
+    wrong += ind % 2 == 0 ? !missing_p(table, key) : !has_p(table, key, ind);
+  }
+  CHECK(wrong == 0, "growing: %u keys wrong after removing half", wrong);
+  CHECK(table->count == GROWN_KEYS / 2, "growing: count is %u", table->count);
+
+  // and put back, into the removed slots or not
+  for (int64_t ind = 0; ind < GROWN_KEYS; ind += 2) {
+    hash_table_put(rt, table, FROM_FIXNUM(ind * 7), FROM_FIXNUM(-ind));
+  }
+  wrong = 0;
+  for (int64_t ind = 0; ind < GROWN_KEYS; ++ind) {
+    wrong += !has_p(table, FROM_FIXNUM(ind * 7), ind % 2 == 0 ? -ind : ind);
+  }
+  CHECK(wrong == 0, "growing: %u keys wrong after putting them back", wrong);
+  CHECK(table->count == GROWN_KEYS, "growing: count is %u", table->count);
+}
+
+static void compaction_tests() {
+  Package *user = find_package(rt, "USER");
+  LishpSymbol *root_sym = intern_symbol(rt, user, "*HASH-TABLE-TESTS*");
+
+  // simple vectors and tables are never moved, so these pointers stay good
+  LishpSimpleVector *roots =
+      AS(LishpSimpleVector, make_vector(rt, kSimpleVector, 2, NIL));
+  bind_value(rt, user->global, root_sym, FROM_OBJ(roots));
+
+  LishpHashTable *table = make_hash_table(rt, kTestEq, 0);
+  roots->elements[0] = FROM_OBJ(table);
+  OBJ_WRITE_BARRIER(rt, roots, table);
+  LishpObject *keys = make_vector(rt, kSimpleVector, MOVED_KEYS, NIL);
+  roots->elements[1] = FROM_OBJ(keys);
+  OBJ_WRITE_BARRIER(rt, roots, keys);
+
+  // only the addresses, out of sight of the C stack, which would pin them
+  uintptr_t *addresses = malloc(MOVED_KEYS * sizeof(uintptr_t));
+  for (int64_t ind = 0; ind < MOVED_KEYS; ++ind) {
+    // garbage in between the keys leaves holes for them to move into
+    cons(NIL, NIL);
+    vector_set(rt, keys, ind, cons(FROM_FIXNUM(ind), NIL));
+
+    LishpForm key = vector_ref(rt, keys, ind);
+    addresses[ind] = (uintptr_t)key.object;
+    hash_table_put(rt, table, key, FROM_FIXNUM(ind));
+  }
+
+  uint64_t compactions = inspect_compactions(rt->memory_manager);
+  compact_garbage(rt->memory_manager);
+  CHECK(inspect_compactions(rt->memory_manager) != compactions,
+        "compaction: nothing was moved");
+
+  uint32_t moved = 0;
+  uint32_t lost = 0;
+  for (int64_t ind = 0; ind < MOVED_KEYS; ++ind) {
+    LishpForm key = vector_ref(rt, keys, ind);
+    moved += (uintptr_t)key.object != addresses[ind];
+    lost += !has_p(table, key, ind);
+  }
+  CHECK(moved > 0, "compaction: none of the keys moved");
+  CHECK(lost == 0, "compaction: %u keys lost, with %u of them moved", lost,
+        moved);
+  CHECK(missing_p(table, cons(FROM_FIXNUM(0), NIL)),
+        "compaction: found a new cons");
+
+  // the table still works for putting and removing, now it has rehashed
+  LishpForm first = vector_ref(rt, keys, 0);
+  CHECK(hash_table_remove(rt, table, first),
+        "compaction: removing a moved key failed");
+  CHECK(missing_p(table, first), "compaction: the removed key is still there");
+  hash_table_put(rt, table, first, FROM_FIXNUM(-1));
+  CHECK(has_p(table, first, -1), "compaction: putting a moved key back failed");
+  CHECK(table->count == MOVED_KEYS, "compaction: count is %u", table->count);
+
+  free(addresses);
+  bind_value(rt, user->global, root_sym, NIL);
+}
+
+void run_hash_table_tests(Runtime *runtime) {
+  rt = runtime;
+
+  pause_gc(rt->memory_manager);
+  eq_tests();
+  eql_tests();
+  equal_tests();
+  grow_tests();
+  resume_gc(rt->memory_manager);
+
+  compaction_tests();
+}
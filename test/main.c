@@ -0,0 +1,28 @@
+#include <stdio.h>
+
+#include "runtime.h"
+#include "test.h"
+
+uint32_t test_checks = 0;
+uint32_t test_failures = 0;
+
+static Runtime rt;
+
+int main() {
+  if (initialize_runtime(&rt) < 0) {
+    fprintf(stderr, "Couldn't initialize the runtime\n");
+    return 1;
+  }
+
+  run_memory_manager_tests(&rt);
+  run_number_tests(&rt);
+  run_float_tests(&rt);
+  run_array_tests(&rt);
+  run_vector_kernel_tests(&rt);
+  run_hash_table_tests(&rt);
+
+  cleanup_runtime(&rt);
+
+  printf("%u checks, %u failed\n", test_checks, test_failures);
+  return test_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,349 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "runtime.h"
+#include "runtime/memory_manager.h"
+#include "runtime/types.h"
+#include "test.h"
+
+// The collector against what it promises the runtime. Anything these hold on
+// to has to be reachable the way the runtime's own objects are, through a
+// global binding, since the C stack isn't a root. Memory that is wrongly
+// freed gets handed straight back out to the garbage allocated in between,
+// so it shows up as the wrong values rather than going unnoticed. Shapes the
+// runtime can't easily build get a manager of their own, with nodes that only
+// point at each other.
+
+// enough garbage conses to go through the nursery several times over
+#define CHURN_CONSES (1 << 18)
+#define BARRIER_LIST_LENGTH 1000
+// more roots than the mark stack holds, so that marking them overflows it
+#define WIDE_ROOTS ((1 << 20) + (1 << 18))
+
+// lists built a node at a time, round robin, with garbage in between, so
+// that there are holes for them to be compacted into
+#define COMPACTED_LISTS 64
+#define COMPACTED_LENGTH 512
+#define PINNED_EVERY 8
+
+// well over the size that gets a large block of its own
+#define LARGE_SIZE (64 << 10)
+
+typedef struct node {
+  struct node *child;
+  int64_t value;
+} Node;
+
+static Runtime *rt;
+static LishpSymbol *root_sym;
+
+static MemoryManager *manager;
+static Node **nodes;
+static uint32_t node_count;
+static char *large_root;
+
+static LishpCons *cons(LishpForm car, LishpForm cdr) {
+  LishpCons *result = ALLOCATE_OBJ(LishpCons, rt);
+  *result = CONS(car, cdr);
+  return result;
+}
+
+static void churn() {
+  for (uint32_t ind = 0; ind < CHURN_CONSES; ++ind) {
+    cons(FROM_FIXNUM(-1), NIL);
+  }
+}
+
+static void set_root(LishpForm form) {
+  Package *user = find_package(rt, "USER");
+  bind_value(rt, user->global, root_sym, form);
+}
+
+// a young list stored into an old cons is only reachable through the
+// remembered set once a minor collection comes around
+static void write_barrier_tests() {
+  LishpCons *holder = cons(NIL, NIL);
+  set_root(FROM_OBJ(holder));
+
+  // which promotes the holder
+  churn();
+
+  for (int64_t ind = 0; ind < BARRIER_LIST_LENGTH; ++ind) {
+    LishpCons *elt = cons(FROM_FIXNUM(ind), holder->car);
+    holder->car = FROM_OBJ(elt);
+    FORM_WRITE_BARRIER(rt, holder, holder->car);
+  }
+
+  churn();
+
+  int64_t expected = BARRIER_LIST_LENGTH - 1;
+  LishpForm cur = holder->car;
+  while (IS_OBJECT_TYPE(cur, kCons)) {
+    LishpCons *elt = AS_OBJECT(LishpCons, cur);
+    if (!FIXNUM_P(elt->car) || AS_FIXNUM(elt->car) != expected) {
+      break;
+    }
+    --expected;
+    cur = elt->cdr;
+  }
+  CHECK(expected == -1 && NIL_P(cur),
+        "write barrier: the list stored into an old cons broke off at %ld",
+        (long)expected);
+
+  set_root(NIL);
+}
+
+static void trace_node(struct runtime *rt, void *ptr) {
+  (void)rt;
+
+  Node *node = ptr;
+  if (node->child != NULL) {
+    mark_used(manager, node->child, trace_node);
+  }
+}
+
+static void mark_nodes(struct runtime *rt) {
+  (void)rt;
+
+  for (uint32_t ind = 0; ind < node_count; ++ind) {
+    mark_used(manager, nodes[ind], trace_node);
+  }
+}
+
+// the same as trace_node, but through mark_slot, so the child can be moved
+static void trace_movable_node(struct runtime *rt, void *ptr) {
+  (void)rt;
+
+  Node *node = ptr;
+  if (node->child != NULL) {
+    mark_slot(manager, (void **)&node->child, trace_movable_node);
+  }
+}
+
+// every few lists have their first node pinned
+static void mark_lists(struct runtime *rt) {
+  (void)rt;
+
+  for (uint32_t ind = 0; ind < node_count; ++ind) {
+    if (ind % PINNED_EVERY == 0) {
+      mark_used(manager, nodes[ind], trace_movable_node);
+    } else {
+      mark_slot(manager, (void **)&nodes[ind], trace_movable_node);
+    }
+  }
+}
+
+static void mark_large(struct runtime *rt) {
+  (void)rt;
+
+  if (large_root != NULL) {
+    mark_used(manager, large_root, NULL);
+  }
+}
+
+static Node *allocate_node(int64_t value) {
+  Node *node = allocate(manager, sizeof(Node));
+  if (node != NULL) {
+    node->child = NULL;
+    node->value = value;
+  }
+  return node;
+}
+
+// every root has a child, which only gets marked once the root comes back off
+// of the stack, long after the stack overflowed
+static void mark_stack_overflow_tests() {
+  ManagerSettings settings = DEFAULT_MANAGER_SETTINGS;
+  settings.nursery_size = 0;
+
+  nodes = malloc(WIDE_ROOTS * sizeof(Node *));
+  node_count = 0;
+  if (nodes == NULL ||
+      initialize_manager(&manager, mark_nodes, NULL, settings) < 0) {
+    CHECK(0, "overflow: couldn't set up a manager");
+    free(nodes);
+    return;
+  }
+
+  for (uint32_t ind = 0; ind < WIDE_ROOTS; ++ind) {
+    Node *root = allocate_node(ind);
+    if (root == NULL) {
+      break;
+    }
+    nodes[node_count++] = root;
+
+    root->child = allocate_node(~(int64_t)ind);
+    if (root->child == NULL) {
+      break;
+    }
+    write_barrier(manager, root, root->child, trace_node);
+  }
+  CHECK(node_count == WIDE_ROOTS, "overflow: only allocated %u roots",
+        node_count);
+
+  collect_garbage(manager);
+
+  // anything that was missed is free, and goes to these
+  for (uint32_t ind = 0; ind < 2 * node_count; ++ind) {
+    allocate_node(-1);
+  }
+
+  uint32_t wrong = 0;
+  for (uint32_t ind = 0; ind < node_count; ++ind) {
+    Node *root = nodes[ind];
+    wrong += root->value != ind || root->child == NULL ||
+             root->child->value != ~(int64_t)ind;
+  }
+  CHECK(wrong == 0, "overflow: %u of %u roots or their children were freed",
+        wrong, node_count);
+
+  cleanup_manager(&manager, NULL);
+  free(nodes);
+}
+
+static void compaction_tests() {
+  ManagerSettings settings = DEFAULT_MANAGER_SETTINGS;
+  settings.compact = 1;
+
+  // static, since the C stack would pin them
+  static Node *tails[COMPACTED_LISTS];
+  nodes = malloc(COMPACTED_LISTS * sizeof(Node *));
+  // only the addresses, out of sight of the C stack, which would pin them
+  uintptr_t *addresses =
+      malloc(COMPACTED_LISTS * COMPACTED_LENGTH * sizeof(uintptr_t));
+  node_count = 0;
+  if (nodes == NULL || addresses == NULL ||
+      initialize_manager(&manager, mark_lists, NULL, settings) < 0) {
+    CHECK(0, "compaction: couldn't set up a manager");
+    free(nodes);
+    free(addresses);
+    return;
+  }
+
+  for (uint32_t elem = 0; elem < COMPACTED_LENGTH; ++elem) {
+    for (uint32_t ind = 0; ind < COMPACTED_LISTS; ++ind) {
+      // the garbage goes first, since allocating it could collect a node that
+      // isn't linked in yet
+      allocate_node(-1);
+      Node *node = allocate_node(ind * COMPACTED_LENGTH + elem);
+      if (node == NULL) {
+        CHECK(0, "compaction: allocation failed");
+        cleanup_manager(&manager, NULL);
+        free(nodes);
+        free(addresses);
+        return;
+      }
+
+      if (elem == 0) {
+        nodes[node_count++] = node;
+      } else {
+        tails[ind]->child = node;
+        write_barrier(manager, tails[ind], node, trace_movable_node);
+      }
+      tails[ind] = node;
+      addresses[ind * COMPACTED_LENGTH + elem] = (uintptr_t)node;
+    }
+  }
+  GcStats before = inspect_gc_stats(manager);
+  compact_garbage(manager);
+  GcStats after = inspect_gc_stats(manager);
+  CHECK(after.cycles.compactions == before.cycles.compactions + 1,
+        "compaction: compact_garbage didn't compact");
+
+  // anything that was freed, or left behind by a move that should have been
+  // seen through, is overwritten
+  for (uint32_t ind = 0; ind < COMPACTED_LISTS * COMPACTED_LENGTH; ++ind) {
+    allocate_node(-1);
+  }
+
+  uint32_t wrong = 0;
+  uint32_t moved = 0;
+  uint32_t pinned_moved = 0;
+  for (uint32_t ind = 0; ind < COMPACTED_LISTS; ++ind) {
+    Node *cur = nodes[ind];
+    for (uint32_t elem = 0; elem < COMPACTED_LENGTH; ++elem) {
+      if (cur == NULL || cur->value != ind * COMPACTED_LENGTH + elem) {
+        ++wrong;
+        break;
+      }
+
+      uintptr_t address = addresses[ind * COMPACTED_LENGTH + elem];
+      int node_moved = (uintptr_t)cur != address;
+      moved += node_moved;
+      pinned_moved += node_moved && elem == 0 && ind % PINNED_EVERY == 0;
+      cur = cur->child;
+    }
+  }
+  CHECK(wrong == 0, "compaction: %u of the lists were broken", wrong);
+  CHECK(moved > 0, "compaction: nothing was moved");
+  CHECK(pinned_moved == 0, "compaction: %u pinned nodes were moved",
+        pinned_moved);
+
+  cleanup_manager(&manager, NULL);
+  free(nodes);
+  free(addresses);
+}
+
+// a large allocation that is dropped while it is still young has its block
+// unmapped by the next minor collection, without waiting for a full one
+static void large_object_tests() {
+  large_root = NULL;
+  if (initialize_manager(&manager, mark_large, NULL,
+                         DEFAULT_MANAGER_SETTINGS) < 0) {
+    CHECK(0, "large objects: couldn't set up a manager");
+    return;
+  }
+
+  large_root = allocate(manager, LARGE_SIZE);
+  char *dropped = allocate(manager, LARGE_SIZE);
+  if (large_root == NULL || dropped == NULL) {
+    CHECK(0, "large objects: allocation failed");
+    cleanup_manager(&manager, NULL);
+    return;
+  }
+  memset(large_root, 'L', LARGE_SIZE);
+  memset(dropped, 'D', LARGE_SIZE);
+  dropped = NULL;
+
+  GcStats before = inspect_gc_stats(manager);
+  CHECK(before.large_objects == 2, "large objects: %lu before collecting",
+        (unsigned long)before.large_objects);
+
+  // enough small garbage to go through the nursery twice
+  uint64_t nursery_size = DEFAULT_MANAGER_SETTINGS.nursery_size;
+  for (uint64_t bytes = 0; bytes < 2 * nursery_size; bytes += sizeof(Node)) {
+    allocate_node(-1);
+  }
+
+  GcStats after = inspect_gc_stats(manager);
+  CHECK(after.cycles.minor_collections > before.cycles.minor_collections &&
+            after.cycles.full_collections == before.cycles.full_collections,
+        "large objects: there wasn't just a minor collection");
+  CHECK(after.large_objects == 1, "large objects: %lu after collecting",
+        (unsigned long)after.large_objects);
+  CHECK(after.large_bytes < before.large_bytes &&
+            after.heap_size <= before.heap_size - LARGE_SIZE,
+        "large objects: the dropped one's block is still mapped");
+
+  uint32_t overwritten = 0;
+  for (uint32_t ind = 0; ind < LARGE_SIZE; ++ind) {
+    overwritten += large_root[ind] != 'L';
+  }
+  CHECK(overwritten == 0, "large objects: %u bytes of the live one changed",
+        overwritten);
+
+  cleanup_manager(&manager, NULL);
+  large_root = NULL;
+}
+
+void run_memory_manager_tests(Runtime *runtime) {
+  rt = runtime;
+
+  Package *user = find_package(rt, "USER");
+  root_sym = intern_symbol(rt, user, "*MEMORY-MANAGER-TESTS*");
+
+  write_barrier_tests();
+  mark_stack_overflow_tests();
+  compaction_tests();
+  large_object_tests();
+}
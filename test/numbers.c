@@ -0,0 +1,336 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "runtime.h"
+#include "runtime/memory_manager.h"
+#include "runtime/numbers.h"
+#include "runtime/types.h"
+#include "test.h"
+
+// Integer arithmetic against known values, around the edges of the fixnum
+// range and of a limb, and for products and quotients on either side of the
+// size where multiplication switches to Karatsuba. Then checks identities on
+// pseudo-random integers of every size up to a few times that, which catch
+// anything the known values miss. Nothing here is reachable by the collector,
+// so it is paused throughout.
+
+static Runtime *rt;
+
+#define INTEGER(text) parse_integer(rt, (text), strlen(text))
+
+// the integer in decimal, which the caller frees
+static char *integer_text(LishpForm f) {
+  char *text;
+  size_t length;
+  FILE *out = open_memstream(&text, &length);
+
+  if (FIXNUM_P(f)) {
+    fprintf(out, "%ld", (long)AS_FIXNUM(f));
+  } else {
+    print_bignum(AS_OBJECT(LishpBignum, f), out);
+  }
+
+  fclose(out);
+  return text;
+}
+
+// whether expected is in the fixnum range, which is the only place a result
+// may be a fixnum
+static int fixnum_text_p(const char *expected) {
+  errno = 0;
+  long long value = strtoll(expected, NULL, 10);
+  return errno == 0 && value >= MOST_NEGATIVE_FIXNUM &&
+         value <= MOST_POSITIVE_FIXNUM;
+}
+
+#define CHECK_INTEGER(form, expected)                                          \
+  do {                                                                         \
+    LishpForm _result = (form);                                                \
+    char *_text = integer_text(_result);                                       \
+    CHECK(strcmp(_text, (expected)) == 0, "%s is %.60s, expected %.60s",       \
+          #form, _text, (expected));                                           \
+    CHECK(FIXNUM_P(_result) == fixnum_text_p(expected),                        \
+          "%s is a %s", #form, FIXNUM_P(_result) ? "fixnum" : "bignum");       \
+    free(_text);                                                               \
+  } while (0)
+
+// the digits of 10^n + offset, for an offset of -1, 0 or 1, which the caller
+// frees
+static char *power_of_ten_text(uint32_t n, int offset) {
+  char *text = malloc(n + 2);
+
+  if (offset < 0) {
+    memset(text, '9', n);
+    text[n] = '\0';
+  } else {
+    text[0] = '1';
+    memset(text + 1, '0', n);
+    text[n] = offset > 0 ? '1' : '0';
+    text[n + 1] = '\0';
+  }
+
+  return text;
+}
+
+static LishpForm power_of_ten(uint32_t n, int offset) {
+  char *text = power_of_ten_text(n, offset);
+  LishpForm result = INTEGER(text);
+  free(text);
+  return result;
+}
+
+// the digits of a string of runs, each run a digit repeated count times
+static char *runs_text(const char *digits, const uint32_t *counts,
+                       uint32_t run_count) {
+  uint32_t length = 0;
+  for (uint32_t ind = 0; ind < run_count; ++ind) {
+    length += counts[ind];
+  }
+
+  char *text = malloc(length + 1);
+  char *cur = text;
+  for (uint32_t ind = 0; ind < run_count; ++ind) {
+    memset(cur, digits[ind], counts[ind]);
+    cur += counts[ind];
+  }
+  *cur = '\0';
+
+  return text;
+}
+
+static void fixnum_boundary_tests() {
+  LishpForm most_positive = FROM_FIXNUM(MOST_POSITIVE_FIXNUM);
+  LishpForm most_negative = FROM_FIXNUM(MOST_NEGATIVE_FIXNUM);
+
+  CHECK_INTEGER(integer_add(rt, most_positive, FROM_FIXNUM(1)),
+                "2305843009213693952");
+  CHECK_INTEGER(integer_subtract(rt, INTEGER("2305843009213693952"),
+                                 FROM_FIXNUM(1)),
+                "2305843009213693951");
+  CHECK_INTEGER(integer_add(rt, most_negative, FROM_FIXNUM(-1)),
+                "-2305843009213693953");
+  CHECK_INTEGER(integer_subtract(rt, most_negative, FROM_FIXNUM(1)),
+                "-2305843009213693953");
+  CHECK_INTEGER(integer_add(rt, INTEGER("-2305843009213693953"),
+                            FROM_FIXNUM(1)),
+                "-2305843009213693952");
+  CHECK_INTEGER(integer_negate(rt, most_negative), "2305843009213693952");
+  CHECK_INTEGER(integer_negate(rt, INTEGER("2305843009213693952")),
+                "-2305843009213693952");
+  CHECK_INTEGER(integer_add(rt, INTEGER("2305843009213693952"),
+                            INTEGER("-2305843009213693952")),
+                "0");
+
+  CHECK_INTEGER(integer_multiply(rt, most_positive, most_positive),
+                "5316911983139663487003542222693990401");
+  CHECK_INTEGER(integer_multiply(rt, FROM_FIXNUM((int64_t)1 << 32),
+                                 FROM_FIXNUM((int64_t)1 << 28)),
+                "1152921504606846976");
+  CHECK_INTEGER(integer_multiply(rt, FROM_FIXNUM((int64_t)1 << 32),
+                                 FROM_FIXNUM((int64_t)1 << 29)),
+                "2305843009213693952");
+  CHECK_INTEGER(integer_multiply(rt, FROM_FIXNUM(-((int64_t)1 << 31)),
+                                 FROM_FIXNUM((int64_t)1 << 30)),
+                "-2305843009213693952");
+  CHECK_INTEGER(integer_multiply(rt, FROM_FIXNUM(-((int64_t)1 << 31)),
+                                 FROM_FIXNUM(-((int64_t)1 << 30))),
+                "2305843009213693952");
+
+  CHECK_INTEGER(integer_floor(rt, most_negative, FROM_FIXNUM(-1)),
+                "2305843009213693952");
+  CHECK_INTEGER(integer_mod(rt, most_negative, FROM_FIXNUM(-1)), "0");
+  CHECK_INTEGER(integer_floor(rt,
+                              INTEGER("5316911983139663491615228241121378304"),
+                              INTEGER("2305843009213693952")),
+                "2305843009213693952");
+  CHECK_INTEGER(integer_floor(rt, INTEGER("2305843009213693952"),
+                              FROM_FIXNUM(2)),
+                "1152921504606846976");
+
+  CHECK_INTEGER(integer_floor(rt, FROM_FIXNUM(-7), FROM_FIXNUM(2)), "-4");
+  CHECK_INTEGER(integer_mod(rt, FROM_FIXNUM(-7), FROM_FIXNUM(2)), "1");
+  CHECK_INTEGER(integer_floor(rt, FROM_FIXNUM(7), FROM_FIXNUM(-2)), "-4");
+  CHECK_INTEGER(integer_mod(rt, FROM_FIXNUM(7), FROM_FIXNUM(-2)), "-1");
+  CHECK_INTEGER(integer_floor(rt, FROM_FIXNUM(-7), FROM_FIXNUM(-2)), "3");
+  CHECK_INTEGER(integer_mod(rt, FROM_FIXNUM(-7), FROM_FIXNUM(-2)), "-1");
+}
+
+static void limb_boundary_tests() {
+  LishpForm two_32 = FROM_FIXNUM((int64_t)1 << 32);
+
+  CHECK_INTEGER(integer_multiply(rt, two_32, two_32), "18446744073709551616");
+  CHECK_INTEGER(integer_add(rt, INTEGER("18446744073709551615"),
+                            FROM_FIXNUM(1)),
+                "18446744073709551616");
+  CHECK_INTEGER(integer_subtract(rt, INTEGER("18446744073709551616"),
+                                 FROM_FIXNUM(1)),
+                "18446744073709551615");
+  CHECK_INTEGER(integer_subtract(rt, INTEGER("18446744073709551616"),
+                                 INTEGER("18446744073709551615")),
+                "1");
+  CHECK_INTEGER(integer_subtract(rt, INTEGER("18446744073709551615"),
+                                 INTEGER("18446744073709551616")),
+                "-1");
+  LishpForm two_128 = INTEGER("340282366920938463463374607431768211456");
+  CHECK_INTEGER(integer_subtract(rt, two_128, FROM_FIXNUM(1)),
+                "340282366920938463463374607431768211455");
+  CHECK_INTEGER(integer_add(rt, integer_negate(rt, two_128),
+                            INTEGER("340282366920938463463374607431768211455")),
+                "-1");
+
+  // a single limb divisor
+  LishpForm ten_40 = INTEGER("10000000000000000000000000000000000000000");
+  LishpForm minus_ten_40 = integer_negate(rt, ten_40);
+  CHECK_INTEGER(integer_floor(rt, ten_40, FROM_FIXNUM(3)),
+                "3333333333333333333333333333333333333333");
+  CHECK_INTEGER(integer_mod(rt, ten_40, FROM_FIXNUM(3)), "1");
+  CHECK_INTEGER(integer_floor(rt, minus_ten_40, FROM_FIXNUM(3)),
+                "-3333333333333333333333333333333333333334");
+  CHECK_INTEGER(integer_mod(rt, minus_ten_40, FROM_FIXNUM(3)), "2");
+  CHECK_INTEGER(integer_floor(rt, ten_40, FROM_FIXNUM(-3)),
+                "-3333333333333333333333333333333333333334");
+  CHECK_INTEGER(integer_mod(rt, ten_40, FROM_FIXNUM(-3)), "-2");
+
+  // a divisor of two limbs, which goes through the long division
+  LishpForm n = integer_add(rt, power_of_ten(60, 0), FROM_FIXNUM(12345));
+  LishpForm minus_n = integer_negate(rt, n);
+  LishpForm d = INTEGER("10000000000000000000000007");
+  LishpForm minus_d = integer_negate(rt, d);
+  CHECK_INTEGER(integer_floor(rt, n, d), "99999999999999999999999930000000000");
+  CHECK_INTEGER(integer_mod(rt, n, d), "490000012345");
+  CHECK_INTEGER(integer_floor(rt, minus_n, d),
+                "-99999999999999999999999930000000001");
+  CHECK_INTEGER(integer_mod(rt, minus_n, d), "9999999999999509999987662");
+  CHECK_INTEGER(integer_floor(rt, n, minus_d),
+                "-99999999999999999999999930000000001");
+  CHECK_INTEGER(integer_mod(rt, n, minus_d), "-9999999999999509999987662");
+  CHECK_INTEGER(integer_floor(rt, minus_n, minus_d),
+                "99999999999999999999999930000000000");
+  CHECK_INTEGER(integer_mod(rt, minus_n, minus_d), "-490000012345");
+}
+
+// 10^590 is 31 limbs, 10^600 is 32, right at the cutoff, 10^620 is 33 and
+// 10^1300 is 68, deep enough that Karatsuba splits more than once
+static void karatsuba_tests() {
+  static const uint32_t powers[] = {590, 600, 620, 1300};
+
+  for (uint32_t ind = 0; ind < sizeof(powers) / sizeof(powers[0]); ++ind) {
+    uint32_t n = powers[ind];
+    LishpForm plus_one = power_of_ten(n, 1);
+    LishpForm minus_one = power_of_ten(n, -1);
+
+    char *plus_one_text = power_of_ten_text(n, 1);
+
+    // (10^n + 1)(10^n - 1) = 10^2n - 1
+    char *nines = power_of_ten_text(2 * n, -1);
+    CHECK_INTEGER(integer_multiply(rt, plus_one, minus_one), nines);
+    CHECK_INTEGER(integer_floor(rt, INTEGER(nines), minus_one), plus_one_text);
+    CHECK_INTEGER(integer_mod(rt, INTEGER(nines), minus_one), "0");
+    free(nines);
+
+    // (10^n + 1)^2 = 10^2n + 2 10^n + 1
+    uint32_t square_counts[] = {1, n - 1, 1, n - 1, 1};
+    char *square = runs_text("10201", square_counts, 5);
+    CHECK_INTEGER(integer_multiply(rt, plus_one, plus_one), square);
+    CHECK_INTEGER(integer_floor(rt, INTEGER(square), plus_one), plus_one_text);
+    CHECK_INTEGER(integer_mod(rt, INTEGER(square), plus_one), "0");
+    free(square);
+
+    // 10^2n = (10^n + 1)(10^n - 1) + 1, so -10^2n leaves 10^n - 2
+    LishpForm ten_2n = power_of_ten(2 * n, 0);
+    uint32_t less_two_counts[] = {n - 1, 1};
+    char *less_two = runs_text("98", less_two_counts, 2);
+    CHECK_INTEGER(integer_floor(rt, ten_2n, minus_one), plus_one_text);
+    CHECK_INTEGER(integer_mod(rt, ten_2n, minus_one), "1");
+    CHECK_INTEGER(integer_mod(rt, integer_negate(rt, ten_2n), minus_one),
+                  less_two);
+    free(less_two);
+
+    free(plus_one_text);
+  }
+
+  // too lopsided to split down the middle, (10^1300 + 1)(10^600 - 1) is 600
+  // nines, 700 zeros and 600 nines
+  uint32_t lopsided_counts[] = {600, 700, 600};
+  char *lopsided = runs_text("909", lopsided_counts, 3);
+  CHECK_INTEGER(integer_multiply(rt, power_of_ten(1300, 1),
+                                 power_of_ten(600, -1)),
+                lopsided);
+  free(lopsided);
+}
+
+// a pseudo-random integer of digit_count digits and either sign
+static LishpForm random_integer(uint32_t *seed, uint32_t digit_count) {
+  char *text = malloc(digit_count + 2);
+  char *cur = text;
+
+  *seed = *seed * 1103515245 + 12345;
+  if ((*seed >> 16) & 1) {
+    *cur++ = '-';
+  }
+  for (uint32_t ind = 0; ind < digit_count; ++ind) {
+    *seed = *seed * 1103515245 + 12345;
+    *cur++ = '0' + (*seed >> 16) % 10;
+  }
+  *cur = '\0';
+
+  LishpForm result = INTEGER(text);
+  free(text);
+  return result;
+}
+
+static int zero_p(LishpForm f) { return FIXNUM_P(f) && AS_FIXNUM(f) == 0; }
+
+static int negative_p(LishpForm f) {
+  return FIXNUM_P(f) ? AS_FIXNUM(f) < 0 : AS_OBJECT(LishpBignum, f)->negative;
+}
+
+// (a + b)(a - b) = a^2 - b^2 mixes products of every size, and floor and mod
+// have to put a back together, with a remainder smaller than the divisor and
+// of its sign
+static void identity_tests() {
+  uint32_t seed = 42;
+
+  for (uint32_t digits = 1; digits <= 3000; digits += 97) {
+    LishpForm a = random_integer(&seed, digits);
+    LishpForm b = random_integer(&seed, 1 + (digits * 7 + 13) % 1500);
+
+    LishpForm product = integer_multiply(rt, integer_add(rt, a, b),
+                                         integer_subtract(rt, a, b));
+    LishpForm squares = integer_subtract(rt, integer_multiply(rt, a, a),
+                                         integer_multiply(rt, b, b));
+    CHECK(zero_p(integer_subtract(rt, product, squares)),
+          "(a + b)(a - b) != a^2 - b^2 for %u and %u digit integers", digits,
+          1 + (digits * 7 + 13) % 1500);
+
+    if (zero_p(b)) {
+      continue;
+    }
+
+    LishpForm quotient = integer_floor(rt, a, b);
+    LishpForm remainder = integer_mod(rt, a, b);
+    LishpForm rebuilt =
+        integer_add(rt, integer_multiply(rt, quotient, b), remainder);
+    CHECK(zero_p(integer_subtract(rt, rebuilt, a)),
+          "floor and mod don't add back up for %u digits", digits);
+
+    LishpForm past = integer_subtract(rt, remainder, b);
+    CHECK(zero_p(remainder) || (negative_p(remainder) == negative_p(b) &&
+                                negative_p(past) != negative_p(b)),
+          "mod is out of range for %u digits", digits);
+  }
+}
+
+void run_number_tests(Runtime *runtime) {
+  rt = runtime;
+
+  pause_gc(rt->memory_manager);
+  fixnum_boundary_tests();
+  limb_boundary_tests();
+  karatsuba_tests();
+  identity_tests();
+  resume_gc(rt->memory_manager);
+}
@@ -0,0 +1,35 @@
+#ifndef test_test_
+#define test_test_
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "runtime.h"
+
+// `make test` builds every file in test/ along with the runtime into one
+// binary. Each file has a run_*_tests that main calls with the runtime they
+// all share. A failed CHECK is reported and counted, and the tests carry on,
+// so that a run shows everything that's wrong at once.
+
+extern uint32_t test_checks;
+extern uint32_t test_failures;
+
+#define CHECK(cond, ...)                                                       \
+  do {                                                                         \
+    ++test_checks;                                                             \
+    if (!(cond)) {                                                             \
+      ++test_failures;                                                         \
+      fprintf(stderr, "%s:%d: failed: ", __FILE__, __LINE__);                  \
+      fprintf(stderr, __VA_ARGS__);                                            \
+      fprintf(stderr, "\n");                                                   \
+    }                                                                          \
+  } while (0)
+
+void run_memory_manager_tests(Runtime *rt);
+void run_number_tests(Runtime *rt);
+void run_float_tests(Runtime *rt);
+void run_array_tests(Runtime *rt);
+void run_vector_kernel_tests(Runtime *rt);
+void run_hash_table_tests(Runtime *rt);
+
+#endif
@@ -0,0 +1,190 @@
+#include <string.h>
+
+#include "runtime.h"
+#include "runtime/types.h"
+#include "runtime/vector_kernels.h"
+#include "test.h"
+
+// Every kernel set the CPU supports against the scalar one, at every length
+// up to a couple of the widest registers plus one, so that each lane and
+// each length of tail gets a turn. The doubles are all small whole numbers,
+// so that their sums come out the same in whatever order they are added.
+// Overflow and the extremes of min and max are tried at each position in
+// turn, at the edges of the fixnum range.
+
+#define MAX_LENGTH 17
+
+static const VectorKernels *scalar;
+
+static int64_t small_fixnum(uint32_t ind, uint32_t salt) {
+  return (int64_t)((ind * 2654435761u + salt * 40503u) % 1001) - 500;
+}
+
+static void fill_inputs(int64_t *fixnums, double *doubles, uint32_t salt) {
+  for (uint32_t ind = 0; ind < MAX_LENGTH; ++ind) {
+    fixnums[ind] = small_fixnum(ind, salt);
+    doubles[ind] = (double)small_fixnum(ind, salt);
+  }
+}
+
+static void double_tests(const VectorKernels *kernels, uint32_t n) {
+  int64_t unused[MAX_LENGTH];
+  double x[MAX_LENGTH], y[MAX_LENGTH];
+  fill_inputs(unused, x, 1);
+  fill_inputs(unused, y, 2);
+
+  CHECK(kernels->sum_doubles(x, n) == scalar->sum_doubles(x, n),
+        "%s: sum_doubles of %u", kernels->name, n);
+  CHECK(kernels->dot_doubles(x, y, n) == scalar->dot_doubles(x, y, n),
+        "%s: dot_doubles of %u", kernels->name, n);
+
+  double out[MAX_LENGTH], expected[MAX_LENGTH];
+  kernels->add_doubles(out, x, y, n);
+  scalar->add_doubles(expected, x, y, n);
+  CHECK(memcmp(out, expected, n * sizeof(double)) == 0,
+        "%s: add_doubles of %u", kernels->name, n);
+
+  kernels->multiply_doubles(out, x, y, n);
+  scalar->multiply_doubles(expected, x, y, n);
+  CHECK(memcmp(out, expected, n * sizeof(double)) == 0,
+        "%s: multiply_doubles of %u", kernels->name, n);
+
+  // an extreme at each position, so that it's found whichever lane, or the
+  // tail, it is in
+  for (uint32_t at = 0; at < n; ++at) {
+    for (int sign = -1; sign <= 1; sign += 2) {
+      double saved = x[at];
+      x[at] = sign * 1e6;
+
+      double min, max, expected_min, expected_max;
+      kernels->min_max_doubles(x, n, &min, &max);
+      scalar->min_max_doubles(x, n, &expected_min, &expected_max);
+      CHECK(min == expected_min && max == expected_max &&
+                (sign < 0 ? min : max) == sign * 1e6,
+            "%s: min_max_doubles of %u with %g at %u is %g and %g",
+            kernels->name, n, sign * 1e6, at, min, max);
+
+      x[at] = saved;
+    }
+  }
+}
+
+// the sum of n copies of value
+static void check_fixnum_sum(const VectorKernels *kernels, uint32_t n,
+                             int64_t value) {
+  int64_t x[MAX_LENGTH];
+  for (uint32_t ind = 0; ind < n; ++ind) {
+    x[ind] = value;
+  }
+
+  __int128 sum = kernels->sum_fixnums(x, n);
+  CHECK(sum == scalar->sum_fixnums(x, n) && sum == (__int128)value * n,
+        "%s: sum_fixnums of %u copies of %ld", kernels->name, n, (long)value);
+}
+
+// x[at] + y[at] is the only sum that can be out of range
+static void check_fixnum_add(const VectorKernels *kernels, uint32_t n,
+                             uint32_t at, int64_t l, int64_t r) {
+  int64_t x[MAX_LENGTH], y[MAX_LENGTH];
+  double unused[MAX_LENGTH];
+  fill_inputs(x, unused, 3);
+  fill_inputs(y, unused, 4);
+  x[at] = l;
+  y[at] = r;
+
+  int64_t out[MAX_LENGTH], expected[MAX_LENGTH];
+  int result = kernels->add_fixnums(out, x, y, n);
+  int expected_result = scalar->add_fixnums(expected, x, y, n);
+
+  int64_t sum = l + r;
+  int fits = MOST_NEGATIVE_FIXNUM <= sum && sum <= MOST_POSITIVE_FIXNUM;
+  CHECK(result == expected_result && result == (fits ? 0 : -1),
+        "%s: add_fixnums of %u with %ld + %ld at %u returned %d",
+        kernels->name, n, (long)l, (long)r, at, result);
+  CHECK(!fits || memcmp(out, expected, n * sizeof(int64_t)) == 0,
+        "%s: add_fixnums of %u with %ld + %ld at %u", kernels->name, n,
+        (long)l, (long)r, at);
+}
+
+static void fixnum_tests(const VectorKernels *kernels, uint32_t n) {
+  int64_t x[MAX_LENGTH], y[MAX_LENGTH];
+  double unused[MAX_LENGTH];
+  fill_inputs(x, unused, 5);
+  fill_inputs(y, unused, 6);
+
+  CHECK(kernels->sum_fixnums(x, n) == scalar->sum_fixnums(x, n),
+        "%s: sum_fixnums of %u", kernels->name, n);
+  check_fixnum_sum(kernels, n, MOST_POSITIVE_FIXNUM);
+  check_fixnum_sum(kernels, n, MOST_NEGATIVE_FIXNUM);
+
+  int64_t out[MAX_LENGTH], expected[MAX_LENGTH];
+  int result = kernels->multiply_fixnums(out, x, y, n);
+  CHECK(result == scalar->multiply_fixnums(expected, x, y, n) &&
+            memcmp(out, expected, n * sizeof(int64_t)) == 0,
+        "%s: multiply_fixnums of %u", kernels->name, n);
+
+  for (uint32_t at = 0; at < n; ++at) {
+    // right at the edges, and one past them
+    check_fixnum_add(kernels, n, at, MOST_POSITIVE_FIXNUM, 0);
+    check_fixnum_add(kernels, n, at, MOST_POSITIVE_FIXNUM, 1);
+    check_fixnum_add(kernels, n, at, MOST_POSITIVE_FIXNUM - 1, 1);
+    check_fixnum_add(kernels, n, at, MOST_NEGATIVE_FIXNUM, 0);
+    check_fixnum_add(kernels, n, at, MOST_NEGATIVE_FIXNUM, -1);
+    check_fixnum_add(kernels, n, at, MOST_NEGATIVE_FIXNUM + 1, -1);
+    check_fixnum_add(kernels, n, at, MOST_POSITIVE_FIXNUM,
+                     MOST_POSITIVE_FIXNUM);
+    check_fixnum_add(kernels, n, at, MOST_NEGATIVE_FIXNUM,
+                     MOST_NEGATIVE_FIXNUM);
+
+    // both extremes at once, which only a signed compare tells apart
+    for (int64_t sign = -1; sign <= 1; sign += 2) {
+      int64_t saved = x[at];
+      int64_t extreme = sign < 0 ? MOST_NEGATIVE_FIXNUM : MOST_POSITIVE_FIXNUM;
+      x[at] = extreme;
+
+      int64_t min, max, expected_min, expected_max;
+      kernels->min_max_fixnums(x, n, &min, &max);
+      scalar->min_max_fixnums(x, n, &expected_min, &expected_max);
+      CHECK(min == expected_min && max == expected_max &&
+                (sign < 0 ? min : max) == extreme,
+            "%s: min_max_fixnums of %u with %ld at %u is %ld and %ld",
+            kernels->name, n, (long)extreme, at, (long)min, (long)max);
+
+      x[at] = saved;
+    }
+  }
+}
+
+// nothing past the n words is touched
+static void fill_tests(const VectorKernels *kernels, uint32_t n) {
+  uint64_t out[MAX_LENGTH + 1];
+  memset(out, 0, sizeof(out));
+  kernels->fill_words(out, n, 0x0123456789abcdefu);
+
+  uint32_t wrong = 0;
+  for (uint32_t ind = 0; ind <= MAX_LENGTH; ++ind) {
+    wrong += out[ind] != (ind < n ? 0x0123456789abcdefu : 0);
+  }
+  CHECK(wrong == 0, "%s: fill_words of %u got %u words wrong", kernels->name,
+        n, wrong);
+}
+
+void run_vector_kernel_tests(Runtime *rt) {
+  (void)rt;
+
+  scalar = vector_kernels(kIsaScalar);
+
+  for (int isa = kIsaScalar; isa < VECTOR_ISA_COUNT; ++isa) {
+    const VectorKernels *kernels = vector_kernels(isa);
+    if (kernels == NULL) {
+      continue;
+    }
+
+    // min and max need at least one element, so they only start at one
+    for (uint32_t n = 0; n <= MAX_LENGTH; ++n) {
+      double_tests(kernels, n);
+      fixnum_tests(kernels, n);
+      fill_tests(kernels, n);
+    }
+  }
+}